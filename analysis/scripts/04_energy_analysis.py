@@ -1,6 +1,10 @@
 """
 Energy Analysis Script  
 Calculates cumulative energy and validates against target
+
+Uses the C++ trace store through the power_model extension when it is
+importable (build with -DPOWER_MODEL_PYTHON=ON and put the build directory
+on PYTHONPATH); otherwise falls back to pandas on the cleaned data.
 """
 
 import pandas as pd
@@ -8,9 +12,26 @@ import numpy as np
 from pathlib import Path
 import sys
 
+try:
+    import power_model
+except ImportError:
+    power_model = None
+
 # Paths
+DATA_DIR = Path("../data") if Path("../data").exists() else Path("data")
 OUTPUT_DIR = Path("../output") if Path("../output").exists() else Path("output")
 DATA_PATH = OUTPUT_DIR / "reports" / "cleaned_data.csv"
+MEASUREMENT_PATH = DATA_DIR / "DVConChallengeLongTimeMeasurement_States.csv"
+
+# Status names by state id, as the C++ trace reader maps them
+STATUS_NAMES = np.array([
+    "At Work (In the Office)",
+    "Not at Work",
+    "At Work (Not in the office)",
+    "At Work (In the Office) Bluetooth",
+    "At Work (Not in the office) Bluetooth",
+    "Not at Work Bluetooth",
+])
 
 def analyze_energy(df):
     """Calculate and analyze energy consumption"""
@@ -55,7 +76,71 @@ def analyze_energy(df):
     
     return df
 
+def analyze_energy_native(store):
+    """Same analysis on the C++ trace store; columns are zero-copy views"""
+    print("=" * 60)
+    print("ENERGY ANALYSIS (power_model)")
+    print("=" * 60)
+    
+    # Sample i covers one period, so the cleaned data's TimeSeconds is the
+    # end of the sample and the cumulative energy is the prefix after it
+    time_seconds = np.asarray(store.timestamps) + store.sample_period
+    cumulative_energy = np.asarray(store.energy_prefix)[1:]
+    states = np.asarray(store.states)
+    
+    stats = store.query(0, store.duration)
+    total_energy = stats['energy']
+    duration = stats['to'] - stats['from']
+    avg_power = total_energy / duration
+    
+    print(f"\n--- Energy Summary ---")
+    print(f"Total Energy: {total_energy:.2f} Joules")
+    print(f"Duration: {duration} seconds ({duration/60:.1f} minutes)")
+    print(f"Average Power: {avg_power:.4f} Watts")
+    
+    # Energy by state
+    print("\n--- Energy Contribution by State ---")
+    present = np.nonzero(np.asarray(stats['state_runs']))[0]
+    energy_by_state = pd.DataFrame({
+        'Energy_J': np.asarray(stats['state_energy'])[present],
+        'Duration_s': np.asarray(stats['state_duration'])[present],
+    }, index=pd.Index(STATUS_NAMES[present], name='Status'))
+    energy_by_state['Percentage'] = (energy_by_state['Energy_J'] / total_energy * 100)
+    energy_by_state = energy_by_state.sort_values('Energy_J', ascending=False)
+    
+    print(energy_by_state.round(2).to_string())
+    
+    # Save
+    output_path = OUTPUT_DIR / "reports" / "energy_analysis.csv"
+    energy_by_state.to_csv(output_path)
+    print(f"\n✓ Energy analysis saved to: {output_path}")
+    
+    # Save time series
+    timeseries_path = OUTPUT_DIR / "reports" / "energy_timeseries.csv"
+    pd.DataFrame({
+        'TimeSeconds': time_seconds,
+        'Power [W]': np.asarray(store.power),
+        'CumulativeEnergy': cumulative_energy,
+        'Status': STATUS_NAMES[states],
+    }).to_csv(timeseries_path, index=False)
+    print(f"✓ Energy time series saved to: {timeseries_path}")
+    
+    # Model check against the measurement
+    report = power_model.validate(store)
+    print(f"\n--- Model Validation ---")
+    print(f"Model Energy: {report['model']['energy']:.2f} Joules")
+    print(f"Error: {report['error_percent']:.4f}% "
+          f"({'PASS' if report['passed'] else 'FAIL'})")
+
 if __name__ == "__main__":
+    if power_model is not None:
+        OUTPUT_DIR.joinpath("reports").mkdir(parents=True, exist_ok=True)
+        analyze_energy_native(power_model.TraceStore(str(MEASUREMENT_PATH)))
+        print("\n" + "=" * 60)
+        print("ENERGY ANALYSIS COMPLETE")
+        print("=" * 60)
+        sys.exit(0)
+    
     if not DATA_PATH.exists():
         print(f"Error: Run 01_data_exploration.py first!")
         sys.exit(1)
@@ -0,0 +1,49 @@
+# check_timeseries_states.cmake
+#
+# Checks the per-state columns of a --timeseries CSV of the built-in model:
+# a state active in a window averages exactly its table power over its own
+# time in that window, and an inactive one prints nan. Requires at least one
+# window in which several states share the time.
+#
+#   cmake -DTIMESERIES=<energy.csv> -DPOWERS=<W;W;...> -P check_timeseries_states.cmake
+
+if(NOT DEFINED TIMESERIES OR NOT DEFINED POWERS)
+    message(FATAL_ERROR "usage: cmake -DTIMESERIES=<csv> -DPOWERS=<W;...> -P ${CMAKE_CURRENT_LIST_FILE}")
+endif()
+
+list(LENGTH POWERS state_count)
+math(EXPR last_state "${state_count} - 1")
+math(EXPR duration_base "6 + ${state_count}")
+math(EXPR average_base "6 + 2 * ${state_count}")
+
+file(STRINGS "${TIMESERIES}" rows)
+list(REMOVE_AT rows 0)  # header
+set(shared 0)
+foreach(row IN LISTS rows)
+    string(REPLACE "," ";" fields "${row}")
+    set(active 0)
+    foreach(s RANGE ${last_state})
+        math(EXPR duration_field "${duration_base} + ${s}")
+        math(EXPR average_field "${average_base} + ${s}")
+        list(GET fields ${duration_field} duration)
+        list(GET fields ${average_field} average)
+        list(GET POWERS ${s} power)
+        if(duration STREQUAL "0.000000")
+            if(NOT average STREQUAL "nan")
+                message(FATAL_ERROR "state ${s} is not active but averages ${average} W in: ${row}")
+            endif()
+        else()
+            math(EXPR active "${active} + 1")
+            if(NOT average STREQUAL power)
+                message(FATAL_ERROR "state ${s} averages ${average} W, its power is ${power} W, in: ${row}")
+            endif()
+        endif()
+    endforeach()
+    if(active GREATER 1)
+        math(EXPR shared "${shared} + 1")
+    endif()
+endforeach()
+if(shared EQUAL 0)
+    message(FATAL_ERROR "${TIMESERIES} has no window shared by several states")
+endif()
+message(STATUS "${TIMESERIES}: state averages match the table in ${shared} shared windows")
@@ -0,0 +1,64 @@
+# check_timeseries_total.cmake
+#
+# Checks that the last Cumulative_Energy_J of every window length in a
+# --timeseries CSV equals the model total energy of the JSON Lines report
+# written by the same run, to the series' six decimals.
+#
+#   cmake -DTIMESERIES=<energy.csv> -DREPORT=<validation.jsonl> -P check_timeseries_total.cmake
+
+if(NOT DEFINED TIMESERIES OR NOT DEFINED REPORT)
+    message(FATAL_ERROR "usage: cmake -DTIMESERIES=<csv> -DREPORT=<jsonl> -P ${CMAKE_CURRENT_LIST_FILE}")
+endif()
+
+# Converts a non-negative decimal such as "4262.8953000000001" to integer
+# micro-units, rounded half up.
+function(to_micro text out)
+    if(NOT text MATCHES "^([0-9]+)(\\.([0-9]*))?$")
+        message(FATAL_ERROR "cannot compare energy '${text}'")
+    endif()
+    set(whole "${CMAKE_MATCH_1}")
+    string(SUBSTRING "${CMAKE_MATCH_3}0000000" 0 7 fraction)
+    string(SUBSTRING "${fraction}" 6 1 round)
+    string(SUBSTRING "${fraction}" 0 6 fraction)
+    string(REGEX REPLACE "^0+([0-9])" "\\1" fraction "${fraction}")
+    math(EXPR value "${whole} * 1000000 + ${fraction}")
+    if(round GREATER_EQUAL 5)
+        math(EXPR value "${value} + 1")
+    endif()
+    set(${out} ${value} PARENT_SCOPE)
+endfunction()
+
+file(STRINGS "${REPORT}" total_line REGEX "\"metric\":\"Total Energy \\(J\\)\"")
+if(NOT total_line MATCHES "\"model\":([0-9.]+)")
+    message(FATAL_ERROR "${REPORT} has no model total energy")
+endif()
+set(total "${CMAKE_MATCH_1}")
+to_micro("${total}" expected)
+
+file(STRINGS "${TIMESERIES}" rows)
+list(REMOVE_AT rows 0)  # header
+set(windows "")
+foreach(row IN LISTS rows)
+    string(REPLACE "," ";" fields "${row}")
+    list(GET fields 0 window)
+    list(GET fields 5 cumulative)
+    string(MAKE_C_IDENTIFIER "${window}" key)
+    if(NOT DEFINED last_${key})
+        list(APPEND windows "${window}")
+    endif()
+    set(last_${key} "${cumulative}")
+endforeach()
+if(NOT windows)
+    message(FATAL_ERROR "${TIMESERIES} has no rows")
+endif()
+
+foreach(window IN LISTS windows)
+    string(MAKE_C_IDENTIFIER "${window}" key)
+    to_micro("${last_${key}}" actual)
+    math(EXPR difference "${actual} - ${expected}")
+    # Splitting intervals at window boundaries rounds; allow a few micro-joules.
+    if(difference GREATER 2 OR difference LESS -2)
+        message(FATAL_ERROR "${window} s windows end at ${last_${key}} J, the report total is ${total} J")
+    endif()
+endforeach()
+message(STATUS "${TIMESERIES} adds up to the report total")
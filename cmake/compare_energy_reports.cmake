@@ -0,0 +1,57 @@
+# compare_energy_reports.cmake
+#
+# Checks that JSON Lines validation reports agree exactly with a reference
+# report. The "run" field names the report file and is ignored; every other
+# field, including energies printed at full double precision, must match.
+#
+#   cmake -DREFERENCE=<kernel.jsonl> -DREPORTS=<a.jsonl;b.jsonl> -P compare_energy_reports.cmake
+
+if(NOT DEFINED REFERENCE OR NOT DEFINED REPORTS)
+    message(FATAL_ERROR "usage: cmake -DREFERENCE=<report> -DREPORTS=<report;...> -P ${CMAKE_CURRENT_LIST_FILE}")
+endif()
+
+function(read_report path out)
+    if(NOT EXISTS "${path}")
+        message(FATAL_ERROR "missing report ${path}")
+    endif()
+    file(STRINGS "${path}" lines)
+    set(records "")
+    foreach(line IN LISTS lines)
+        string(REGEX REPLACE "\"run\":\"[^\"]*\"," "" line "${line}")
+        list(APPEND records "${line}")
+    endforeach()
+    if(NOT records)
+        message(FATAL_ERROR "${path} is empty")
+    endif()
+    set(${out} "${records}" PARENT_SCOPE)
+endfunction()
+
+read_report("${REFERENCE}" expected)
+list(LENGTH expected expected_count)
+
+set(failed "")
+foreach(report IN LISTS REPORTS)
+    read_report("${report}" actual)
+    list(LENGTH actual actual_count)
+    if(NOT actual_count EQUAL expected_count)
+        message(SEND_ERROR "${report}: ${actual_count} records, ${REFERENCE} has ${expected_count}")
+        list(APPEND failed "${report}")
+        continue()
+    endif()
+    math(EXPR last "${expected_count} - 1")
+    foreach(i RANGE ${last})
+        list(GET expected ${i} want)
+        list(GET actual ${i} got)
+        if(NOT got STREQUAL want)
+            message(SEND_ERROR "${report} differs from ${REFERENCE}:\n  expected ${want}\n  got      ${got}")
+            list(APPEND failed "${report}")
+            break()
+        endif()
+    endforeach()
+endforeach()
+
+if(failed)
+    message(FATAL_ERROR "energies differ from the reference in: ${failed}")
+endif()
+list(LENGTH REPORTS report_count)
+message(STATUS "${report_count} reports match ${REFERENCE}")
@@ -0,0 +1,291 @@
+/**
+ * battery_montecarlo.cpp
+ *
+ * Battery-life distribution by Monte Carlo over synthetic workloads:
+ *
+ *   battery_montecarlo (--markov-model <model.csv> | --markov-fit <trace>)
+ *                      [--capacity-wh <Wh>] [--duration <seconds>]
+ *                      [--max-life <seconds>] [--seed N] [--trials N]
+ *                      [--batch N] [--tolerance <fraction>]
+ *                      [--power-table <table.csv>]
+ *                      [--transition-costs <transitions.csv>] [--jobs N]
+ *                      [--output <trials.csv>]
+ *
+ * Trial i replays Markov stream i of the seed on the analytic fast path and
+ * records the energy over the mission `--duration` and, with a capacity,
+ * the time until the battery is empty (capped at `--max-life`). Trials run
+ * in batches on all cores; every trial has its own accumulator and writes
+ * only its own result slot. After each batch the 95% distribution-free
+ * confidence bounds of the reported percentiles are checked, and the run
+ * stops once all of them are within `--tolerance` of the percentile. The
+ * results depend only on the seed and the batch size, not on the number
+ * of workers.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "fast_engine.h"
+#include "markov_generator.h"
+#include "power_model.h"
+#include "power_table.h"
+#include "thread_pool.h"
+#include "trace_reader.h"
+#include "transition_matrix.h"
+
+namespace {
+
+const double PERCENTILES[] = {0.05, 0.50, 0.95};
+
+// Two-sided 95% normal quantile for the order-statistic bounds.
+const double CONFIDENCE_Z = 1.959964;
+
+const double SECONDS_PER_DAY = 24.0 * 3600.0;
+const double JOULES_PER_WH = 3600.0;
+
+// Batches smaller than this make the bounds too noisy to stop on.
+const std::size_t MIN_BATCH = 100;
+
+struct Percentile {
+    double value = 0.0;
+    double lower = 0.0;
+    double upper = 0.0;
+};
+
+// Percentile p of `sorted` with the ranks of its distribution-free
+// confidence bounds: the number of samples below the true percentile is
+// Binomial(n, p), approximated by a normal.
+Percentile percentile(const std::vector<double>& sorted, double p) {
+    const double n = static_cast<double>(sorted.size());
+    const double spread = CONFIDENCE_Z * std::sqrt(n * p * (1.0 - p));
+    const auto at = [&](double rank) {
+        const double clamped = std::min(std::max(rank, 0.0), n - 1.0);
+        return sorted[static_cast<std::size_t>(clamped)];
+    };
+    Percentile result;
+    result.value = at(std::floor(n * p));
+    result.lower = at(std::floor(n * p - spread));
+    result.upper = at(std::ceil(n * p + spread));
+    return result;
+}
+
+// True if every reported percentile of `samples` has bounds within
+// `tolerance` of its value.
+bool converged(std::vector<double> samples, double tolerance) {
+    std::sort(samples.begin(), samples.end());
+    for (double p : PERCENTILES) {
+        const Percentile q = percentile(samples, p);
+        if (q.upper - q.lower > 2.0 * tolerance * std::abs(q.value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Prints the percentiles of `samples` with their bounds, and the mean,
+// divided by `scale`.
+void printMetric(const std::string& label, std::vector<double> samples, double scale) {
+    std::sort(samples.begin(), samples.end());
+    double mean = 0.0;
+    for (double sample : samples) {
+        mean += sample;
+    }
+    mean /= static_cast<double>(samples.size());
+
+    std::cout << label << std::endl << std::fixed << std::setprecision(3);
+    for (double p : PERCENTILES) {
+        const Percentile q = percentile(samples, p);
+        std::cout << "  P" << std::left << std::setw(6) << static_cast<int>(p * 100.0 + 0.5) << std::right
+                  << std::setw(16) << q.value / scale << "  [" << q.lower / scale << ", " << q.upper / scale
+                  << "]" << std::endl;
+    }
+    std::cout << "  " << std::left << std::setw(7) << "Mean" << std::right << std::setw(16) << mean / scale
+              << std::defaultfloat << std::endl;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " (--markov-model <model.csv> | --markov-fit <trace>) [--capacity-wh <Wh>]"
+              << " [--duration <seconds>] [--max-life <seconds>] [--seed N] [--trials N]"
+              << " [--batch N] [--tolerance <fraction>] [--power-table <table.csv>]"
+              << " [--transition-costs <transitions.csv>] [--jobs N] [--output <trials.csv>]"
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string model_path;
+    std::string fit_path;
+    std::string power_table_path;
+    std::string transition_costs_path;
+    std::string output_path;
+    double capacity_wh = 0.0;
+    std::uint64_t duration = 30 * 24 * 3600;        // one month
+    std::uint64_t max_life = 10 * 365 * 24 * 3600;  // ten years
+    std::uint64_t seed = 1;
+    std::size_t max_trials = 100000;
+    std::size_t batch = 1000;
+    double tolerance = 0.01;
+    unsigned workers = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--markov-model" && i + 1 < argc) {
+            model_path = argv[++i];
+        } else if (arg == "--markov-fit" && i + 1 < argc) {
+            fit_path = argv[++i];
+        } else if (arg == "--capacity-wh" && i + 1 < argc) {
+            capacity_wh = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--duration" && i + 1 < argc) {
+            duration = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--max-life" && i + 1 < argc) {
+            max_life = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--trials" && i + 1 < argc) {
+            max_trials = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batch = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--tolerance" && i + 1 < argc) {
+            tolerance = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--power-table" && i + 1 < argc) {
+            power_table_path = argv[++i];
+        } else if (arg == "--transition-costs" && i + 1 < argc) {
+            transition_costs_path = argv[++i];
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            workers = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--output" && i + 1 < argc) {
+            output_path = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (model_path.empty() == fit_path.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (workers == 0) {
+        workers = defaultWorkerCount();
+    }
+
+    try {
+        if (duration == 0 || max_trials == 0 || batch < MIN_BATCH || !(tolerance > 0.0) ||
+            !(capacity_wh >= 0.0)) {
+            throw std::runtime_error("--duration and --trials must be positive, --batch at least " +
+                                     std::to_string(MIN_BATCH) + ", --tolerance above 0 and "
+                                     "--capacity-wh not negative");
+        }
+
+        MarkovModel model;
+        if (!model_path.empty()) {
+            model = MarkovModel::load(model_path);
+        } else {
+            if (traceTicksPerSecond(fit_path) != 1) {
+                // Model dwell times are whole seconds.
+                throw std::runtime_error("--fit needs a trace with whole-second timings");
+            }
+            std::unique_ptr<TraceReader> trace = openTrace(fit_path);
+            model = MarkovModel::fit(*trace);
+        }
+        const PowerTable table = power_table_path.empty() ? PowerTable::builtin()
+                                                          : PowerTable::load(power_table_path);
+        std::unique_ptr<TransitionMatrix> transition_costs;
+        if (!transition_costs_path.empty()) {
+            transition_costs.reset(new TransitionMatrix(TransitionMatrix::load(transition_costs_path, table)));
+        }
+        const double capacity = capacity_wh * JOULES_PER_WH;
+
+        auto start = std::chrono::steady_clock::now();
+
+        // One slot per trial; workers write disjoint slots.
+        std::vector<double> energy;
+        std::vector<double> life;
+        bool done = false;
+        while (!done && energy.size() < max_trials) {
+            const std::size_t first = energy.size();
+            const std::size_t count = std::min(batch, max_trials - first);
+            energy.resize(first + count);
+            life.resize(capacity > 0.0 ? first + count : 0);
+
+            parallelFor(count, workers, [&](std::size_t index, unsigned) {
+                const std::size_t trial = first + index;
+
+                EnergyAccumulator mission(table);
+                mission.transition_costs = transition_costs.get();
+                MarkovTraceReader reader(model, seed, trial, duration);
+                integrateTrace(reader, mission);
+                energy[trial] = mission.energyEstimation;
+
+                if (capacity > 0.0) {
+                    // The same stream, continued until the battery is empty.
+                    EnergyAccumulator battery(table);
+                    battery.transition_costs = transition_costs.get();
+                    MarkovTraceReader lifetime(model, seed, trial, max_life);
+                    ReplayControl control;
+                    control.energy_limit = capacity;
+                    integrateTrace(lifetime, battery, nullptr, nullptr, &control);
+                    life[trial] = std::isnan(control.depletion) ? static_cast<double>(max_life)
+                                                                : control.depletion;
+                }
+            });
+
+            done = converged(energy, tolerance) && (life.empty() || converged(life, tolerance));
+        }
+
+        const double elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "Ran " << energy.size() << " trials on " << workers << " workers in " << elapsed
+                  << " s (95% bounds " << (done ? "within " : "not yet within ") << tolerance * 100.0
+                  << "% of each percentile)" << std::endl;
+        std::cout << std::endl;
+        printMetric("Energy per " + std::to_string(duration) + " s (J):", energy, 1.0);
+        if (!life.empty()) {
+            std::ostringstream label;
+            label << "Battery life for " << capacity_wh << " Wh (days):";
+            printMetric(label.str(), life, SECONDS_PER_DAY);
+            const std::size_t censored = static_cast<std::size_t>(
+                std::count(life.begin(), life.end(), static_cast<double>(max_life)));
+            if (censored > 0) {
+                std::cout << censored << " trials did not deplete the battery within "
+                          << max_life / SECONDS_PER_DAY << " days and count as that long" << std::endl;
+            }
+        }
+
+        if (!output_path.empty()) {
+            std::ofstream csv_file(output_path);
+            if (!csv_file.is_open()) {
+                throw std::runtime_error("Could not create " + output_path);
+            }
+            csv_file << "Trial,Energy_J,Average_Power_W" << (life.empty() ? "" : ",Battery_Life_s") << "\n"
+                     << std::setprecision(10);
+            for (std::size_t trial = 0; trial < energy.size(); trial++) {
+                csv_file << trial << "," << energy[trial] << "," << energy[trial] / ticksToSeconds(duration);
+                if (!life.empty()) {
+                    csv_file << "," << life[trial];
+                }
+                csv_file << "\n";
+            }
+            if (!csv_file) {
+                throw std::runtime_error("Could not write " + output_path);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,609 @@
+/**
+ * benchmark.cpp
+ *
+ * Throughput benchmark for the simulation paths on synthetic traces:
+ *
+ *   power_benchmark [--sizes 1e3,1e4,1e5,1e6]
+ *                   [--paths reader,fast,fast_parallel,kernel,kernel_method,kernel_tlm]
+ *                   [--simulator <testbench>] [--kernel-max N]
+ *                   [--work-dir <dir>] [--keep-traces] [--output <results.json>]
+ *                   [--repeat N] [--baseline <baseline.json> [--tolerance <percent>]]
+ *
+ * For every size a binary trace with that many transitions is generated,
+ * then each path replays it:
+ *
+ *   reader         BinaryTraceReader run collapsing only
+ *   fast           analytic fast path (reader + energy integration)
+ *   fast_parallel  the fast path sharded over all cores (integrateTraceParallel)
+ *   kernel         full SystemC simulation, i.e. the simulator process with --quiet
+ *   kernel_method  the same with the SC_METHOD monitor (--monitor method)
+ *   kernel_tlm     the same with the decoupled TLM observer (--monitor tlm)
+ *
+ * Every measurement runs in its own child process so that peak RSS is per
+ * measurement. Startup time is measured on a one-transition trace. Results
+ * are written as JSON. With --repeat, each measurement is the fastest of N.
+ *
+ * With --baseline, throughput is compared against an earlier results file
+ * and the exit status is 1 if any path lost more than --tolerance percent
+ * (default 20) of its transitions per second. The baseline must exist;
+ * record one with --output.
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "binary_trace.h"
+#include "fast_engine.h"
+#include "power_model.h"
+#include "trace_reader.h"
+
+namespace {
+
+// Deterministic transition stream: each run moves to a different state and
+// lasts 1-4 samples at 1 Hz.
+class SyntheticTrace {
+public:
+    explicit SyntheticTrace(std::uint64_t seed) : rng(seed) {}
+
+    TraceRun next() {
+        TraceRun run;
+        run.state = (state + 1 + static_cast<int>(draw() % (NUM_STATES - 1))) % NUM_STATES;
+        run.start = time;
+        run.duration = 1 + draw() % 4;
+        state = run.state;
+        time += run.duration;
+        return run;
+    }
+
+private:
+    std::uint64_t draw() {
+        // 64-bit LCG (Knuth MMIX); the high bits are used.
+        rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+        return rng >> 33;
+    }
+
+    std::uint64_t rng;
+    int state = 0;
+    std::uint64_t time = 0;
+};
+
+const std::uint64_t SYNTHETIC_SEED = 20250101;
+
+void writeSyntheticTrace(const std::string& path, std::uint64_t transitions) {
+    // First pass sizes the columns, second pass writes them.
+    std::uint64_t samples = 0;
+    {
+        SyntheticTrace trace(SYNTHETIC_SEED);
+        for (std::uint64_t i = 0; i < transitions; i++) {
+            samples += trace.next().duration;
+        }
+    }
+
+    BinaryTraceWriter writer(path, samples, 1, BINARY_TRACE_HAS_STATES);
+    SyntheticTrace trace(SYNTHETIC_SEED);
+    TraceSample sample;
+    for (std::uint64_t i = 0; i < transitions; i++) {
+        const TraceRun run = trace.next();
+        sample.state = run.state;
+        for (std::uint64_t s = 0; s < run.duration; s++) {
+            sample.timestamp = run.start + s;
+            writer.append(sample);
+        }
+    }
+    writer.close();
+}
+
+struct Measurement {
+    double seconds = 0.0;
+    std::uint64_t transitions = 0;
+    long peak_rss_kb = 0;
+    bool ok = false;
+};
+
+long peakRssKb(const struct rusage& usage) {
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;  // bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Runs `work` in a forked child. The child reports elapsed seconds and the
+// number of transitions it saw through a pipe; the parent adds the child's
+// peak RSS.
+template <typename Work>
+Measurement measureInChild(Work work) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        throw std::runtime_error(std::string("pipe failed: ") + std::strerror(errno));
+    }
+
+    std::cout.flush();
+    const pid_t pid = fork();
+    if (pid < 0) {
+        throw std::runtime_error(std::string("fork failed: ") + std::strerror(errno));
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        double report[2] = {0.0, 0.0};
+        int code = 0;
+        try {
+            std::uint64_t transitions = 0;
+            report[0] = work(transitions);
+            report[1] = static_cast<double>(transitions);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            code = 1;
+        }
+        if (write(fds[1], report, sizeof(report)) != static_cast<ssize_t>(sizeof(report))) {
+            code = 1;
+        }
+        _exit(code);
+    }
+
+    close(fds[1]);
+    double report[2] = {0.0, 0.0};
+    const ssize_t got = read(fds[0], report, sizeof(report));
+    close(fds[0]);
+
+    int status = 0;
+    struct rusage usage;
+    std::memset(&usage, 0, sizeof(usage));
+    while (wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {
+    }
+
+    Measurement measurement;
+    measurement.ok = (got == static_cast<ssize_t>(sizeof(report))) &&
+                     WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    measurement.seconds = report[0];
+    measurement.transitions = static_cast<std::uint64_t>(report[1]);
+    measurement.peak_rss_kb = peakRssKb(usage);
+    return measurement;
+}
+
+Measurement measureReader(const std::string& path) {
+    return measureInChild([&](std::uint64_t& transitions) {
+        const auto start = std::chrono::steady_clock::now();
+        BinaryTraceReader reader(path);
+        TraceRun run;
+        std::uint64_t checksum = 0;
+        while (reader.next(run)) {
+            checksum += run.duration;
+            transitions++;
+        }
+        volatile std::uint64_t sink = checksum;
+        (void)sink;
+        return since(start);
+    });
+}
+
+Measurement measureFast(const std::string& path) {
+    return measureInChild([&](std::uint64_t& transitions) {
+        const auto start = std::chrono::steady_clock::now();
+        BinaryTraceReader reader(path);
+        EnergyAccumulator accumulator;
+        integrateTrace(reader, accumulator);
+        volatile double sink = accumulator.energyEstimation;
+        (void)sink;
+        transitions = accumulator.transition_count;
+        return since(start);
+    });
+}
+
+Measurement measureFastParallel(const std::string& path) {
+    return measureInChild([&](std::uint64_t& transitions) {
+        const auto start = std::chrono::steady_clock::now();
+        MappedTrace trace(path);
+        EnergyAccumulator accumulator;
+        integrateTraceParallel(trace, accumulator);
+        volatile double sink = accumulator.energyEstimation;
+        (void)sink;
+        transitions = accumulator.transition_count;
+        return since(start);
+    });
+}
+
+// Wall time and peak RSS of a complete simulator process, including kernel
+// elaboration.
+Measurement measureKernel(const std::string& simulator, const std::string& path,
+                          std::uint64_t transitions, const char* monitor) {
+    std::cout.flush();
+    const auto start = std::chrono::steady_clock::now();
+    const pid_t pid = fork();
+    if (pid < 0) {
+        throw std::runtime_error(std::string("fork failed: ") + std::strerror(errno));
+    }
+    if (pid == 0) {
+        execl(simulator.c_str(), simulator.c_str(), "--trace", path.c_str(), "--quiet",
+              "--output", "/dev/null", "--monitor", monitor, static_cast<char*>(nullptr));
+        _exit(127);
+    }
+
+    int status = 0;
+    struct rusage usage;
+    std::memset(&usage, 0, sizeof(usage));
+    while (wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {
+    }
+
+    Measurement measurement;
+    measurement.seconds = since(start);
+    measurement.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    measurement.transitions = measurement.ok ? transitions : 0;
+    measurement.peak_rss_kb = peakRssKb(usage);
+    return measurement;
+}
+
+std::vector<std::uint64_t> parseSizes(const std::string& text) {
+    std::vector<std::uint64_t> sizes;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        char* end = nullptr;
+        const double value = std::strtod(item.c_str(), &end);
+        if (item.empty() || *end != '\0' || value < 1.0 || value > 1e12) {
+            throw std::runtime_error("invalid size '" + item + "'");
+        }
+        sizes.push_back(static_cast<std::uint64_t>(std::llround(value)));
+    }
+    return sizes;
+}
+
+bool hasPath(const std::string& paths, const std::string& name) {
+    std::stringstream stream(paths);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (item == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string defaultSimulator(const char* argv0) {
+    std::string self = argv0;
+    const std::size_t slash = self.rfind('/');
+    const std::string dir = (slash == std::string::npos) ? "." : self.substr(0, slash);
+    return dir + "/testbench_dvconchallenge";
+}
+
+// Fastest of `repeat` measurements; a failed attempt is returned at once.
+template <typename Measure>
+Measurement fastestOf(unsigned repeat, Measure measure) {
+    Measurement fastest = measure();
+    for (unsigned i = 1; i < repeat && fastest.ok; i++) {
+        const Measurement measurement = measure();
+        if (!measurement.ok || measurement.seconds < fastest.seconds) {
+            fastest = measurement;
+        }
+    }
+    return fastest;
+}
+
+struct Result {
+    std::string path;
+    std::uint64_t transitions;
+    Measurement measurement;
+
+    double transitionsPerSecond() const {
+        return measurement.seconds > 0.0 ? transitions / measurement.seconds : 0.0;
+    }
+};
+
+// Throughput of one path and size in a baseline file.
+struct BaselineEntry {
+    std::string path;
+    std::uint64_t transitions = 0;
+    double transitions_per_sec = 0.0;
+};
+
+// Value after `"key": ` in one line of a results file, up to ',' or '}'.
+bool jsonField(const std::string& line, const std::string& key, std::string& value) {
+    const std::string marker = "\"" + key + "\": ";
+    const std::size_t at = line.find(marker);
+    if (at == std::string::npos) {
+        return false;
+    }
+    const std::size_t begin = at + marker.size();
+    if (line.compare(begin, 1, "\"") == 0) {
+        const std::size_t end = line.find('"', begin + 1);
+        value = line.substr(begin + 1, end == std::string::npos ? std::string::npos : end - begin - 1);
+    } else {
+        value = line.substr(begin, line.find_first_of(",}", begin) - begin);
+    }
+    return true;
+}
+
+// Reads the results of a file written by writeJson(), one per line.
+std::vector<BaselineEntry> readBaseline(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open baseline " + path);
+    }
+    std::vector<BaselineEntry> entries;
+    std::string line;
+    while (std::getline(file, line)) {
+        BaselineEntry entry;
+        std::string transitions;
+        std::string per_sec;
+        if (!jsonField(line, "path", entry.path) || !jsonField(line, "transitions", transitions) ||
+            !jsonField(line, "transitions_per_sec", per_sec)) {
+            continue;
+        }
+        entry.transitions = std::strtoull(transitions.c_str(), nullptr, 10);
+        entry.transitions_per_sec = std::strtod(per_sec.c_str(), nullptr);
+        entries.push_back(entry);
+    }
+    if (entries.empty()) {
+        throw std::runtime_error(path + " has no benchmark results");
+    }
+    return entries;
+}
+
+// Prints every result against its baseline and returns the number that
+// lost more than `tolerance` percent of their throughput.
+int compareBaseline(const std::vector<Result>& results, const std::vector<BaselineEntry>& baseline,
+                    double tolerance) {
+    int regressions = 0;
+    std::cerr << "Path,Transitions,Baseline_per_s,Current_per_s,Change_Percent" << std::endl;
+    for (const Result& result : results) {
+        const BaselineEntry* match = nullptr;
+        for (const BaselineEntry& entry : baseline) {
+            if (entry.path == result.path && entry.transitions == result.transitions) {
+                match = &entry;
+            }
+        }
+        if (!match || !(match->transitions_per_sec > 0.0)) {
+            std::cerr << result.path << "," << result.transitions << ",,," << "no baseline" << std::endl;
+            continue;
+        }
+        const double current = result.transitionsPerSecond();
+        const double change = (current / match->transitions_per_sec - 1.0) * 100.0;
+        const bool regressed = !result.measurement.ok || change < -tolerance;
+        std::cerr << result.path << "," << result.transitions << "," << match->transitions_per_sec << ","
+                  << current << "," << change << (regressed ? ",REGRESSION" : "") << std::endl;
+        if (regressed) {
+            regressions++;
+        }
+    }
+    return regressions;
+}
+
+void writeJson(std::ostream& out, const std::vector<Result>& results,
+               const std::vector<Result>& startup) {
+    auto number = [](double value) {
+        std::ostringstream text;
+        text.precision(9);
+        text << (std::isfinite(value) ? value : 0.0);
+        return text.str();
+    };
+
+    out << "{\n";
+    out << "  \"benchmark\": \"dvcon_power_model\",\n";
+    out << "  \"seed\": " << SYNTHETIC_SEED << ",\n";
+    out << "  \"startup\": {";
+    for (std::size_t i = 0; i < startup.size(); i++) {
+        out << (i ? ", " : "") << "\"" << startup[i].path << "_s\": "
+            << number(startup[i].measurement.seconds);
+    }
+    out << "},\n";
+    out << "  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const Result& result = results[i];
+        const Measurement& m = result.measurement;
+        const double seconds = m.seconds > 0.0 ? m.seconds : 0.0;
+        const double per_sec = result.transitionsPerSecond();
+        const double ns_per = result.transitions > 0 ? seconds * 1e9 / result.transitions : 0.0;
+        out << "    {\"path\": \"" << result.path << "\""
+            << ", \"transitions\": " << result.transitions
+            << ", \"ok\": " << (m.ok ? "true" : "false")
+            << ", \"seconds\": " << number(seconds)
+            << ", \"transitions_per_sec\": " << number(per_sec)
+            << ", \"ns_per_transition\": " << number(ns_per)
+            << ", \"peak_rss_kb\": " << m.peak_rss_kb << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+// Kernel paths and the simulator monitor each one selects.
+struct KernelPath {
+    const char* name;
+    const char* monitor;
+};
+
+const KernelPath KERNEL_PATHS[] = {
+    {"kernel", "thread"},
+    {"kernel_method", "method"},
+    {"kernel_tlm", "tlm"},
+};
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " [--sizes 1e3,1e4,...] [--paths reader,fast,fast_parallel,kernel,kernel_method,kernel_tlm]"
+              << " [--simulator <testbench>]"
+              << " [--kernel-max N] [--work-dir <dir>] [--keep-traces] [--output <results.json>]"
+              << " [--repeat N] [--baseline <baseline.json> [--tolerance <percent>]]" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string sizes_text = "1e3,1e4,1e5,1e6";
+    std::string paths = "reader,fast,fast_parallel,kernel,kernel_method,kernel_tlm";
+    std::string simulator = defaultSimulator(argv[0]);
+    std::string work_dir = "benchmark_traces";
+    std::string output_path;
+    std::uint64_t kernel_max = 10000000;
+    bool keep_traces = false;
+    unsigned repeat = 1;
+    std::string baseline_path;
+    double tolerance = 20.0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--sizes" && i + 1 < argc) {
+            sizes_text = argv[++i];
+        } else if (arg == "--paths" && i + 1 < argc) {
+            paths = argv[++i];
+        } else if (arg == "--simulator" && i + 1 < argc) {
+            simulator = argv[++i];
+        } else if (arg == "--kernel-max" && i + 1 < argc) {
+            kernel_max = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--work-dir" && i + 1 < argc) {
+            work_dir = argv[++i];
+        } else if (arg == "--keep-traces") {
+            keep_traces = true;
+        } else if (arg == "--output" && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            repeat = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (arg == "--tolerance" && i + 1 < argc) {
+            tolerance = std::strtod(argv[++i], nullptr);
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (repeat == 0 || !(tolerance >= 0.0)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        const std::vector<std::uint64_t> sizes = parseSizes(sizes_text);
+        const bool run_reader = hasPath(paths, "reader");
+        const bool run_fast = hasPath(paths, "fast");
+        const bool run_fast_parallel = hasPath(paths, "fast_parallel");
+        std::vector<KernelPath> kernel_paths;
+        for (const KernelPath& kernel_path : KERNEL_PATHS) {
+            if (hasPath(paths, kernel_path.name)) {
+                kernel_paths.push_back(kernel_path);
+            }
+        }
+        // Read the baseline first, so a gate without one fails before measuring.
+        const std::vector<BaselineEntry> baseline =
+            baseline_path.empty() ? std::vector<BaselineEntry>() : readBaseline(baseline_path);
+
+        if (!kernel_paths.empty() && access(simulator.c_str(), X_OK) != 0) {
+            std::cerr << "Warning: simulator " << simulator
+                      << " is not executable, skipping the kernel paths" << std::endl;
+            kernel_paths.clear();
+        }
+
+        if (mkdir(work_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+            throw std::runtime_error("Could not create " + work_dir + ": " + std::strerror(errno));
+        }
+
+        std::vector<Result> startup;
+        {
+            const std::string path = work_dir + "/synthetic_1.dvctrace";
+            writeSyntheticTrace(path, 1);
+            if (run_reader) {
+                startup.push_back({"reader", 1, measureReader(path)});
+            }
+            if (run_fast) {
+                startup.push_back({"fast", 1, measureFast(path)});
+            }
+            if (run_fast_parallel) {
+                startup.push_back({"fast_parallel", 1, measureFastParallel(path)});
+            }
+            for (const KernelPath& kernel_path : kernel_paths) {
+                startup.push_back({kernel_path.name, 1,
+                                   measureKernel(simulator, path, 1, kernel_path.monitor)});
+            }
+            if (!keep_traces) {
+                std::remove(path.c_str());
+            }
+        }
+
+        std::vector<Result> results;
+        for (std::uint64_t transitions : sizes) {
+            const std::string path = work_dir + "/synthetic_" + std::to_string(transitions) + ".dvctrace";
+            std::cerr << "Generating " << transitions << " transitions..." << std::endl;
+            writeSyntheticTrace(path, transitions);
+
+            if (run_reader) {
+                results.push_back({"reader", transitions, fastestOf(repeat, [&] { return measureReader(path); })});
+            }
+            if (run_fast) {
+                results.push_back({"fast", transitions, fastestOf(repeat, [&] { return measureFast(path); })});
+            }
+            if (run_fast_parallel) {
+                results.push_back({"fast_parallel", transitions,
+                                   fastestOf(repeat, [&] { return measureFastParallel(path); })});
+            }
+            for (const KernelPath& kernel_path : kernel_paths) {
+                if (transitions <= kernel_max) {
+                    results.push_back({kernel_path.name, transitions, fastestOf(repeat, [&] {
+                                           return measureKernel(simulator, path, transitions, kernel_path.monitor);
+                                       })});
+                }
+            }
+            for (const Result& result : results) {
+                if (result.transitions == transitions) {
+                    std::cerr << "  " << result.path << ": " << result.measurement.seconds << " s"
+                              << (result.measurement.ok ? "" : " (failed)") << std::endl;
+                }
+            }
+
+            if (!keep_traces) {
+                std::remove(path.c_str());
+            }
+        }
+
+        if (output_path.empty()) {
+            writeJson(std::cout, results, startup);
+        } else {
+            std::ofstream out(output_path);
+            if (!out.is_open()) {
+                throw std::runtime_error("Could not create " + output_path);
+            }
+            writeJson(out, results, startup);
+        }
+
+        for (const Result& result : results) {
+            if (!result.measurement.ok) {
+                return 1;
+            }
+        }
+
+        if (!baseline_path.empty()) {
+            const int regressions = compareBaseline(results, baseline, tolerance);
+            if (regressions > 0) {
+                std::cerr << regressions << " path(s) regressed by more than " << tolerance
+                          << "% against " << baseline_path << std::endl;
+                return 1;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,258 @@
+/**
+ * binary_trace.cpp
+ */
+
+#include "binary_trace.h"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::uint64_t alignUp(std::uint64_t offset) {
+    return (offset + 7) & ~static_cast<std::uint64_t>(7);
+}
+
+} // namespace
+
+bool isBinaryTrace(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(BINARY_TRACE_MAGIC)] = {0};
+    file.read(magic, sizeof(magic));
+    return file.gcount() == sizeof(magic) &&
+           std::memcmp(magic, BINARY_TRACE_MAGIC, sizeof(magic)) == 0;
+}
+
+MappedTrace::MappedTrace(const std::string& path) : path(path) {
+#if defined(_WIN32)
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open trace file " + path);
+    }
+    storage.resize(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(storage.data()), static_cast<std::streamsize>(storage.size()));
+    data = storage.data();
+    length = storage.size();
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open trace file " + path);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Could not stat trace file " + path);
+    }
+    length = static_cast<std::size_t>(info.st_size);
+    if (length >= sizeof(BinaryTraceHeader)) {
+        void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Could not map trace file " + path);
+        }
+        ::madvise(mapping, length, MADV_SEQUENTIAL);
+        data = static_cast<const unsigned char*>(mapping);
+    }
+    ::close(fd);
+#endif
+
+    if (length < sizeof(BinaryTraceHeader)) {
+        throw std::runtime_error(path + " is too short to be a binary trace");
+    }
+
+    header = reinterpret_cast<const BinaryTraceHeader*>(data);
+    if (std::memcmp(header->magic, BINARY_TRACE_MAGIC, sizeof(BINARY_TRACE_MAGIC)) != 0) {
+        throw std::runtime_error(path + " is not a binary trace");
+    }
+    if (header->version != BINARY_TRACE_VERSION) {
+        throw std::runtime_error(path + " has unsupported binary trace version " +
+                                 std::to_string(header->version));
+    }
+
+    timestamp_column = static_cast<const std::uint64_t*>(column(header->timestamp_offset, sizeof(std::uint64_t)));
+    if (hasPower()) {
+        power_column = static_cast<const double*>(column(header->power_offset, sizeof(double)));
+    }
+    if (hasStates()) {
+        state_column = static_cast<const std::uint16_t*>(column(header->state_offset, sizeof(std::uint16_t)));
+    }
+}
+
+MappedTrace::~MappedTrace() {
+#if !defined(_WIN32)
+    if (data) {
+        ::munmap(const_cast<unsigned char*>(data), length);
+    }
+#endif
+}
+
+const void* MappedTrace::column(std::uint64_t offset, std::size_t width) const {
+    const std::uint64_t bytes = header->sample_count * width;
+    if (offset % width != 0 || offset > length || bytes > length - offset) {
+        throw std::runtime_error(path + " is truncated or has a corrupt column table");
+    }
+    return data + offset;
+}
+
+BinaryTraceReader::BinaryTraceReader(const std::string& path)
+    : mapped(path), runs(mapped, 0, mapped.size()) {
+    if (!mapped.hasStates()) {
+        throw std::runtime_error(path + " has no state column");
+    }
+}
+
+bool MappedRunReader::next(TraceRun& run) {
+    if (position >= end) {
+        return false;
+    }
+
+    const std::uint64_t count = mapped.size();
+    const std::uint64_t* timestamps = mapped.timestamps();
+    const std::uint16_t* states = mapped.states();
+
+    const std::uint16_t state = states[position];
+    std::uint64_t run_end = position + 1;
+    while (run_end < end && states[run_end] == state) {
+        ++run_end;
+    }
+
+    run.state = state;
+    run.start = timestamps[position];
+    const std::uint64_t run_stop = run_end < count ? timestamps[run_end]
+                                                   // The last sample covers one sample period.
+                                                   : timestamps[count - 1] + mapped.samplePeriod();
+    run.duration = run_stop - run.start;
+
+    run.measured_energy = std::numeric_limits<double>::quiet_NaN();
+    if (const double* power = mapped.power()) {
+        run.measured_energy = 0.0;
+        for (std::uint64_t i = position; i < run_end; i++) {
+            const std::uint64_t next_time = i + 1 < count ? timestamps[i + 1] : run_stop;
+            run.measured_energy += power[i] * traceSeconds(next_time - timestamps[i], mapped.ticksPerSecond());
+        }
+    }
+    position = run_end;
+    return true;
+}
+
+BinaryTraceWriter::BinaryTraceWriter(const std::string& path, std::uint64_t sample_count,
+                                     std::uint64_t sample_period, std::uint32_t flags,
+                                     std::uint64_t ticks_per_second)
+    : path(path), file(path, std::ios::binary | std::ios::trunc) {
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not create binary trace " + path);
+    }
+
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, BINARY_TRACE_MAGIC, sizeof(BINARY_TRACE_MAGIC));
+    header.version = BINARY_TRACE_VERSION;
+    header.flags = flags;
+    header.sample_count = sample_count;
+    header.sample_period = sample_period;
+    header.ticks_per_second = ticks_per_second;
+
+    std::uint64_t offset = sizeof(BinaryTraceHeader);
+    header.timestamp_offset = offset;
+    offset += sample_count * sizeof(std::uint64_t);
+    if (flags & BINARY_TRACE_HAS_POWER) {
+        header.power_offset = offset;
+        offset += sample_count * sizeof(double);
+    }
+    if (flags & BINARY_TRACE_HAS_STATES) {
+        header.state_offset = offset;
+        offset += sample_count * sizeof(std::uint16_t);
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Pre-size the file so every column block can be written in place.
+    const std::uint64_t total = alignUp(offset);
+    if (total > sizeof(header)) {
+        file.seekp(static_cast<std::streamoff>(total - 1));
+        file.put('\0');
+    }
+
+    timestamp_block.reserve(BLOCK_SIZE);
+    power_block.reserve(BLOCK_SIZE);
+    state_block.reserve(BLOCK_SIZE);
+}
+
+BinaryTraceWriter::~BinaryTraceWriter() {
+    if (!closed) {
+        try {
+            flush();
+        } catch (...) {
+        }
+    }
+}
+
+void BinaryTraceWriter::append(const TraceSample& sample) {
+    if (written + timestamp_block.size() >= header.sample_count) {
+        throw std::runtime_error(path + ": more samples appended than announced");
+    }
+    if ((header.flags & BINARY_TRACE_HAS_STATES) &&
+        (sample.state < 0 || sample.state > std::numeric_limits<std::uint16_t>::max())) {
+        throw std::runtime_error(path + ": state " + std::to_string(sample.state) +
+                                 " cannot be stored");
+    }
+
+    timestamp_block.push_back(sample.timestamp);
+    if (header.flags & BINARY_TRACE_HAS_POWER) {
+        power_block.push_back(sample.power);
+    }
+    if (header.flags & BINARY_TRACE_HAS_STATES) {
+        state_block.push_back(static_cast<std::uint16_t>(sample.state));
+    }
+
+    if (timestamp_block.size() == BLOCK_SIZE) {
+        flush();
+    }
+}
+
+void BinaryTraceWriter::flush() {
+    if (timestamp_block.empty()) {
+        return;
+    }
+
+    file.seekp(static_cast<std::streamoff>(header.timestamp_offset + written * sizeof(std::uint64_t)));
+    file.write(reinterpret_cast<const char*>(timestamp_block.data()),
+               static_cast<std::streamsize>(timestamp_block.size() * sizeof(std::uint64_t)));
+    if (header.flags & BINARY_TRACE_HAS_POWER) {
+        file.seekp(static_cast<std::streamoff>(header.power_offset + written * sizeof(double)));
+        file.write(reinterpret_cast<const char*>(power_block.data()),
+                   static_cast<std::streamsize>(power_block.size() * sizeof(double)));
+    }
+    if (header.flags & BINARY_TRACE_HAS_STATES) {
+        file.seekp(static_cast<std::streamoff>(header.state_offset + written * sizeof(std::uint16_t)));
+        file.write(reinterpret_cast<const char*>(state_block.data()),
+                   static_cast<std::streamsize>(state_block.size() * sizeof(std::uint16_t)));
+    }
+
+    written += timestamp_block.size();
+    timestamp_block.clear();
+    power_block.clear();
+    state_block.clear();
+
+    if (!file) {
+        throw std::runtime_error("Could not write binary trace " + path);
+    }
+}
+
+void BinaryTraceWriter::close() {
+    flush();
+    closed = true;
+    file.close();
+    if (written != header.sample_count) {
+        throw std::runtime_error(path + ": " + std::to_string(written) + " samples written, " +
+                                 std::to_string(header.sample_count) + " announced");
+    }
+}
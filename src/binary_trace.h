@@ -0,0 +1,145 @@
+/**
+ * binary_trace.h
+ *
+ * Compact columnar trace format. Traces are converted once from CSV with
+ * trace_convert and then memory-mapped and iterated in place, so repeated
+ * runs skip text parsing entirely.
+ *
+ * File layout (little-endian, every column 8-byte aligned):
+ *
+ *   BinaryTraceHeader                      64 bytes
+ *   uint64_t timestamp[sample_count]       ticks from the first sample
+ *   double   power[sample_count]           if BINARY_TRACE_HAS_POWER
+ *   uint16_t state[sample_count]           if BINARY_TRACE_HAS_STATES
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "trace_reader.h"
+
+const char BINARY_TRACE_MAGIC[8] = {'D', 'V', 'C', 'T', 'R', 'A', 'C', 'E'};
+const std::uint32_t BINARY_TRACE_VERSION = 1;
+
+const std::uint32_t BINARY_TRACE_HAS_POWER = 1u << 0;
+const std::uint32_t BINARY_TRACE_HAS_STATES = 1u << 1;
+
+struct BinaryTraceHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint64_t sample_count;
+    std::uint64_t sample_period;     // ticks
+    std::uint64_t timestamp_offset;  // byte offsets from the start of the file
+    std::uint64_t power_offset;
+    std::uint64_t state_offset;
+    std::uint64_t ticks_per_second;  // 0 in files written before it existed: seconds
+};
+
+static_assert(sizeof(BinaryTraceHeader) == 64, "BinaryTraceHeader must stay 64 bytes");
+
+// Returns true if `path` starts with the binary trace magic.
+bool isBinaryTrace(const std::string& path);
+
+// Read-only mapping of a binary trace file. Column accessors point straight
+// into the mapping.
+class MappedTrace {
+public:
+    explicit MappedTrace(const std::string& path);
+    ~MappedTrace();
+
+    MappedTrace(const MappedTrace&) = delete;
+    MappedTrace& operator=(const MappedTrace&) = delete;
+
+    std::uint64_t size() const { return header->sample_count; }
+    std::uint64_t samplePeriod() const { return header->sample_period; }
+    std::uint64_t ticksPerSecond() const { return header->ticks_per_second > 0 ? header->ticks_per_second : 1; }
+    bool hasPower() const { return (header->flags & BINARY_TRACE_HAS_POWER) != 0; }
+    bool hasStates() const { return (header->flags & BINARY_TRACE_HAS_STATES) != 0; }
+
+    const std::uint64_t* timestamps() const { return timestamp_column; }
+    const double* power() const { return power_column; }      // nullptr without power
+    const std::uint16_t* states() const { return state_column; }  // nullptr without states
+
+private:
+    const void* column(std::uint64_t offset, std::size_t width) const;
+
+    std::string path;
+    const unsigned char* data = nullptr;
+    std::size_t length = 0;
+#if defined(_WIN32)
+    std::vector<unsigned char> storage;
+#endif
+
+    const BinaryTraceHeader* header = nullptr;
+    const std::uint64_t* timestamp_column = nullptr;
+    const double* power_column = nullptr;
+    const std::uint16_t* state_column = nullptr;
+};
+
+// Iterates samples [begin, end) of a mapped trace as runs, collapsing
+// consecutive identical states on the fly without copying the columns. A
+// run that continues past `end` is cut there. Many readers can share one
+// mapping, e.g. one per worker thread.
+class MappedRunReader : public TraceReader {
+public:
+    MappedRunReader(const MappedTrace& trace, std::uint64_t begin, std::uint64_t end)
+        : mapped(trace), position(begin), end(end) {}
+
+    bool next(TraceRun& run) override;
+
+private:
+    const MappedTrace& mapped;
+    std::uint64_t position;
+    std::uint64_t end;
+};
+
+// Iterates a whole binary trace file as runs.
+class BinaryTraceReader : public TraceReader {
+public:
+    explicit BinaryTraceReader(const std::string& path);
+
+    bool next(TraceRun& run) override { return runs.next(run); }
+
+    const MappedTrace& trace() const { return mapped; }
+
+private:
+    MappedTrace mapped;
+    MappedRunReader runs;
+};
+
+// Writes a binary trace whose sample count is known up front. Samples are
+// buffered per column and flushed in blocks to their column offsets.
+class BinaryTraceWriter {
+public:
+    BinaryTraceWriter(const std::string& path, std::uint64_t sample_count,
+                      std::uint64_t sample_period, std::uint32_t flags,
+                      std::uint64_t ticks_per_second = 1);
+    ~BinaryTraceWriter();
+
+    void append(const TraceSample& sample);
+
+    // Flushes the remaining blocks; throws if fewer samples were appended
+    // than announced.
+    void close();
+
+private:
+    void flush();
+
+    static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+    std::string path;
+    std::ofstream file;
+    BinaryTraceHeader header;
+    std::uint64_t written = 0;
+    bool closed = false;
+
+    std::vector<std::uint64_t> timestamp_block;
+    std::vector<double> power_block;
+    std::vector<std::uint16_t> state_block;
+};
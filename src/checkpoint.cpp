@@ -0,0 +1,186 @@
+/**
+ * checkpoint.cpp
+ */
+
+#include "checkpoint.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+template <typename T>
+void writeArray(std::ofstream& file, const T* data, std::size_t count) {
+    file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+template <typename T>
+void readArray(std::ifstream& file, T* data, std::size_t count) {
+    file.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+} // namespace
+
+void writeCheckpoint(const std::string& path, const EnergyAccumulator& accumulator,
+                     const ReplayPosition& position) {
+    const PowerTable& table = *accumulator.table;
+    const std::size_t n = static_cast<std::size_t>(table.stateCount());
+
+    CheckpointHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.state_count = static_cast<std::uint32_t>(n);
+    header.first_run = position.first_run;
+    header.runs = position.runs;
+    header.start_tick = position.start_tick;
+    header.tick = position.tick;
+    header.last_charge = position.last_charge;
+    header.previous_status = accumulator.previous_status;
+    header.first_status = accumulator.first_status;
+    header.transition_count = accumulator.transition_count;
+    header.total_ticks = accumulator.total_ticks;
+    header.energy_sum[0] = accumulator.energy_sum.sum;
+    header.energy_sum[1] = accumulator.energy_sum.compensation;
+    header.transition_energy_sum[0] = accumulator.transition_energy_sum.sum;
+    header.transition_energy_sum[1] = accumulator.transition_energy_sum.compensation;
+    header.ticks_per_second = ticksPerSecond();
+
+    std::vector<double> power(n);
+    std::vector<double> state_energy(2 * n);
+    for (std::size_t s = 0; s < n; s++) {
+        power[s] = table.power(static_cast<int>(s));
+        state_energy[2 * s] = accumulator.state_energy_sum[s].sum;
+        state_energy[2 * s + 1] = accumulator.state_energy_sum[s].compensation;
+    }
+
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not create checkpoint " + temporary);
+        }
+        writeArray(file, &header, 1);
+        writeArray(file, power.data(), n);
+        writeArray(file, accumulator.state_ticks.data(), n);
+        writeArray(file, state_energy.data(), 2 * n);
+        writeArray(file, accumulator.pair_transitions.data(), n * n);
+        file.flush();
+        if (!file) {
+            throw std::runtime_error("Could not write checkpoint " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Could not replace checkpoint " + path);
+    }
+}
+
+namespace {
+
+CheckpointHeader readHeader(std::ifstream& file, const std::string& path) {
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open checkpoint " + path);
+    }
+
+    CheckpointHeader header;
+    readArray(file, &header, 1);
+    if (!file || std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error(path + " is not a checkpoint");
+    }
+    if (header.version != CHECKPOINT_VERSION) {
+        throw std::runtime_error(path + ": unsupported checkpoint version " +
+                                 std::to_string(header.version));
+    }
+    return header;
+}
+
+} // namespace
+
+std::uint64_t checkpointTicksPerSecond(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    const CheckpointHeader header = readHeader(file, path);
+    return header.ticks_per_second > 0 ? header.ticks_per_second : 1;
+}
+
+ReplayPosition readCheckpoint(const std::string& path, EnergyAccumulator& accumulator) {
+    std::ifstream file(path, std::ios::binary);
+    const CheckpointHeader header = readHeader(file, path);
+
+    const PowerTable& table = *accumulator.table;
+    const std::size_t n = header.state_count;
+    if (n != static_cast<std::size_t>(table.stateCount())) {
+        throw std::runtime_error(path + ": checkpoint has " + std::to_string(n) +
+                                 " states, the power table " + std::to_string(table.stateCount()));
+    }
+
+    std::vector<double> power(n);
+    std::vector<std::uint64_t> state_ticks(n);
+    std::vector<double> state_energy(2 * n);
+    std::vector<std::uint64_t> pair_transitions(n * n);
+    readArray(file, power.data(), n);
+    readArray(file, state_ticks.data(), n);
+    readArray(file, state_energy.data(), 2 * n);
+    readArray(file, pair_transitions.data(), n * n);
+    if (!file) {
+        throw std::runtime_error(path + ": truncated checkpoint");
+    }
+    for (std::size_t s = 0; s < n; s++) {
+        if (power[s] != table.power(static_cast<int>(s))) {
+            throw std::runtime_error(path + ": checkpoint was written with a different power table");
+        }
+    }
+    if ((header.ticks_per_second > 0 ? header.ticks_per_second : 1) != ticksPerSecond()) {
+        throw std::runtime_error(path + ": checkpoint was written at a different time resolution");
+    }
+    const auto validState = [n](std::int32_t state) {
+        return state >= -1 && state < static_cast<std::int32_t>(n);
+    };
+    if (!validState(header.previous_status) || !validState(header.first_status) ||
+        header.tick < header.last_charge || header.runs < header.first_run) {
+        throw std::runtime_error(path + ": inconsistent checkpoint");
+    }
+
+    accumulator.previous_status = header.previous_status;
+    accumulator.first_status = header.first_status;
+    accumulator.transition_count = header.transition_count;
+    accumulator.powerEstimation = header.previous_status >= 0 ? table.power(header.previous_status) : 0.0;
+    accumulator.total_ticks = header.total_ticks;
+    accumulator.energy_sum.sum = header.energy_sum[0];
+    accumulator.energy_sum.compensation = header.energy_sum[1];
+    accumulator.energyEstimation = accumulator.energy_sum.value();
+    accumulator.transition_energy_sum.sum = header.transition_energy_sum[0];
+    accumulator.transition_energy_sum.compensation = header.transition_energy_sum[1];
+    accumulator.transition_energy = accumulator.transition_energy_sum.value();
+    for (std::size_t s = 0; s < n; s++) {
+        accumulator.state_ticks[s] = state_ticks[s];
+        accumulator.state_duration[s] = ticksToSeconds(state_ticks[s]);
+        accumulator.state_energy_sum[s].sum = state_energy[2 * s];
+        accumulator.state_energy_sum[s].compensation = state_energy[2 * s + 1];
+        accumulator.state_energy[s] = accumulator.state_energy_sum[s].value();
+    }
+    accumulator.pair_transitions = pair_transitions;
+
+    ReplayPosition position;
+    position.first_run = header.first_run;
+    position.runs = header.runs;
+    position.start_tick = header.start_tick;
+    position.tick = header.tick;
+    position.last_charge = header.last_charge;
+    return position;
+}
+
+std::uint64_t skipRuns(TraceReader& reader, std::uint64_t count) {
+    std::uint64_t ticks = 0;
+    TraceRun run;
+    for (std::uint64_t i = 0; i < count; i++) {
+        if (!reader.next(run)) {
+            throw std::runtime_error("trace ends after " + std::to_string(i) + " runs, expected " +
+                                     std::to_string(count));
+        }
+        ticks += run.duration;
+    }
+    return ticks;
+}
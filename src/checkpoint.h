@@ -0,0 +1,82 @@
+/**
+ * checkpoint.h
+ *
+ * Compact binary checkpoints of a replay: the accumulator state and the
+ * position in the trace, counted in runs. A replay that dies can resume
+ * from its last checkpoint instead of from zero, and separate segments of
+ * one trace, each saved as a checkpoint, can be merged exactly.
+ *
+ * File layout (little-endian):
+ *
+ *   CheckpointHeader                              128 bytes
+ *   double   power[state_count]                   table the state was built with
+ *   uint64_t state_ticks[state_count]
+ *   double   state_energy[state_count][2]         compensated sum, compensation
+ *   uint64_t pair_transitions[state_count ^ 2]
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "power_model.h"
+#include "trace_reader.h"
+
+const char CHECKPOINT_MAGIC[8] = {'D', 'V', 'C', 'C', 'K', 'P', 'T', '\0'};
+const std::uint32_t CHECKPOINT_VERSION = 1;
+
+// Where a replay stands in its trace. A replay covers runs
+// [first_run, runs); `tick` is the end of those runs and `last_charge` the
+// time up to which the current state has been charged. A segment that
+// ended at its last run has last_charge == tick.
+struct ReplayPosition {
+    std::uint64_t first_run = 0;
+    std::uint64_t runs = 0;
+    std::uint64_t start_tick = 0;
+    std::uint64_t tick = 0;
+    std::uint64_t last_charge = 0;
+
+    bool closed() const { return last_charge == tick; }
+};
+
+struct CheckpointHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t state_count;
+    std::uint64_t first_run;
+    std::uint64_t runs;
+    std::uint64_t start_tick;
+    std::uint64_t tick;
+    std::uint64_t last_charge;
+    std::int32_t previous_status;
+    std::int32_t first_status;
+    std::uint64_t transition_count;
+    std::uint64_t total_ticks;
+    double energy_sum[2];
+    double transition_energy_sum[2];
+    std::uint64_t ticks_per_second;  // 0 in files written before it existed: seconds
+    std::uint64_t reserved;
+};
+
+static_assert(sizeof(CheckpointHeader) == 128, "CheckpointHeader must stay 128 bytes");
+
+// Writes `accumulator` at `position` to `path`. The file is written next to
+// `path` and renamed over it, so an interrupted write leaves the previous
+// checkpoint intact. Throws std::runtime_error if it cannot be written.
+void writeCheckpoint(const std::string& path, const EnergyAccumulator& accumulator,
+                     const ReplayPosition& position);
+
+// Restores a checkpoint into `accumulator` and returns its position. The
+// accumulator's table must have the same state powers the checkpoint was
+// written with, and ticksPerSecond() its time resolution. Throws
+// std::runtime_error otherwise or if the file is not a valid checkpoint.
+ReplayPosition readCheckpoint(const std::string& path, EnergyAccumulator& accumulator);
+
+// Time resolution (ticks per second) `path` was written at. Throws
+// std::runtime_error if it is not a valid checkpoint.
+std::uint64_t checkpointTicksPerSecond(const std::string& path);
+
+// Skips the first `count` runs of `reader` and returns the ticks they
+// cover. Throws std::runtime_error if the trace has fewer runs.
+std::uint64_t skipRuns(TraceReader& reader, std::uint64_t count);
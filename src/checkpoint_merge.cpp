@@ -0,0 +1,138 @@
+/**
+ * checkpoint_merge.cpp
+ *
+ * Merges checkpoints of consecutive trace segments into the result of one
+ * pass over the whole range:
+ *
+ *   checkpoint_merge [--power-table <table.csv>] [--transition-costs <transitions.csv>]
+ *                    [--output <merged.ckpt>] [--validation <validation.csv>]
+ *                    [--reference <reference.csv>] <segment.ckpt> [<segment.ckpt> ...]
+ *
+ * Segments are written by `testbench_dvconchallenge --fast --segment
+ * FIRST:COUNT --checkpoint <file>`, may be given in any order and must cover
+ * a contiguous range of runs. The power table and transition costs must be
+ * the ones the segments were replayed with. The validation report compares
+ * against --reference; without one its measured columns are nan, since a
+ * checkpoint does not record the measurement of its trace.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "checkpoint.h"
+#include "power_model.h"
+#include "power_table.h"
+#include "transition_matrix.h"
+#include "validation.h"
+
+namespace {
+
+struct Segment {
+    std::string path;
+    EnergyAccumulator accumulator;
+    ReplayPosition position;
+};
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " [--power-table <table.csv>] [--transition-costs <transitions.csv>]"
+              << " [--output <merged.ckpt>] [--validation <validation.csv>]"
+              << " [--reference <reference.csv>] <segment.ckpt> [<segment.ckpt> ...]" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> segment_paths;
+    std::string power_table_path;
+    std::string transition_costs_path;
+    std::string output_path;
+    std::string validation_path;
+    std::string reference_path;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--power-table" && i + 1 < argc) {
+            power_table_path = argv[++i];
+        } else if (arg == "--transition-costs" && i + 1 < argc) {
+            transition_costs_path = argv[++i];
+        } else if (arg == "--output" && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (arg == "--validation" && i + 1 < argc) {
+            validation_path = argv[++i];
+        } else if (arg == "--reference" && i + 1 < argc) {
+            reference_path = argv[++i];
+        } else if (!arg.empty() && arg[0] != '-') {
+            segment_paths.push_back(arg);
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (segment_paths.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        const ValidationReference reference =
+            reference_path.empty() ? noReference() : ValidationReference::load(reference_path);
+        PowerTable table = power_table_path.empty() ? PowerTable::builtin()
+                                                    : PowerTable::load(power_table_path);
+        std::unique_ptr<TransitionMatrix> transition_costs;
+        if (!transition_costs_path.empty()) {
+            transition_costs.reset(new TransitionMatrix(TransitionMatrix::load(transition_costs_path, table)));
+        }
+
+        // Segments of one trace share its time resolution.
+        setTicksPerSecond(checkpointTicksPerSecond(segment_paths.front()));
+        std::vector<Segment> segments;
+        for (const std::string& path : segment_paths) {
+            Segment segment{path, EnergyAccumulator(table), ReplayPosition()};
+            segment.accumulator.transition_costs = transition_costs.get();
+            segment.position = readCheckpoint(path, segment.accumulator);
+            if (!segment.position.closed()) {
+                throw std::runtime_error(path + " is a periodic checkpoint, not a finished segment");
+            }
+            segments.push_back(std::move(segment));
+        }
+        std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) {
+            return a.position.first_run < b.position.first_run;
+        });
+
+        EnergyAccumulator& merged = segments.front().accumulator;
+        ReplayPosition position = segments.front().position;
+        for (std::size_t i = 1; i < segments.size(); i++) {
+            const Segment& next = segments[i];
+            if (next.position.first_run != position.runs || next.position.start_tick != position.tick) {
+                throw std::runtime_error(next.path + " starts at run " +
+                                         std::to_string(next.position.first_run) +
+                                         ", expected run " + std::to_string(position.runs));
+            }
+            merged.merge(next.accumulator);
+            position.runs = next.position.runs;
+            position.tick = next.position.tick;
+            position.last_charge = next.position.last_charge;
+        }
+
+        std::cout << "Merged " << segments.size() << " segments: runs " << position.first_run << "-"
+                  << position.runs << ", " << merged.transition_count << " transitions, "
+                  << ticksToSeconds(merged.total_ticks) << " s" << std::endl;
+        std::cout << "Total Energy: " << merged.energyEstimation << " J" << std::endl;
+
+        if (!output_path.empty()) {
+            writeCheckpoint(output_path, merged, position);
+            std::cout << "✓ Checkpoint written: " << output_path << std::endl;
+        }
+        if (!validation_path.empty()) {
+            generateValidationCSV(merged, validation_path, reference);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,34 @@
+/**
+ * compensated_sum.h
+ *
+ * Neumaier (improved Kahan) summation. The running compensation keeps the
+ * rounding error of long sums of small increments bounded independently of
+ * the number of terms, at the cost of a few extra additions per term.
+ */
+
+#pragma once
+
+#include <cmath>
+
+struct CompensatedSum {
+    double sum = 0.0;
+    double compensation = 0.0;
+
+    void add(double value) {
+        const double total = sum + value;
+        if (std::fabs(sum) >= std::fabs(value)) {
+            compensation += (sum - total) + value;
+        } else {
+            compensation += (value - total) + sum;
+        }
+        sum = total;
+    }
+
+    // Adds another sum, e.g. of a later segment of the same series.
+    void merge(const CompensatedSum& other) {
+        add(other.sum);
+        compensation += other.compensation;
+    }
+
+    double value() const { return sum + compensation; }
+};
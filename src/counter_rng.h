@@ -0,0 +1,73 @@
+/**
+ * counter_rng.h
+ *
+ * Counter-based random numbers (Philox4x32-10, Salmon et al., SC'11). Every
+ * output block is a pure function of (key, counter), so stream k of seed s
+ * can be produced on any thread, in any order, and always yields the same
+ * numbers: no generator state has to be shared or handed between threads.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// One Philox4x32-10 block: four 32-bit outputs for a 128-bit counter and a
+// 64-bit key.
+inline std::array<std::uint32_t, 4> philox4x32(std::array<std::uint32_t, 4> counter,
+                                               std::array<std::uint32_t, 2> key) {
+    const std::uint32_t M0 = 0xD2511F53u;
+    const std::uint32_t M1 = 0xCD9E8D57u;
+    const std::uint32_t W0 = 0x9E3779B9u;
+    const std::uint32_t W1 = 0xBB67AE85u;
+    for (int round = 0; round < 10; round++) {
+        if (round > 0) {
+            key[0] += W0;
+            key[1] += W1;
+        }
+        const std::uint64_t product0 = static_cast<std::uint64_t>(M0) * counter[0];
+        const std::uint64_t product1 = static_cast<std::uint64_t>(M1) * counter[2];
+        counter = {static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+                   static_cast<std::uint32_t>(product1),
+                   static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+                   static_cast<std::uint32_t>(product0)};
+    }
+    return counter;
+}
+
+// Uniform doubles from stream `stream` of seed `seed`. The key is the seed
+// and the counter holds the stream and the block index, so 2^64 streams of
+// 2^64 blocks each never overlap.
+class CounterRng {
+public:
+    CounterRng(std::uint64_t seed, std::uint64_t stream)
+        : key{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)},
+          stream_lo(static_cast<std::uint32_t>(stream)),
+          stream_hi(static_cast<std::uint32_t>(stream >> 32)) {}
+
+    // Uniform in [0, 1) with 53 random bits.
+    double uniform() {
+        if (available == 0) {
+            block = philox4x32({static_cast<std::uint32_t>(index), static_cast<std::uint32_t>(index >> 32),
+                                stream_lo, stream_hi},
+                               key);
+            index++;
+            available = 2;
+        }
+        const int word = 4 - 2 * available;
+        available--;
+        const std::uint64_t bits = (static_cast<std::uint64_t>(block[word]) << 21) ^ (block[word + 1] >> 11);
+        return static_cast<double>(bits) * (1.0 / 9007199254740992.0);  // 2^-53
+    }
+
+    // Blocks consumed so far.
+    std::uint64_t position() const { return index; }
+
+private:
+    std::array<std::uint32_t, 2> key;
+    std::uint32_t stream_lo;
+    std::uint32_t stream_hi;
+    std::uint64_t index = 0;
+    std::array<std::uint32_t, 4> block = {};
+    int available = 0;
+};
@@ -0,0 +1,106 @@
+/**
+ * decoupled_accumulator.cpp
+ */
+
+#include "decoupled_accumulator.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+bool earlierTick(const std::pair<std::uint64_t, int>& a, const std::pair<std::uint64_t, int>& b) {
+    return a.first < b.first;
+}
+
+} // namespace
+
+DecoupledAccumulator::DecoupledAccumulator(const PowerTable& table, TransitionLog* log)
+    : result(table), log(log && log->active() ? log : nullptr) {
+}
+
+void DecoupledAccumulator::change(std::uint64_t tick, int status) {
+    if (tick < synced) {
+        throw std::runtime_error("state change at tick " + std::to_string(tick) +
+                                 " precedes the synced time " + std::to_string(synced));
+    }
+    pending.emplace_back(tick, status);
+}
+
+void DecoupledAccumulator::syncTo(std::uint64_t tick) {
+    if (tick <= synced) {
+        return;
+    }
+    fold(tick);
+    synced = tick;
+}
+
+double DecoupledAccumulator::energyAt(std::uint64_t tick) {
+    syncTo(tick);
+    double energy_value = result.energyEstimation;
+    if (result.previous_status >= 0 && tick > last_transition) {
+        energy_value += result.powerEstimation * ticksToSeconds(tick - last_transition);
+    }
+    return energy_value;
+}
+
+double DecoupledAccumulator::finish(std::uint64_t end_tick) {
+    fold(std::numeric_limits<std::uint64_t>::max());
+    synced = std::max(synced, end_tick);
+    if (result.previous_status < 0) {
+        return 0.0;
+    }
+    const std::uint64_t end = std::max(end_tick, last_transition);
+    const double final_energy = result.charge(end - last_transition);
+    if (log) {
+        log->finish(ticksToSeconds(end), result.previous_status, final_energy,
+                    result.energyEstimation);
+    }
+    last_transition = end;
+    return final_energy;
+}
+
+void DecoupledAccumulator::fold(std::uint64_t limit) {
+    // A single decoupled initiator reports changes in order; several may
+    // interleave, so restore time order (keeping arrival order per tick).
+    if (!std::is_sorted(pending.begin(), pending.end(), earlierTick)) {
+        std::stable_sort(pending.begin(), pending.end(), earlierTick);
+    }
+
+    std::size_t i = 0;
+    while (i < pending.size() && pending[i].first < limit) {
+        // Of several changes at one tick only the last reaches the monitor.
+        std::size_t last = i;
+        while (last + 1 < pending.size() && pending[last + 1].first == pending[i].first) {
+            last++;
+        }
+        apply(pending[last].first, pending[last].second);
+        i = last + 1;
+    }
+    pending.erase(pending.begin(), pending.begin() + i);
+}
+
+void DecoupledAccumulator::apply(std::uint64_t tick, int status) {
+    if (status == result.previous_status) {
+        return;
+    }
+    const int from_state = result.previous_status;
+    double energy_increment = 0.0;
+    if (from_state >= 0) {
+        energy_increment = result.charge(tick - last_transition);
+    }
+    result.enter(status);
+    if (log) {
+        TransitionEvent event;
+        event.time = ticksToSeconds(tick);
+        event.from_state = from_state;
+        event.to_state = status;
+        event.energy = energy_increment;
+        event.total_energy = result.energyEstimation;
+        event.power = result.powerEstimation;
+        log->transition(event);
+    }
+    last_transition = tick;
+}
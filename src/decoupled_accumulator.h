@@ -0,0 +1,61 @@
+/**
+ * decoupled_accumulator.h
+ *
+ * Lazy energy integration for temporally decoupled callers. State changes
+ * are recorded with their own timestamps, which may run ahead of (and
+ * arrive out of order with respect to) the caller's notion of global time,
+ * and are only folded into an EnergyAccumulator when the caller syncs or
+ * queries the energy. Changes follow the same signal semantics as the
+ * monitor: of several changes at the same tick the last one wins, and a
+ * change to the current state is not a transition.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "event_log.h"
+#include "power_model.h"
+
+class DecoupledAccumulator {
+public:
+    explicit DecoupledAccumulator(const PowerTable& table = PowerTable::builtin(),
+                                  TransitionLog* log = nullptr);
+
+    // Records a change to `status` at `tick`. Throws std::runtime_error if
+    // `tick` precedes the synced time, i.e. time already integrated.
+    void change(std::uint64_t tick, int status);
+
+    // Integrates every recorded change before `tick`. Changes at or after
+    // `tick` stay pending. Later changes must not precede `tick`.
+    void syncTo(std::uint64_t tick);
+
+    // Energy up to `tick`, including the open interval of the current
+    // state; syncs to `tick` first.
+    double energyAt(std::uint64_t tick);
+
+    // Integrates all pending changes and charges the final state up to
+    // `end_tick`. Returns the energy of that final interval.
+    double finish(std::uint64_t end_tick);
+
+    // The accumulator changes are folded into. Outputs and costs (time
+    // series, transition costs) may be attached before the first change.
+    EnergyAccumulator& accumulator() { return result; }
+    const EnergyAccumulator& accumulator() const { return result; }
+    std::uint64_t syncedTick() const { return synced; }
+    std::size_t pendingCount() const { return pending.size(); }
+
+private:
+    void fold(std::uint64_t limit);
+    void apply(std::uint64_t tick, int status);
+
+    EnergyAccumulator result;
+    TransitionLog* log;
+
+    // Unintegrated changes as (tick, status), in arrival order.
+    std::vector<std::pair<std::uint64_t, int>> pending;
+    std::uint64_t synced = 0;
+    std::uint64_t last_transition = 0;
+};
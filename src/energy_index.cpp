@@ -0,0 +1,47 @@
+/**
+ * energy_index.cpp
+ */
+
+#include "energy_index.h"
+
+#include <algorithm>
+
+double EnergyIndex::energyAt(std::uint64_t tick) const {
+    if (tick >= now) {
+        return total.value();
+    }
+    // Last entry starting at or before `tick`.
+    const auto after = std::upper_bound(entries.begin(), entries.end(), tick,
+                                        [](std::uint64_t t, const Entry& entry) { return t < entry.start; });
+    if (after == entries.begin()) {
+        return 0.0;
+    }
+    const Entry& entry = *(after - 1);
+    return entry.before + entry.power * static_cast<double>(tick - entry.start);
+}
+
+double EnergyIndex::stateEnergyAt(int state, std::uint64_t tick) const {
+    if (state < 0 || state >= stateCount()) {
+        return 0.0;
+    }
+    const std::vector<std::size_t>& list = state_entries[state];
+    const auto after = std::upper_bound(list.begin(), list.end(), tick,
+                                        [this](std::uint64_t t, std::size_t e) { return t < entries[e].start; });
+    if (after == list.begin()) {
+        return 0.0;
+    }
+    const Entry& entry = entries[*(after - 1)];
+    const std::uint64_t elapsed = std::min(tick - entry.start, entry.ticks);
+    if (elapsed == entry.ticks && after == list.end()) {
+        return state_total[state].value();
+    }
+    return entry.state_before + entry.power * static_cast<double>(elapsed);
+}
+
+double EnergyIndex::energy(std::uint64_t from, std::uint64_t to) const {
+    return to > from ? energyAt(to) - energyAt(from) : 0.0;
+}
+
+double EnergyIndex::stateEnergy(int state, std::uint64_t from, std::uint64_t to) const {
+    return to > from ? stateEnergyAt(state, to) - stateEnergyAt(state, from) : 0.0;
+}
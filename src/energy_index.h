@@ -0,0 +1,83 @@
+/**
+ * energy_index.h
+ *
+ * Prefix sums of model energy over simulation time. The accumulator appends
+ * one entry per charged interval (start tick, state, power and the energy
+ * charged before it), so the index grows as a replay advances and can be
+ * queried at any point: the energy of a time range is two binary searches
+ * and a subtraction, whatever the length of the trace. Per-state energies
+ * use a second prefix over the entries of each state. Ticks are counted
+ * from the first charged interval, which is tick 0 of a fresh replay.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "compensated_sum.h"
+
+class EnergyIndex {
+public:
+    // Charged `energy` for `ticks` ticks in `state`, directly after the
+    // previous interval.
+    void add(int state, std::uint64_t ticks, double energy) {
+        if (ticks == 0) {
+            return;
+        }
+        if (static_cast<std::size_t>(state) >= state_total.size()) {
+            state_total.resize(static_cast<std::size_t>(state) + 1);
+            state_entries.resize(static_cast<std::size_t>(state) + 1);
+        }
+        Entry entry;
+        entry.start = now;
+        entry.ticks = ticks;
+        entry.state = state;
+        entry.power = energy / static_cast<double>(ticks);
+        entry.before = total.value();
+        entry.state_before = state_total[state].value();
+        state_entries[state].push_back(entries.size());
+        entries.push_back(entry);
+
+        now += ticks;
+        total.add(energy);
+        state_total[state].add(energy);
+    }
+
+    // Switching energy charged at the current tick; it counts towards the
+    // ranges that end at or after the tick and start before it.
+    void addSwitch(double energy) { total.add(energy); }
+
+    // Ticks indexed so far; queries are clipped to [0, end()).
+    std::uint64_t end() const { return now; }
+    double totalEnergy() const { return total.value(); }
+
+    // Model energy charged (including switching energy) in [from, to).
+    double energy(std::uint64_t from, std::uint64_t to) const;
+
+    // Energy charged for `state` in [from, to), without switching energy.
+    double stateEnergy(int state, std::uint64_t from, std::uint64_t to) const;
+
+    int stateCount() const { return static_cast<int>(state_total.size()); }
+
+private:
+    struct Entry {
+        std::uint64_t start = 0;
+        std::uint64_t ticks = 0;
+        int state = 0;
+        double power = 0.0;         // energy per tick
+        double before = 0.0;        // total energy before the entry
+        double state_before = 0.0;  // energy of `state` before the entry
+    };
+
+    // Total energy charged before `tick`.
+    double energyAt(std::uint64_t tick) const;
+    double stateEnergyAt(int state, std::uint64_t tick) const;
+
+    std::vector<Entry> entries;
+    std::vector<std::vector<std::size_t>> state_entries;
+    std::uint64_t now = 0;
+    CompensatedSum total;
+    std::vector<CompensatedSum> state_total;
+};
@@ -0,0 +1,167 @@
+/**
+ * event_log.cpp
+ */
+
+#include "event_log.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+Verbosity current_verbosity = Verbosity::Transitions;
+
+const char EVENT_LOG_MAGIC[8] = {'D', 'V', 'C', 'E', 'V', 'L', 'O', 'G'};
+const std::uint32_t EVENT_LOG_VERSION = 1;
+
+// On-disk layout of one binary event record (little-endian).
+struct EventRecord {
+    double time;
+    std::int32_t from_state;
+    std::int32_t to_state;
+    double energy;
+    double total_energy;
+    double power;
+};
+
+static_assert(sizeof(EventRecord) == 40, "EventRecord must stay 40 bytes");
+
+} // namespace
+
+void setVerbosity(Verbosity level) {
+    current_verbosity = level;
+}
+
+Verbosity verbosity() {
+    return current_verbosity;
+}
+
+Verbosity parseVerbosity(const std::string& text) {
+    if (text == "quiet" || text == "0") {
+        return Verbosity::Quiet;
+    }
+    if (text == "summary" || text == "1") {
+        return Verbosity::Summary;
+    }
+    if (text == "transitions" || text == "2") {
+        return Verbosity::Transitions;
+    }
+    throw std::runtime_error("unknown verbosity '" + text + "' (expected quiet, summary or transitions)");
+}
+
+EventLogSink::Format parseEventLogFormat(const std::string& text) {
+    if (text == "csv") {
+        return EventLogSink::Format::Csv;
+    }
+    if (text == "binary") {
+        return EventLogSink::Format::Binary;
+    }
+    throw std::runtime_error("unknown event log format '" + text + "' (expected csv or binary)");
+}
+
+EventLogSink::EventLogSink(const std::string& path, Format format, std::size_t buffer_size)
+    : path(path), file(path, std::ios::binary | std::ios::trunc), format(format),
+      buffer(buffer_size > 256 ? buffer_size : 256) {
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not create event log " + path);
+    }
+
+    if (format == Format::Csv) {
+        static const char header[] = "Time_s,From_State,To_State,Energy_J,Total_Energy_J,Power_W\n";
+        append(header, sizeof(header) - 1);
+    } else {
+        const std::uint32_t version = EVENT_LOG_VERSION;
+        const std::uint32_t record_size = sizeof(EventRecord);
+        append(EVENT_LOG_MAGIC, sizeof(EVENT_LOG_MAGIC));
+        append(reinterpret_cast<const char*>(&version), sizeof(version));
+        append(reinterpret_cast<const char*>(&record_size), sizeof(record_size));
+    }
+}
+
+EventLogSink::~EventLogSink() {
+    try {
+        flush();
+    } catch (...) {
+    }
+}
+
+void EventLogSink::append(const char* data, std::size_t size) {
+    if (used + size > buffer.size()) {
+        flush();
+    }
+    std::memcpy(buffer.data() + used, data, size);
+    used += size;
+}
+
+void EventLogSink::record(const TransitionEvent& event) {
+    if (format == Format::Csv) {
+        char line[192];
+        const int length = std::snprintf(line, sizeof(line), "%.12g,%d,%d,%.12g,%.12g,%.12g\n",
+                                         event.time, event.from_state, event.to_state,
+                                         event.energy, event.total_energy, event.power);
+        append(line, static_cast<std::size_t>(length));
+    } else {
+        EventRecord packed;
+        packed.time = event.time;
+        packed.from_state = event.from_state;
+        packed.to_state = event.to_state;
+        packed.energy = event.energy;
+        packed.total_energy = event.total_energy;
+        packed.power = event.power;
+        append(reinterpret_cast<const char*>(&packed), sizeof(packed));
+    }
+    records++;
+}
+
+void EventLogSink::flush() {
+    if (used > 0) {
+        file.write(buffer.data(), static_cast<std::streamsize>(used));
+        used = 0;
+    }
+    file.flush();
+    if (!file) {
+        throw std::runtime_error("Could not write event log " + path);
+    }
+}
+
+TransitionLog::TransitionLog(EventLogSink* sink)
+    : console(logEnabled(Verbosity::Transitions)), sink(sink) {
+}
+
+void TransitionLog::transition(const TransitionEvent& event) {
+    if (console) {
+        // '\n' rather than std::endl: the stream is flushed once at the end.
+        if (event.from_state >= 0) {
+            std::cout << "State " << event.from_state
+                      << " consumed " << event.energy << " J"
+                      << " (Total: " << event.total_energy << " J)" << '\n';
+        }
+        std::cout << "Transitioned to state " << event.to_state
+                  << " (Power: " << event.power << " W)" << '\n';
+    }
+    if (sink) {
+        sink->record(event);
+    }
+}
+
+void TransitionLog::finish(double time, int state, double energy, double total_energy) {
+    if (sink) {
+        TransitionEvent event;
+        event.time = time;
+        event.from_state = state;
+        event.energy = energy;
+        event.total_energy = total_energy;
+        sink->record(event);
+    }
+}
+
+void TransitionLog::flush() {
+    if (console) {
+        std::cout.flush();
+    }
+    if (sink) {
+        sink->flush();
+    }
+}
@@ -0,0 +1,95 @@
+/**
+ * event_log.h
+ *
+ * Console verbosity and buffered per-transition event logging. Console
+ * lines are written without flushing, and the optional file sink collects
+ * records in a large buffer, so logging stays off the critical path of
+ * long traces. Both can be switched off entirely for batch runs.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+enum class Verbosity {
+    Quiet = 0,        // errors only
+    Summary = 1,      // validation and totals
+    Transitions = 2   // one line per transition (default)
+};
+
+void setVerbosity(Verbosity level);
+Verbosity verbosity();
+
+inline bool logEnabled(Verbosity level) {
+    return static_cast<int>(verbosity()) >= static_cast<int>(level);
+}
+
+// Accepts "quiet", "summary", "transitions" or 0-2; throws otherwise.
+Verbosity parseVerbosity(const std::string& text);
+
+struct TransitionEvent {
+    double time = 0.0;          // seconds
+    int from_state = -1;        // -1 for the first transition
+    int to_state = -1;          // -1 for the end-of-trace record
+    double energy = 0.0;        // energy charged for from_state
+    double total_energy = 0.0;
+    double power = 0.0;         // power of to_state
+};
+
+// Buffered file sink for transition events, as CSV or packed binary
+// records. The buffer is written out when full and on flush/destruction.
+class EventLogSink {
+public:
+    enum class Format { Csv, Binary };
+
+    static constexpr std::size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+    EventLogSink(const std::string& path, Format format,
+                 std::size_t buffer_size = DEFAULT_BUFFER_SIZE);
+    ~EventLogSink();
+
+    EventLogSink(const EventLogSink&) = delete;
+    EventLogSink& operator=(const EventLogSink&) = delete;
+
+    void record(const TransitionEvent& event);
+    void flush();
+
+    std::uint64_t recordCount() const { return records; }
+
+private:
+    void append(const char* data, std::size_t size);
+
+    std::string path;
+    std::ofstream file;
+    Format format;
+    std::vector<char> buffer;
+    std::size_t used = 0;
+    std::uint64_t records = 0;
+};
+
+// Accepts "csv" or "binary"; throws otherwise.
+EventLogSink::Format parseEventLogFormat(const std::string& text);
+
+// Fans transition events out to the console (at Verbosity::Transitions)
+// and to an optional file sink. Monitors skip building events entirely when
+// active() is false.
+class TransitionLog {
+public:
+    explicit TransitionLog(EventLogSink* sink = nullptr);
+
+    bool active() const { return console || sink; }
+
+    void transition(const TransitionEvent& event);
+
+    // Records the final state's charge at the end of the trace.
+    void finish(double time, int state, double energy, double total_energy);
+
+    void flush();
+
+private:
+    bool console;
+    EventLogSink* sink;
+};
@@ -0,0 +1,261 @@
+/**
+ * fast_engine.cpp
+ */
+
+#include "fast_engine.h"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+#include "profiling.h"
+#include "thread_pool.h"
+
+namespace {
+
+// Shards per worker, so that work stealing evens out shards that happen
+// to be slower than others.
+const std::size_t SHARDS_PER_WORKER = 4;
+
+std::size_t shardCount(unsigned& workers, std::size_t shards) {
+    if (workers == 0) {
+        workers = defaultWorkerCount();
+    }
+    return shards > 0 ? shards : SHARDS_PER_WORKER * workers;
+}
+
+// Integrates shard i of `count` with a reader from makeReader(i) and merges
+// the shards in order. Returns the final state energy of the last shard
+// that had any runs.
+double integrateShards(std::size_t count, unsigned workers, EnergyAccumulator& accumulator,
+                       const std::function<std::unique_ptr<TraceReader>(std::size_t)>& makeReader) {
+    if (accumulator.previous_status >= 0 || accumulator.power_row || accumulator.timeseries ||
+        accumulator.energy_index || accumulator.domain_energy) {
+        throw std::runtime_error("parallel replay needs a fresh accumulator without power rows, time series, "
+                                 "energy index or power domains");
+    }
+
+    std::vector<EnergyAccumulator> parts(count, EnergyAccumulator(*accumulator.table));
+    std::vector<double> final_energy(count, 0.0);
+    parallelFor(count, workers, [&](std::size_t index, unsigned) {
+        parts[index].transition_costs = accumulator.transition_costs;
+        std::unique_ptr<TraceReader> reader = makeReader(index);
+        final_energy[index] = integrateTrace(*reader, parts[index]);
+    });
+
+    double last_final_energy = 0.0;
+    for (std::size_t i = 0; i < count; i++) {
+        if (parts[i].previous_status >= 0) {
+            accumulator.merge(parts[i]);
+            last_final_energy = final_energy[i];
+        }
+    }
+    return last_final_energy;
+}
+
+} // namespace
+
+double integrateTrace(TraceReader& reader, EnergyAccumulator& accumulator,
+                      TransitionLog* log, const ThermalSchedule* thermal,
+                      ReplayControl* control) {
+    PROFILE_SCOPE(Integration);
+    if (log && !log->active()) {
+        log = nullptr;
+    }
+
+    std::uint64_t now = control ? control->position.tick : 0;
+    std::uint64_t last_charge = control ? control->position.last_charge : 0;
+    std::uint64_t runs = control ? control->position.runs : 0;
+    const std::uint64_t run_limit = control ? control->run_limit : std::numeric_limits<std::uint64_t>::max();
+    const std::uint64_t checkpoint_every = control && control->checkpoint ? control->checkpoint_every : 0;
+    const double energy_limit = control ? control->energy_limit : std::numeric_limits<double>::infinity();
+    bool depleted = false;
+
+    // Temperature steps split the current state's interval; the pieces are
+    // reported as one transition energy.
+    std::size_t next_step = 0;
+    double pending_energy = 0.0;
+    if (thermal) {
+        accumulator.setPowerRow(thermal->initialRow());
+    }
+    auto advanceTemperature = [&](std::uint64_t until) {
+        while (thermal && next_step < thermal->stepCount() && thermal->stepTick(next_step) < until) {
+            const std::uint64_t tick = thermal->stepTick(next_step);
+            if (accumulator.previous_status >= 0 && tick > last_charge) {
+                pending_energy += accumulator.charge(tick - last_charge);
+                last_charge = tick;
+            }
+            accumulator.setPowerRow(thermal->stepRow(next_step));
+            next_step++;
+        }
+    };
+
+    // Charges the current state up to `now`. Power is constant in between,
+    // so the time at which the energy limit was crossed is interpolated.
+    auto chargeToNow = [&]() {
+        const double before = accumulator.energyEstimation;
+        const double energy = accumulator.charge(now - last_charge);
+        if (!depleted && accumulator.energyEstimation >= energy_limit) {
+            depleted = true;
+            control->depletion = std::min(ticksToSeconds(now),
+                                          ticksToSeconds(last_charge) +
+                                              (energy_limit - before) / accumulator.powerEstimation);
+        }
+        return energy;
+    };
+
+    // Mirror the status signal: a write only reaches the monitor if it
+    // changes the value, and of several writes at the same time the last
+    // one wins.
+    int signal = control ? accumulator.previous_status : -1;
+    int written = -1;
+    bool write_pending = false;
+
+    auto apply = [&](int status) {
+        if (status == signal) {
+            return;
+        }
+        advanceTemperature(now);
+        const int from_state = accumulator.previous_status;
+        double energy_increment = 0.0;
+        if (from_state >= 0) {
+            PROFILE_DURATION(now - last_charge);
+            energy_increment = pending_energy + chargeToNow();
+            if (depleted) {
+                last_charge = now;
+                return;
+            }
+        }
+        pending_energy = 0.0;
+        accumulator.enter(status);
+        if (!depleted && accumulator.energyEstimation >= energy_limit) {
+            // The switching energy itself emptied the battery.
+            depleted = true;
+            control->depletion = ticksToSeconds(now);
+        }
+        if (log) {
+            PROFILE_SCOPE(Logging);
+            TransitionEvent event;
+            event.time = ticksToSeconds(now);
+            event.from_state = from_state;
+            event.to_state = status;
+            event.energy = energy_increment;
+            event.total_energy = accumulator.energyEstimation;
+            event.power = accumulator.powerEstimation;
+            log->transition(event);
+        }
+        signal = status;
+        last_charge = now;
+    };
+
+    TraceRun run;
+    while (runs < run_limit && reader.next(run)) {
+        runs++;
+        written = run.state;
+        write_pending = true;
+        if (run.duration == 0) {
+            continue;
+        }
+        apply(written);
+        write_pending = false;
+        if (depleted) {
+            break;
+        }
+        now += run.duration;
+
+        if (checkpoint_every > 0 && (runs - control->position.first_run) % checkpoint_every == 0) {
+            ReplayPosition position = control->position;
+            position.runs = runs;
+            position.tick = now;
+            position.last_charge = last_charge;
+            control->checkpoint(accumulator, position);
+        }
+    }
+    if (write_pending) {
+        apply(written);
+    }
+
+    if (control) {
+        control->position.runs = runs;
+        control->position.tick = now;
+        control->position.last_charge = now;
+    }
+    if (accumulator.previous_status < 0) {
+        return 0.0;
+    }
+    advanceTemperature(now);
+    const double final_energy = pending_energy + chargeToNow();
+    if (log) {
+        log->finish(ticksToSeconds(now), accumulator.previous_status,
+                    final_energy, accumulator.energyEstimation);
+    }
+    return final_energy;
+}
+
+std::vector<std::uint64_t> shardBoundaries(const MappedTrace& trace, std::size_t shards) {
+    const std::uint64_t count = trace.size();
+    const std::uint16_t* states = trace.states();
+    std::vector<std::uint64_t> boundaries(1, 0);
+    for (std::size_t i = 1; i < shards; i++) {
+        std::uint64_t cut = count / shards * i + count % shards * i / shards;
+        if (cut <= boundaries.back()) {
+            continue;
+        }
+        while (cut < count && states[cut] == states[cut - 1]) {
+            cut++;
+        }
+        if (cut < count) {
+            boundaries.push_back(cut);
+        }
+    }
+    boundaries.push_back(count);
+    return boundaries;
+}
+
+double integrateTraceParallel(const MappedTrace& trace, EnergyAccumulator& accumulator,
+                              unsigned workers, std::size_t shards) {
+    if (!trace.hasStates()) {
+        throw std::runtime_error("binary trace has no state column");
+    }
+    const std::size_t requested = shardCount(workers, shards);
+    const std::vector<std::uint64_t> boundaries = shardBoundaries(trace, requested);
+    return integrateShards(boundaries.size() - 1, workers, accumulator, [&](std::size_t i) {
+        return std::unique_ptr<TraceReader>(new MappedRunReader(trace, boundaries[i], boundaries[i + 1]));
+    });
+}
+
+double integrateTraceParallel(const std::vector<TraceRun>& runs, EnergyAccumulator& accumulator,
+                              unsigned workers, std::size_t shards) {
+    // Runs never need to be split, so any run index is a valid cut as long
+    // as the run before it is not zero-length (its write would be lost).
+    const std::size_t requested = shardCount(workers, shards);
+    std::vector<std::size_t> boundaries(1, 0);
+    for (std::size_t i = 1; i < requested; i++) {
+        std::size_t cut = runs.size() / requested * i + runs.size() % requested * i / requested;
+        if (cut <= boundaries.back()) {
+            continue;
+        }
+        while (cut < runs.size() && runs[cut - 1].duration == 0) {
+            cut++;
+        }
+        if (cut < runs.size()) {
+            boundaries.push_back(cut);
+        }
+    }
+    boundaries.push_back(runs.size());
+    return integrateShards(boundaries.size() - 1, workers, accumulator, [&](std::size_t i) {
+        const TraceRun* data = runs.data();
+        return std::unique_ptr<TraceReader>(new SpanTraceReader(data + boundaries[i], data + boundaries[i + 1]));
+    });
+}
+
+double integrateTraceParallel(const TraceStore& store, EnergyAccumulator& accumulator,
+                              unsigned workers, std::size_t shards) {
+    // Indexed runs are never zero-length, so every run index is a valid cut.
+    const std::size_t runs = store.runCount();
+    const std::size_t count = std::min(shardCount(workers, shards), std::max<std::size_t>(runs, 1));
+    const auto boundary = [&](std::size_t i) { return runs / count * i + runs % count * i / count; };
+    return integrateShards(count, workers, accumulator, [&](std::size_t i) {
+        return std::unique_ptr<TraceReader>(new StoreRunReader(store, boundary(i), boundary(i + 1)));
+    });
+}
@@ -0,0 +1,77 @@
+/**
+ * fast_engine.h
+ *
+ * Analytic fast path: integrates piecewise-constant power straight from the
+ * transition list, without processes, signals or kernel time. The SystemC
+ * monitor remains the reference; this path reproduces its accumulator state
+ * bit for bit.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "binary_trace.h"
+#include "checkpoint.h"
+#include "event_log.h"
+#include "power_model.h"
+#include "thermal_table.h"
+#include "trace_reader.h"
+#include "trace_store.h"
+
+// Checkpointing and segment limits for integrateTrace().
+struct ReplayControl {
+    // In: where `reader` and the accumulator stand, e.g. after skipRuns()
+    // or readCheckpoint(). Out: where the replay ended (always closed).
+    ReplayPosition position;
+
+    // Absolute run index to stop at, for replaying one segment. The final
+    // state is charged up to the end of the segment's last run.
+    std::uint64_t run_limit = std::numeric_limits<std::uint64_t>::max();
+
+    // Called every `checkpoint_every` runs (0 = never) with the open
+    // position after that run.
+    std::uint64_t checkpoint_every = 0;
+    std::function<void(const EnergyAccumulator&, const ReplayPosition&)> checkpoint;
+
+    // Energy at which to stop, e.g. a battery capacity in J. The replay
+    // ends with the run during which the accumulated energy reaches it, and
+    // `depletion` receives the time in seconds at which it did (NaN if the
+    // trace ended first).
+    double energy_limit = std::numeric_limits<double>::infinity();
+    double depletion = std::numeric_limits<double>::quiet_NaN();
+};
+
+// Replays every run of `reader` into `accumulator`, including the final
+// state up to the end of the trace, and returns the energy charged for that
+// final state. Transitions are reported to `log` when one is given and
+// active. With a `thermal` schedule, power follows its rows: the energy
+// of a state is split at every temperature step inside it. With a
+// `control`, the replay resumes from and reports its position and may be
+// limited to a segment; it cannot be combined with `thermal`.
+double integrateTrace(TraceReader& reader, EnergyAccumulator& accumulator,
+                      TransitionLog* log = nullptr, const ThermalSchedule* thermal = nullptr,
+                      ReplayControl* control = nullptr);
+
+// Cut points for replaying `trace` in about `shards` pieces: ascending
+// sample indices from 0 to trace.size(), each placed at a state change so
+// that no run is split between shards.
+std::vector<std::uint64_t> shardBoundaries(const MappedTrace& trace, std::size_t shards);
+
+// Parallel integrateTrace() for one long trace: the trace is cut into
+// shards at state changes, each shard is integrated into its own
+// accumulator on `workers` threads (0 = all cores), and the shards are
+// merged in trace order into `accumulator`, which must be fresh. Results
+// equal a serial replay up to the rounding of the compensated sums. The
+// shard count defaults to four per worker. Transition logs, thermal
+// schedules, time series and checkpoints need the serial replay.
+double integrateTraceParallel(const MappedTrace& trace, EnergyAccumulator& accumulator,
+                              unsigned workers = 0, std::size_t shards = 0);
+double integrateTraceParallel(const std::vector<TraceRun>& runs, EnergyAccumulator& accumulator,
+                              unsigned workers = 0, std::size_t shards = 0);
+double integrateTraceParallel(const TraceStore& store, EnergyAccumulator& accumulator,
+                              unsigned workers = 0, std::size_t shards = 0);
@@ -0,0 +1,180 @@
+/**
+ * fleet.cpp
+ */
+
+#include "fleet.h"
+
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+
+Fleet::Fleet(const PowerTable& table) : table(&table), state_count(table.stateCount()) {
+    // The largest uint16_t id is NO_STATE.
+    if (state_count >= NO_STATE) {
+        throw std::runtime_error("fleet power table has " + std::to_string(state_count) +
+                                 " states, at most " + std::to_string(NO_STATE - 1) + " are supported");
+    }
+}
+
+std::size_t Fleet::addDevice(TraceReader& source, std::uint64_t start_tick) {
+    const std::size_t device = sources.size();
+    if (device >= 0xffffffffu) {
+        throw std::runtime_error("too many devices in fleet");
+    }
+
+    sources.push_back(&source);
+    state.push_back(NO_STATE);
+    last_tick.push_back(start_tick);
+    power.push_back(0.0);
+    transition_count.push_back(0);
+    device_finished.push_back(0);
+    device_energy.emplace_back();
+    state_energy.resize(state_energy.size() + state_count);
+    state_ticks.resize(state_ticks.size() + state_count, 0);
+
+    events.push(Event(start_tick, static_cast<std::uint32_t>(device)));
+    return device;
+}
+
+void Fleet::processUntil(std::uint64_t tick) {
+    while (!events.empty() && events.top().first <= tick) {
+        const Event event = events.top();
+        events.pop();
+        step(event.second, event.first);
+    }
+}
+
+void Fleet::run() {
+    while (!events.empty()) {
+        processUntil(events.top().first);
+    }
+}
+
+void Fleet::step(std::uint32_t device, std::uint64_t tick) {
+    // Same semantics as integrateTrace(): zero-length runs are overwritten
+    // by the next write at the same time, and writes that do not change the
+    // state are not transitions.
+    TraceReader& source = *sources[device];
+    TraceRun run;
+    int written = -1;
+    bool write_pending = false;
+    while (source.next(run)) {
+        written = run.state;
+        write_pending = true;
+        if (run.duration == 0) {
+            continue;
+        }
+        apply(device, written, tick);
+        events.push(Event(tick + run.duration, device));
+        return;
+    }
+    if (write_pending) {
+        apply(device, written, tick);
+    }
+
+    // End of the device's trace: charge the final state up to now.
+    charge(device, tick - last_tick[device]);
+    last_tick[device] = tick;
+    device_finished[device] = 1;
+}
+
+void Fleet::apply(std::uint32_t device, int status, std::uint64_t tick) {
+    if (state[device] != NO_STATE && status == state[device]) {
+        return;
+    }
+    if (!table->contains(status)) {
+        throw std::runtime_error("device " + std::to_string(device) + ": state " +
+                                 std::to_string(status) + " is not in the power table (" +
+                                 std::to_string(state_count) + " states)");
+    }
+    charge(device, tick - last_tick[device]);
+    state[device] = static_cast<std::uint16_t>(status);
+    power[device] = table->power(status);
+    transition_count[device]++;
+    last_tick[device] = tick;
+}
+
+void Fleet::charge(std::uint32_t device, std::uint64_t ticks) {
+    if (state[device] == NO_STATE) {
+        return;
+    }
+    // Same arithmetic as EnergyAccumulator::charge().
+    const double energy_increment = power[device] * ticksToSeconds(ticks);
+    const std::size_t slot = static_cast<std::size_t>(device) * state_count + state[device];
+    device_energy[device].add(energy_increment);
+    state_energy[slot].add(energy_increment);
+    state_ticks[slot] += ticks;
+}
+
+int Fleet::currentState(std::size_t device) const {
+    return state[device] == NO_STATE ? -1 : state[device];
+}
+
+double Fleet::energyAt(std::size_t device, std::uint64_t tick) const {
+    double energy_value = device_energy[device].value();
+    if (!device_finished[device] && state[device] != NO_STATE && tick > last_tick[device]) {
+        energy_value += power[device] * ticksToSeconds(tick - last_tick[device]);
+    }
+    return energy_value;
+}
+
+void Fleet::exportDevice(std::size_t device, EnergyAccumulator& accumulator) const {
+    if (accumulator.table->stateCount() != state_count) {
+        throw std::runtime_error("accumulator power table does not match the fleet");
+    }
+
+    accumulator.previous_status = currentState(device);
+    accumulator.powerEstimation = power[device];
+    accumulator.transition_count = transition_count[device];
+    accumulator.energy_sum = device_energy[device];
+    accumulator.energyEstimation = accumulator.energy_sum.value();
+    accumulator.total_ticks = 0;
+    for (int s = 0; s < state_count; s++) {
+        const std::size_t slot = device * state_count + s;
+        accumulator.state_energy_sum[s] = state_energy[slot];
+        accumulator.state_energy[s] = state_energy[slot].value();
+        accumulator.state_ticks[s] = state_ticks[slot];
+        accumulator.state_duration[s] = ticksToSeconds(state_ticks[slot]);
+        accumulator.total_ticks += state_ticks[slot];
+    }
+}
+
+double Fleet::totalEnergy() const {
+    CompensatedSum total;
+    for (const CompensatedSum& energy_value : device_energy) {
+        total.add(energy_value.value());
+    }
+    return total.value();
+}
+
+std::uint64_t Fleet::totalTransitions() const {
+    std::uint64_t total = 0;
+    for (std::uint32_t count : transition_count) {
+        total += count;
+    }
+    return total;
+}
+
+void Fleet::writeReport(const std::string& path) const {
+    std::ofstream csv_file(path);
+    if (!csv_file.is_open()) {
+        throw std::runtime_error("Could not create fleet report " + path);
+    }
+    csv_file << std::fixed << std::setprecision(6);
+    csv_file << "Device,Transitions,Energy_J";
+    for (int s = 0; s < state_count; s++) {
+        csv_file << ",State_" << s << "_Energy_J";
+    }
+    csv_file << "\n";
+    for (std::size_t device = 0; device < deviceCount(); device++) {
+        csv_file << device << "," << transition_count[device] << "," << energy(device);
+        for (int s = 0; s < state_count; s++) {
+            csv_file << "," << stateEnergy(device, s);
+        }
+        csv_file << "\n";
+    }
+    if (!csv_file) {
+        throw std::runtime_error("Could not write fleet report " + path);
+    }
+}
@@ -0,0 +1,100 @@
+/**
+ * fleet.h
+ *
+ * Many devices integrated side by side from one event queue. Device state
+ * is kept as structure-of-arrays (current state, last transition tick,
+ * cached power, per-state energy and time), so a device costs a couple of
+ * hundred bytes instead of a process with its own coroutine stack. Each
+ * device follows the same signal semantics and arithmetic as a single
+ * TestbenchModule/EnergyAccumulator pair.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "compensated_sum.h"
+#include "power_model.h"
+#include "trace_reader.h"
+
+class Fleet {
+public:
+    // Device states are stored in 16 bits, so `table` may have at most
+    // 65534 states; throws std::runtime_error for larger tables.
+    explicit Fleet(const PowerTable& table = PowerTable::builtin());
+
+    // Adds a device that replays `source` (not owned; must outlive the
+    // fleet) starting `start_tick` ticks into the simulation. Returns the
+    // device index.
+    std::size_t addDevice(TraceReader& source, std::uint64_t start_tick = 0);
+
+    std::size_t deviceCount() const { return sources.size(); }
+
+    bool hasEvents() const { return !events.empty(); }
+
+    // Tick of the earliest pending event; only valid if hasEvents().
+    std::uint64_t nextEventTick() const { return events.top().first; }
+
+    // Processes every event due at or before `tick`.
+    void processUntil(std::uint64_t tick);
+
+    // Processes all events; the fast path equivalent of running the kernel.
+    void run();
+
+    // Per-device results. Energy covers everything charged so far, i.e. up
+    // to the device's last transition, or to its end once it has finished.
+    int currentState(std::size_t device) const;
+    bool finished(std::size_t device) const { return device_finished[device] != 0; }
+    std::uint64_t transitions(std::size_t device) const { return transition_count[device]; }
+    double energy(std::size_t device) const { return device_energy[device].value(); }
+
+    // Energy including the open interval of the current state up to `tick`.
+    double energyAt(std::size_t device, std::uint64_t tick) const;
+
+    double stateEnergy(std::size_t device, int state) const {
+        return state_energy[device * state_count + state].value();
+    }
+
+    // Copies the device's results into `accumulator` (which must use the
+    // fleet's power table), e.g. for validation reports.
+    void exportDevice(std::size_t device, EnergyAccumulator& accumulator) const;
+
+    double totalEnergy() const;
+    std::uint64_t totalTransitions() const;
+
+    // Writes one CSV row per device: transitions, energy and per-state
+    // energy. Throws std::runtime_error if the file cannot be written.
+    void writeReport(const std::string& path) const;
+
+private:
+    static constexpr std::uint16_t NO_STATE = 0xffff;
+
+    // One step of device `device` at `tick`: apply its next run and
+    // schedule the one after, or charge its final state at the end.
+    void step(std::uint32_t device, std::uint64_t tick);
+    void apply(std::uint32_t device, int status, std::uint64_t tick);
+    void charge(std::uint32_t device, std::uint64_t ticks);
+
+    const PowerTable* table;
+    int state_count;
+
+    // Structure-of-arrays device state.
+    std::vector<TraceReader*> sources;
+    std::vector<std::uint16_t> state;
+    std::vector<std::uint64_t> last_tick;
+    std::vector<double> power;
+    std::vector<std::uint32_t> transition_count;
+    std::vector<std::uint8_t> device_finished;
+    std::vector<CompensatedSum> device_energy;
+    std::vector<CompensatedSum> state_energy;   // device * state_count + state
+    std::vector<std::uint64_t> state_ticks;     // device * state_count + state
+
+    // Min-heap of (tick, device); equal ticks are processed in device order.
+    typedef std::pair<std::uint64_t, std::uint32_t> Event;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+};
@@ -0,0 +1,41 @@
+/**
+ * fleet_monitor.h
+ *
+ * Drives a Fleet from the SystemC kernel with a single thread: it sleeps
+ * until the earliest device event and then applies every transition due at
+ * that time, however many devices the fleet holds.
+ */
+
+#pragma once
+
+#include <systemc>
+
+#include "event_log.h"
+#include "fleet.h"
+
+SC_MODULE(FleetMonitor) {
+    SC_HAS_PROCESS(FleetMonitor);
+
+    FleetMonitor(sc_core::sc_module_name name, Fleet& fleet)
+        : sc_core::sc_module(name), fleet(fleet) {
+        SC_THREAD(drive);
+    }
+
+    void drive() {
+        while (fleet.hasEvents()) {
+            const std::uint64_t next = fleet.nextEventTick();
+            const std::uint64_t now = sc_core::sc_time_stamp().value();
+            if (next > now) {
+                wait(sc_core::sc_time::from_value(next - now));
+            }
+            fleet.processUntil(next);
+        }
+
+        if (logEnabled(Verbosity::Summary)) {
+            std::cout << "Fleet replay complete (" << fleet.deviceCount() << " devices)" << std::endl;
+        }
+    }
+
+private:
+    Fleet& fleet;
+};
@@ -3,304 +3,987 @@
  */
 
  #include <systemc>
- #include <fstream>  // Add this for CSV output
- #include <iomanip>  // Add this for formatting
- 
- // Power constants for each state (in Watts)
- const double POWER_OFFICE = 1.0357;
- const double POWER_NOT_AT_WORK = 1.0215;
- const double POWER_REMOTE = 1.0284;
- const double POWER_OFFICE_BT = 1.0960;
- const double POWER_REMOTE_BT = 1.1500;
- const double POWER_NOT_AT_WORK_BT = 1.0925;
- const double POWER_DEFAULT = 1.0;
- 
- // Measured ground truth values from analysis
- const double MEASURED_TOTAL_ENERGY = 4262.89;  // Joules
- const double MEASURED_AVG_POWER = 1.0349;      // Watts
- const double MEASURED_DURATION = 4119.0;       // Seconds
- 
- // Per-state measured energy (from energy_analysis.csv)
- const double MEASURED_ENERGY_STATE[6] = {
-     3840.36,  // State 0: Office
-     268.66,   // State 1: Not at Work
-     131.64,   // State 2: Remote
-     10.96,    // State 3: Office BT
-     6.90,     // State 4: Remote BT
-     4.37      // State 5: Not at Work BT
- };
- 
- // Per-state measured duration (from state_characterization.csv)
- const int MEASURED_DURATION_STATE[6] = {
-     3708,  // State 0: Office
-     263,   // State 1: Not at Work
-     128,   // State 2: Remote
-     10,    // State 3: Office BT
-     6,     // State 4: Remote BT
-     4      // State 5: Not at Work BT
+ #include <algorithm>
+ #include <cstdint>
+ #include <memory>
+ #include <stdexcept>
+ #include <string>
+ #include <vector>
+
+ #include "checkpoint.h"
+ #include "binary_trace.h"
+ #include "energy_index.h"
+ #include "event_log.h"
+ #include "fast_engine.h"
+ #include "fleet.h"
+ #include "fleet_monitor.h"
+ #include "markov_generator.h"
+ #include "online_calibration.h"
+ #include "power_domains.h"
+ #include "power_model.h"
+ #include "power_table.h"
+ #include "profiling.h"
+ #include "temperature_source.h"
+ #include "thermal_table.h"
+ #include "timeseries.h"
+ #include "tlm_power_observer.h"
+ #include "trace_reader.h"
+ #include "transition_matrix.h"
+ #include "trace_source.h"
+ #include "trace_store.h"
+ #include "validation.h"
+
+ // Test sequence based on actual measurement data: {state, start, duration}
+ const std::vector<TraceRun> TEST_SEQUENCE = {
+     {1, 0, 10},
+     {0, 10, 143},
+     {4, 153, 6},
+     {2, 159, 128},
+     {0, 287, 84},
+     {5, 371, 4},
+     {1, 375, 231},
+     {0, 606, 2526},
+     {3, 3132, 10},
+     {0, 3142, 955},
+     {1, 4097, 22}
  };
- 
+
+ // Power monitor. The same handler runs either as an SC_THREAD that waits
+ // for the next status change, or as a stackless SC_METHOD that is
+ // triggered by it; both produce identical results.
  SC_MODULE(TestbenchModule) {
      sc_core::sc_port<sc_core::sc_signal_in_if<int>> status_input;
-     double powerEstimation = 0.0;
-     double energyEstimation = 0.0;
-     
-     int previous_status = -1;
-     sc_core::sc_time last_transition_time;
-     int transition_count = 0;
-     
-     // Per-state tracking
-     double state_energy[6] = {0.0};
-     double state_duration[6] = {0.0};  // Changed to double for seconds
- 
-     SC_CTOR(TestbenchModule) : status_input("input") {
-         SC_THREAD(processing);
+     EnergyAccumulator accumulator;
+     TransitionLog* transition_log = nullptr;
+
+     // Trace time at kernel time 0, non-zero when resuming a checkpoint.
+     std::uint64_t time_offset = 0;
+
+     // Trace tick charged up to, and energy of the current state charged
+     // before it (at temperature changes) that has not been reported yet.
+     std::uint64_t last_charge_tick = 0;
+     double pending_energy = 0.0;
+
+     enum class ProcessKind { Thread, Method };
+
+     SC_HAS_PROCESS(TestbenchModule);
+
+     explicit TestbenchModule(sc_core::sc_module_name name, ProcessKind kind = ProcessKind::Thread)
+         : sc_core::sc_module(name), status_input("input") {
+         if (kind == ProcessKind::Thread) {
+             SC_THREAD(processing);
+         } else {
+             SC_METHOD(statusChanged);
+         }
          sensitive << status_input;
          dont_initialize();
      }
- 
+
      void processing() {
-         last_transition_time = sc_core::sc_time_stamp();
-         previous_status = -1;
-         
          while (true) {
-             int status = status_input->read();
-             sc_core::sc_time current_time = sc_core::sc_time_stamp();
-             
-             if (previous_status >= 0) {
-                 sc_core::sc_time duration = current_time - last_transition_time;
-                 double duration_sec = duration.to_seconds();
-                 
-                 double prev_power = getPowerForState(previous_status);
-                 double energy_increment = prev_power * duration_sec;
-                 
-                 // Accumulate total energy
-                 energyEstimation += energy_increment;
-                 
-                 // Track per-state statistics
-                 if (previous_status >= 0 && previous_status < 6) {
-                     state_energy[previous_status] += energy_increment;
-                     state_duration[previous_status] += duration_sec;
-                 }
-                 
-                 std::cout << "State " << previous_status 
-                          << " consumed " << energy_increment << " J"
-                          << " (Total: " << energyEstimation << " J)" << std::endl;
-             }
-             
-             powerEstimation = getPowerForState(status);
-             
-             std::cout << "Transitioned to state " << status 
-                      << " (Power: " << powerEstimation << " W)" << std::endl;
-             
-             transition_count++;
-             previous_status = status;
-             last_transition_time = current_time;
-             
+             statusChanged();
              wait();
          }
      }
-     
-     void finalizeEnergy() {
-         if (previous_status >= 0) {
-             sc_core::sc_time final_time = sc_core::sc_time_stamp();
-             sc_core::sc_time duration = final_time - last_transition_time;
-             double duration_sec = duration.to_seconds();
-             
-             double final_power = getPowerForState(previous_status);
-             double final_energy = final_power * duration_sec;
-             
-             energyEstimation += final_energy;
-             
-             // Track final state
-             if (previous_status >= 0 && previous_status < 6) {
-                 state_energy[previous_status] += final_energy;
-                 state_duration[previous_status] += duration_sec;
-             }
-             
-             std::cout << "Final state " << previous_status 
-                      << " consumed " << final_energy << " J" << std::endl;
-             std::cout << "Total Energy: " << energyEstimation << " J" << std::endl;
-         }
-     }
-     
-     void validateResults() {
-         double error = std::abs(energyEstimation - MEASURED_TOTAL_ENERGY);
-         double error_percent = (error / MEASURED_TOTAL_ENERGY) * 100.0;
-         
-         std::cout << "\n=== VALIDATION ===" << std::endl;
-         std::cout << "Expected energy: " << MEASURED_TOTAL_ENERGY << " J" << std::endl;
-         std::cout << "Calculated energy: " << energyEstimation << " J" << std::endl;
-         std::cout << "Error: " << error << " J (" << error_percent << "%)" << std::endl;
-         
-         if (error_percent < 1.0) {
-             std::cout << "✓ PASS: Within 1% tolerance" << std::endl;
-         } else {
-             std::cout << "✗ FAIL: Exceeds 1% tolerance" << std::endl;
+
+     // Current trace time in ticks.
+     std::uint64_t nowTick() const {
+         return time_offset + sc_core::sc_time_stamp().value();
+     }
+
+     // Handles one status change.
+     void statusChanged() {
+         PROFILE_SCOPE(Monitor);
+         int status = status_input->read();
+         const std::uint64_t current_tick = nowTick();
+
+         int from_status = accumulator.previous_status;
+         double energy_increment = 0.0;
+         if (from_status >= 0) {
+             PROFILE_DURATION(current_tick - last_charge_tick);
+             energy_increment = pending_energy + accumulator.charge(current_tick - last_charge_tick);
          }
+         pending_energy = 0.0;
+
+         accumulator.enter(status);
+
+         if (transition_log) {
+             PROFILE_SCOPE(Logging);
+             TransitionEvent event;
+             event.time = ticksToSeconds(current_tick);
+             event.from_state = from_status;
+             event.to_state = status;
+             event.energy = energy_increment;
+             event.total_energy = accumulator.energyEstimation;
+             event.power = accumulator.powerEstimation;
+             transition_log->transition(event);
+         }
+
+         last_charge_tick = current_tick;
      }
-     
-     void generateValidationCSV() {
-         std::ofstream csv_file("model_vs_measurement.csv");
-         
-         if (!csv_file.is_open()) {
-             std::cerr << "Error: Could not create validation CSV file" << std::endl;
-             return;
+
+     // Switches to the power row of a new temperature, charging the current
+     // state at the old one first.
+     void temperatureChanged(const double* row) {
+         const std::uint64_t current_tick = nowTick();
+         if (accumulator.previous_status >= 0) {
+             pending_energy += accumulator.charge(current_tick - last_charge_tick);
+             last_charge_tick = current_tick;
+         }
+         accumulator.setPowerRow(row);
+     }
+
+     double finalizeEnergy() {
+         if (accumulator.previous_status < 0) {
+             return 0.0;
          }
-         
-         csv_file << std::fixed << std::setprecision(6);
-         
-         // === OVERALL METRICS ===
-         csv_file << "=== OVERALL METRICS ===\n";
-         csv_file << "Metric,Measured,Model,Error,Error_Percent\n";
-         
-         // Total energy
-         double energy_error = energyEstimation - MEASURED_TOTAL_ENERGY;
-         double energy_error_pct = (energy_error / MEASURED_TOTAL_ENERGY) * 100.0;
-         csv_file << "Total Energy (J)," << MEASURED_TOTAL_ENERGY << "," 
-                 << energyEstimation << "," << energy_error << "," 
-                 << energy_error_pct << "\n";
-         
-         // Average power
-         double model_avg_power = energyEstimation / MEASURED_DURATION;
-         double power_error = model_avg_power - MEASURED_AVG_POWER;
-         double power_error_pct = (power_error / MEASURED_AVG_POWER) * 100.0;
-         csv_file << "Average Power (W)," << MEASURED_AVG_POWER << "," 
-                 << model_avg_power << "," << power_error << "," 
-                 << power_error_pct << "\n";
-         
-         // Duration
-         csv_file << "Duration (s)," << MEASURED_DURATION << "," 
-                 << MEASURED_DURATION << ",0.0,0.0\n";
-         
-         // Transitions
-         csv_file << "Transitions," << "10," << transition_count - 1 << "," 
-                 << (transition_count - 1 - 10) << ",0.0\n";
-         
-         csv_file << "\n";
-         
-         // === PER-STATE METRICS ===
-         csv_file << "=== PER-STATE ENERGY (Joules) ===\n";
-         csv_file << "State,State_Name,Measured,Model,Error,Error_Percent\n";
-         
-         const char* state_names[6] = {
-             "At Work (Office)",
-             "Not at Work",
-             "At Work (Remote)",
-             "Office Bluetooth",
-             "Remote Bluetooth",
-             "Not at Work Bluetooth"
-         };
-         
-         double total_state_energy_error = 0.0;
-         for (int i = 0; i < 6; i++) {
-             double state_error = state_energy[i] - MEASURED_ENERGY_STATE[i];
-             double state_error_pct = (MEASURED_ENERGY_STATE[i] > 0) ? 
-                 (state_error / MEASURED_ENERGY_STATE[i]) * 100.0 : 0.0;
-             
-             csv_file << i << "," << state_names[i] << "," 
-                     << MEASURED_ENERGY_STATE[i] << "," 
-                     << state_energy[i] << "," 
-                     << state_error << "," 
-                     << state_error_pct << "\n";
-             
-             total_state_energy_error += std::abs(state_error);
-         }
-         
-         csv_file << "\n";
-         
-         // === PER-STATE DURATION ===
-         csv_file << "=== PER-STATE DURATION (seconds) ===\n";
-         csv_file << "State,State_Name,Measured,Model,Error,Error_Percent\n";
-         
-         for (int i = 0; i < 6; i++) {
-             double duration_error = state_duration[i] - MEASURED_DURATION_STATE[i];
-             double duration_error_pct = (MEASURED_DURATION_STATE[i] > 0) ? 
-                 (duration_error / MEASURED_DURATION_STATE[i]) * 100.0 : 0.0;
-             
-             csv_file << i << "," << state_names[i] << "," 
-                     << MEASURED_DURATION_STATE[i] << "," 
-                     << state_duration[i] << "," 
-                     << duration_error << "," 
-                     << duration_error_pct << "\n";
-         }
-         
-         csv_file << "\n";
-         
-         // === SUMMARY STATISTICS ===
-         csv_file << "=== SUMMARY STATISTICS ===\n";
-         csv_file << "Metric,Value\n";
-         csv_file << "Total Energy Error (J)," << std::abs(energy_error) << "\n";
-         csv_file << "Total Energy Error (%)," << std::abs(energy_error_pct) << "\n";
-         csv_file << "Per-State Energy Error Sum (J)," << total_state_energy_error << "\n";
-         csv_file << "Model Status," << (std::abs(energy_error_pct) < 1.0 ? "PASS" : "FAIL") << "\n";
-         
-         csv_file.close();
-         
-         std::cout << "\n✓ Validation CSV generated: model_vs_measurement.csv" << std::endl;
-     }
- 
- private:
-     double getPowerForState(int state) {
-         switch(state) {
-             case 0: return POWER_OFFICE;
-             case 1: return POWER_NOT_AT_WORK;
-             case 2: return POWER_REMOTE;
-             case 3: return POWER_OFFICE_BT;
-             case 4: return POWER_REMOTE_BT;
-             case 5: return POWER_NOT_AT_WORK_BT;
-             default: return POWER_DEFAULT;
+         const std::uint64_t final_tick = nowTick();
+         double final_energy = pending_energy + accumulator.charge(final_tick - last_charge_tick);
+         pending_energy = 0.0;
+         last_charge_tick = final_tick;
+         if (transition_log) {
+             transition_log->finish(ticksToSeconds(final_tick), accumulator.previous_status,
+                                    final_energy, accumulator.energyEstimation);
          }
+         return final_energy;
      }
  };
- 
+
  SC_MODULE(QUEUE) {
      sc_core::sc_port<sc_core::sc_signal_out_if<int>> status_out;
-     
+
      SC_CTOR(QUEUE) : status_out("out") {
          SC_THREAD(generateRealisticSequence);
      }
-     
+
      void generateRealisticSequence() {
-         // Based on actual measurement data
-         status_out->write(1); wait(10, sc_core::SC_SEC);
-         status_out->write(0); wait(143, sc_core::SC_SEC);
-         status_out->write(4); wait(6, sc_core::SC_SEC);
-         status_out->write(2); wait(128, sc_core::SC_SEC);
-         status_out->write(0); wait(84, sc_core::SC_SEC);
-         status_out->write(5); wait(4, sc_core::SC_SEC);
-         status_out->write(1); wait(231, sc_core::SC_SEC);
-         status_out->write(0); wait(2526, sc_core::SC_SEC);
-         status_out->write(3); wait(10, sc_core::SC_SEC);
-         status_out->write(0); wait(955, sc_core::SC_SEC);
-         status_out->write(1); wait(22, sc_core::SC_SEC);
-         
-         std::cout << "Test sequence complete" << std::endl;
+         for (const TraceRun& run : TEST_SEQUENCE) {
+             status_out->write(run.state);
+             wait(sc_core::sc_time::from_value(run.duration));
+         }
+
+         if (logEnabled(Verbosity::Summary)) {
+             std::cout << "Test sequence complete" << std::endl;
+         }
      }
  };
- 
+
+ // Ambient temperature for --thermal-table unless --temperature is given.
+ const double DEFAULT_TEMPERATURE = 25.0;  // degrees C
+
+ // Global quantum for --monitor tlm unless --quantum is given.
+ const double DEFAULT_TLM_QUANTUM = 1000.0;  // seconds
+
+ // Checkpoint interval for --checkpoint unless --checkpoint-every is given.
+ const std::uint64_t DEFAULT_CHECKPOINT_EVERY = 100000;  // runs
+
+ // Length of a synthetic trace unless --markov-duration is given.
+ const std::uint64_t DEFAULT_MARKOV_DURATION = 30 * 24 * 3600;  // seconds
+
+ // Parses FIRST:COUNT for --segment.
+ void parseSegment(const std::string& text, std::uint64_t& first, std::uint64_t& count) {
+     const std::size_t split = text.find(':');
+     std::size_t first_end = 0;
+     std::size_t count_end = 0;
+     try {
+         if (split != std::string::npos && split > 0 && split + 1 < text.size() &&
+             text[0] != '-' && text[split + 1] != '-') {
+             first = std::stoull(text.substr(0, split), &first_end);
+             count = std::stoull(text.substr(split + 1), &count_end);
+         }
+     } catch (const std::exception&) {
+         first_end = 0;
+     }
+     if (first_end != split || count_end != text.size() - split - 1 || count == 0) {
+         throw std::runtime_error("invalid segment '" + text + "' (expected FIRST:COUNT runs)");
+     }
+ }
+
+ // The metrics of the replayed trace: queried from the store, or collected
+ // by the recorder during the replay. Empty without a trace.
+ ValidationReference traceReference(const TraceStore* store, const ReferenceRecorder* recorder) {
+     if (store) {
+         return store->reference();
+     }
+     return recorder ? recorder->reference() : ValidationReference();
+ }
+
+ // The reference to validate against: a --reference file, else the metrics
+ // of the trace, else the measurement behind the built-in sequence.
+ const ValidationReference& selectReference(const std::string& reference_path,
+                                            const ValidationReference& loaded,
+                                            bool from_trace,
+                                            const ValidationReference& recorded) {
+     if (!reference_path.empty()) {
+         return loaded;
+     }
+     return from_trace ? recorded : builtinReference();
+ }
+
+ // Sets the SystemC time resolution to one tick, so that sc_time values
+ // are ticks.
+ void setKernelResolution() {
+     static const sc_core::sc_time_unit units[] = {sc_core::SC_SEC, sc_core::SC_MS, sc_core::SC_US,
+                                                   sc_core::SC_NS};
+     int digits = 0;
+     for (std::uint64_t ticks = ticksPerSecond(); ticks > 1; ticks /= 10) {
+         digits++;
+     }
+     const int unit = (digits + 2) / 3;
+     double value = 1.0;
+     for (int i = digits; i < unit * 3; i++) {
+         value *= 10.0;
+     }
+     sc_core::sc_set_time_resolution(value, units[unit]);
+ }
+
+ // Parses FROM,TO for `option` into ticks; each side is seconds or
+ // HH:MM:SS, with a fraction for traces finer than a second.
+ void parseTimeRange(const std::string& option, const std::string& text, std::uint64_t& from,
+                     std::uint64_t& to) {
+     const auto parseTime = [&option, &text](const std::string& part, std::uint64_t& value) {
+         std::uint64_t resolution = 0;
+         if (parseTimingTicks(part.data(), part.data() + part.size(), ticksPerSecond(), value, resolution)) {
+             return;
+         }
+         char* end = nullptr;
+         const double seconds = std::strtod(part.c_str(), &end);
+         value = secondsToTicks(seconds);
+         if (part.empty() || *end != '\0' || !(seconds >= 0.0)) {
+             throw std::runtime_error("expected FROM,TO in seconds or HH:MM:SS for " + option + ", got '" +
+                                      text + "'");
+         }
+     };
+     const std::size_t comma = text.find(',');
+     parseTime(text.substr(0, comma), from);
+     parseTime(comma == std::string::npos ? std::string() : text.substr(comma + 1), to);
+     if (to <= from) {
+         throw std::runtime_error(option + " range " + text + " is empty");
+     }
+ }
+
+ // Prints the model energy of one --energy-query range.
+ void printEnergyQuery(const EnergyIndex& index, std::uint64_t from, std::uint64_t to,
+                       const PowerTable& table) {
+     if (!logEnabled(Verbosity::Summary)) {
+         return;
+     }
+     from = std::min(from, index.end());
+     to = std::max(from, std::min(to, index.end()));
+     std::cout << "\n=== ENERGY QUERY " << ticksToSeconds(from) << "-" << ticksToSeconds(to) << " s ===" << std::endl;
+     std::cout << "Duration: " << ticksToSeconds(to - from) << " s, " << index.energy(from, to)
+               << " J estimated" << std::endl;
+     std::cout << "State,State_Name,Energy_J" << std::endl;
+     for (int state = 0; state < index.stateCount(); state++) {
+         const double energy = index.stateEnergy(state, from, to);
+         if (energy == 0.0) {
+             continue;
+         }
+         std::cout << state << "," << (table.contains(state) ? table.name(state) : std::string("?")) << ","
+                   << energy << std::endl;
+     }
+ }
+
+ // Prints the measured figures of one --trace-query range.
+ void printTraceQuery(const RangeStats& stats, const PowerTable& table) {
+     if (!logEnabled(Verbosity::Summary)) {
+         return;
+     }
+     std::cout << "\n=== TRACE QUERY " << ticksToSeconds(stats.from) << "-" << ticksToSeconds(stats.to) << " s ==="
+               << std::endl;
+     std::cout << "Duration: " << ticksToSeconds(stats.duration()) << " s, " << stats.transitions << " transitions, "
+               << stats.energy << " J measured" << std::endl;
+     std::cout << "State,State_Name,Duration_s,Energy_J,Runs" << std::endl;
+     for (std::size_t s = 0; s < stats.state_duration.size(); s++) {
+         if (stats.state_runs[s] == 0) {
+             continue;
+         }
+         const int state = static_cast<int>(s);
+         std::cout << state << "," << (table.contains(state) ? table.name(state) : std::string("?")) << ","
+                   << ticksToSeconds(stats.state_duration[s]) << "," << stats.state_energy[s] << "," << stats.state_runs[s]
+                   << std::endl;
+     }
+ }
+
+ // Replays `runs` on `devices` devices, device d starting d * stagger ticks
+ // in, and validates device 0, which sees the same trace as a single-device
+ // run.
+ int runFleet(const std::vector<TraceRun>& runs, std::size_t devices, std::uint64_t stagger,
+              bool fast_mode, const PowerTable& power_table,
+              const std::string& report_path, const std::string& output_path, ReportFormat output_format,
+              const ValidationReference& reference) {
+     // All devices share one run array; a source is a pair of pointers.
+     std::vector<SpanTraceReader> sources;
+     sources.reserve(devices);
+     Fleet fleet(power_table);
+     for (std::size_t d = 0; d < devices; d++) {
+         sources.emplace_back(runs.data(), runs.data() + runs.size());
+         fleet.addDevice(sources.back(), d * stagger);
+     }
+
+     try {
+         if (fast_mode) {
+             if (logEnabled(Verbosity::Summary)) {
+                 std::cout << "Fast fleet integration started..." << std::endl;
+             }
+             fleet.run();
+         } else {
+             setKernelResolution();
+             FleetMonitor monitor("fleet", fleet);
+             if (logEnabled(Verbosity::Summary)) {
+                 std::cout << "Fleet simulation started..." << std::endl;
+             }
+             sc_core::sc_start();
+         }
+
+         if (!report_path.empty()) {
+             fleet.writeReport(report_path);
+         }
+     } catch (const std::exception& e) {
+         std::cerr << "Error: " << e.what() << std::endl;
+         return 1;
+     }
+
+     EnergyAccumulator result(power_table);
+     fleet.exportDevice(0, result);
+
+     if (logEnabled(Verbosity::Summary)) {
+         const double total_energy = fleet.totalEnergy();
+         std::cout << "Fleet: " << devices << " devices, " << fleet.totalTransitions()
+                   << " transitions" << std::endl;
+         std::cout << "Fleet Total Energy: " << total_energy << " J ("
+                   << total_energy / devices << " J per device)" << std::endl;
+         std::cout << "Device 0 Total Energy: " << result.energyEstimation << " J" << std::endl;
+     }
+     validateResults(result, reference);
+     writeValidationReport(result, output_path, reference, output_format);
+     return 0;
+ }
+
  int sc_main(int argc, char* argv[]) {
-     sc_core::sc_set_time_resolution(1.0, sc_core::SC_SEC);
- 
-     sc_core::sc_signal<int> signal;
- 
-     QUEUE queue("queue");
-     TestbenchModule testbench("testbench");
-     queue.status_out(signal);
-     testbench.status_input(signal);
- 
-     std::cout << "Simulation started..." << std::endl;
-     sc_core::sc_start(4119, sc_core::SC_SEC);
-     
-     testbench.finalizeEnergy();
-     testbench.validateResults();
-     testbench.generateValidationCSV();  // Generate CSV after validation
-     
-     std::cout << "Simulation finished." << std::endl;
-     std::cout << "-----------------------------" << std::endl << std::endl;
- 
-     std::cout << "Calculated Average Power: " << testbench.powerEstimation << " W" << std::endl;
-     std::cout << "Calculated Average Energy: " << testbench.energyEstimation << " J" << std::endl;
-     
+     // Transition lines are written with '\n' and must not be flushed one
+     // by one through stdio.
+     std::ios::sync_with_stdio(false);
+
+     std::string trace_path;
+     std::string event_log_path;
+     std::string event_log_format = "csv";
+     std::string power_table_path;
+     std::string reference_path;
+     std::string output_path;
+     ReportFormat output_format = ReportFormat::Csv;
+     std::string fleet_report_path;
+     std::string timeseries_path;
+     std::string timeseries_windows = "60";
+     std::string thermal_table_path;
+     std::string transition_costs_path;
+     std::string temperature_trace_path;
+     double temperature = DEFAULT_TEMPERATURE;
+     bool temperature_given = false;
+     std::size_t fleet_size = 0;
+     std::uint64_t fleet_stagger = 0;
+     bool fast_mode = false;
+     unsigned jobs = 1;
+     bool tlm_monitor = false;
+     double tlm_quantum = DEFAULT_TLM_QUANTUM;
+     std::string checkpoint_path;
+     std::string resume_path;
+     std::string segment_text;
+     std::uint64_t checkpoint_every = DEFAULT_CHECKPOINT_EVERY;
+     std::string markov_model_path;
+     std::string markov_fit_path;
+     std::string markov_save_path;
+     std::uint64_t markov_seed = 1;
+     std::uint64_t markov_stream = 0;
+     std::uint64_t markov_duration = DEFAULT_MARKOV_DURATION;
+     bool recalibrate = false;
+     bool use_trace_store = false;
+     std::vector<std::string> trace_queries;
+     std::vector<std::pair<std::uint64_t, std::uint64_t>> query_ranges;
+     std::vector<std::string> energy_queries;
+     std::vector<std::pair<std::uint64_t, std::uint64_t>> energy_ranges;
+     std::string recalibrated_table_path;
+     std::string power_domains_path;
+     TestbenchModule::ProcessKind monitor_kind = TestbenchModule::ProcessKind::Thread;
+     try {
+         for (int i = 1; i < argc; i++) {
+             std::string arg = argv[i];
+             if (arg == "--trace" && i + 1 < argc) {
+                 trace_path = argv[++i];
+             } else if (arg == "--trace-store") {
+                 use_trace_store = true;
+             } else if (arg == "--trace-query" && i + 1 < argc) {
+                 use_trace_store = true;
+                 trace_queries.push_back(argv[++i]);
+             } else if (arg == "--energy-query" && i + 1 < argc) {
+                 energy_queries.push_back(argv[++i]);
+             } else if (arg == "--fast") {
+                 fast_mode = true;
+             } else if (arg == "--jobs" && i + 1 < argc) {
+                 jobs = static_cast<unsigned>(std::stoul(argv[++i]));
+             } else if (arg == "--fleet" && i + 1 < argc) {
+                 fleet_size = std::stoul(argv[++i]);
+             } else if (arg == "--fleet-stagger" && i + 1 < argc) {
+                 fleet_stagger = std::stoull(argv[++i]);
+             } else if (arg == "--fleet-report" && i + 1 < argc) {
+                 fleet_report_path = argv[++i];
+             } else if (arg == "--monitor" && i + 1 < argc) {
+                 std::string kind = argv[++i];
+                 if (kind == "thread") {
+                     monitor_kind = TestbenchModule::ProcessKind::Thread;
+                 } else if (kind == "method") {
+                     monitor_kind = TestbenchModule::ProcessKind::Method;
+                 } else if (kind == "tlm") {
+                     tlm_monitor = true;
+                 } else {
+                     throw std::runtime_error("unknown monitor '" + kind +
+                                              "' (expected thread, method or tlm)");
+                 }
+             } else if (arg == "--quantum" && i + 1 < argc) {
+                 tlm_quantum = std::stod(argv[++i]);
+             } else if (arg == "--transition-costs" && i + 1 < argc) {
+                 transition_costs_path = argv[++i];
+             } else if (arg == "--thermal-table" && i + 1 < argc) {
+                 thermal_table_path = argv[++i];
+             } else if (arg == "--temperature" && i + 1 < argc) {
+                 temperature = std::stod(argv[++i]);
+                 temperature_given = true;
+             } else if (arg == "--temperature-trace" && i + 1 < argc) {
+                 temperature_trace_path = argv[++i];
+             } else if (arg == "--timeseries" && i + 1 < argc) {
+                 timeseries_path = argv[++i];
+             } else if (arg == "--timeseries-window" && i + 1 < argc) {
+                 timeseries_windows = argv[++i];
+             } else if (arg == "--checkpoint" && i + 1 < argc) {
+                 checkpoint_path = argv[++i];
+             } else if (arg == "--checkpoint-every" && i + 1 < argc) {
+                 checkpoint_every = std::stoull(argv[++i]);
+             } else if (arg == "--resume" && i + 1 < argc) {
+                 resume_path = argv[++i];
+             } else if (arg == "--segment" && i + 1 < argc) {
+                 segment_text = argv[++i];
+             } else if (arg == "--markov-model" && i + 1 < argc) {
+                 markov_model_path = argv[++i];
+             } else if (arg == "--markov-fit" && i + 1 < argc) {
+                 markov_fit_path = argv[++i];
+             } else if (arg == "--markov-save" && i + 1 < argc) {
+                 markov_save_path = argv[++i];
+             } else if (arg == "--markov-seed" && i + 1 < argc) {
+                 markov_seed = std::stoull(argv[++i]);
+             } else if (arg == "--markov-stream" && i + 1 < argc) {
+                 markov_stream = std::stoull(argv[++i]);
+             } else if (arg == "--markov-duration" && i + 1 < argc) {
+                 markov_duration = std::stoull(argv[++i]);
+             } else if (arg == "--recalibrate") {
+                 recalibrate = true;
+             } else if (arg == "--recalibrated-table" && i + 1 < argc) {
+                 recalibrate = true;
+                 recalibrated_table_path = argv[++i];
+             } else if (arg == "--output" && i + 1 < argc) {
+                 output_path = argv[++i];
+             } else if (arg == "--output-format" && i + 1 < argc) {
+                 output_format = parseReportFormat(argv[++i]);
+             } else if (arg == "--reference" && i + 1 < argc) {
+                 reference_path = argv[++i];
+             } else if (arg == "--power-table" && i + 1 < argc) {
+                 power_table_path = argv[++i];
+             } else if (arg == "--power-domains" && i + 1 < argc) {
+                 power_domains_path = argv[++i];
+             } else if (arg == "--verbosity" && i + 1 < argc) {
+                 setVerbosity(parseVerbosity(argv[++i]));
+             } else if (arg == "--quiet") {
+                 setVerbosity(Verbosity::Quiet);
+             } else if (arg == "--event-log" && i + 1 < argc) {
+                 event_log_path = argv[++i];
+             } else if (arg == "--event-log-format" && i + 1 < argc) {
+                 event_log_format = argv[++i];
+             } else {
+                 std::cerr << "Usage: " << argv[0]
+                           << " [--trace <states.csv|trace.dvctrace>] [--trace-store] [--trace-query <from>,<to>]"
+                           << " [--energy-query <from>,<to>]"
+                           << " [--fast] [--jobs N]"
+                           << " [--monitor thread|method|tlm]"
+                           << " [--quantum <seconds>]"
+                           << " [--power-table <table.csv>] [--output <validation.csv>] [--output-format csv|jsonl]"
+                           << " [--reference <reference.csv>] [--power-domains <domains.csv>]"
+                           << " [--transition-costs <transitions.csv>]"
+                           << " [--thermal-table <thermal.csv>] [--temperature <C>]"
+                           << " [--temperature-trace <temperature.csv>]"
+                           << " [--verbosity quiet|summary|transitions] [--quiet]"
+                           << " [--event-log <file>] [--event-log-format csv|binary]"
+                           << " [--timeseries <energy.csv>] [--timeseries-window <s>[,<s>...]]"
+                           << " [--fleet N] [--fleet-stagger <seconds>] [--fleet-report <devices.csv>]"
+                           << " [--checkpoint <file.ckpt>] [--checkpoint-every <runs>] [--resume <file.ckpt>]"
+                           << " [--segment <first>:<count>]"
+                           << " [--markov-model <model.csv> | --markov-fit <trace>] [--markov-save <model.csv>]"
+                           << " [--markov-seed N] [--markov-stream K] [--markov-duration <seconds>]"
+                           << " [--recalibrate] [--recalibrated-table <table.csv>]"
+                           << std::endl;
+                 return 1;
+             }
+         }
+     } catch (const std::exception& e) {
+         std::cerr << "Error: " << e.what() << std::endl;
+         return 1;
+     }
+     if (output_path.empty()) {
+         output_path = output_format == ReportFormat::JsonLines ? DEFAULT_VALIDATION_JSONL : DEFAULT_VALIDATION_CSV;
+     }
+
+     std::unique_ptr<MarkovModel> markov_model;
+     std::unique_ptr<TraceReader> reader;
+     std::unique_ptr<EventLogSink> event_log;
+     std::unique_ptr<TimeSeriesWriter> timeseries;
+     std::unique_ptr<ThermalPowerTable> thermal_table;
+     std::unique_ptr<TransitionMatrix> transition_costs;
+     std::unique_ptr<ThermalSchedule> thermal;
+     std::unique_ptr<OnlineCalibrator> calibrator;
+     std::unique_ptr<TraceStore> trace_store;
+     std::unique_ptr<EnergyIndex> energy_index;
+     std::unique_ptr<PowerDomains> power_domains;
+     std::unique_ptr<DomainEnergy> domain_energy;
+     PowerTable power_table = PowerTable::builtin();
+     // Validation compares against a reference file, the metrics of the
+     // replayed trace, or the measurement behind the built-in sequence.
+     ReferenceRecorder* recorder = nullptr;
+     ValidationReference loaded_reference;
+     try {
+         // Trace time is counted in ticks of the trace's own resolution.
+         if (!trace_path.empty()) {
+             setTicksPerSecond(traceTicksPerSecond(trace_path));
+         }
+         if (use_trace_store) {
+             if (trace_path.empty()) {
+                 throw std::runtime_error("--trace-store and --trace-query need --trace");
+             }
+             // One in-memory copy serves the replay, validation and queries.
+             trace_store.reset(new TraceStore(TraceStore::load(trace_path)));
+             reader.reset(new StoreRunReader(*trace_store));
+             for (const std::string& query : trace_queries) {
+                 query_ranges.emplace_back();
+                 parseTimeRange("--trace-query", query, query_ranges.back().first, query_ranges.back().second);
+             }
+         } else if (!trace_path.empty()) {
+             std::unique_ptr<ReferenceRecorder> recording(new ReferenceRecorder(openTrace(trace_path), trace_path));
+             recorder = recording.get();
+             reader = std::move(recording);
+         }
+         if (!markov_model_path.empty() || !markov_fit_path.empty()) {
+             if (!trace_path.empty() || (!markov_model_path.empty() && !markov_fit_path.empty())) {
+                 throw std::runtime_error("use one of --trace, --markov-model and --markov-fit");
+             }
+             if (!markov_model_path.empty()) {
+                 markov_model.reset(new MarkovModel(MarkovModel::load(markov_model_path)));
+             } else {
+                 if (traceTicksPerSecond(markov_fit_path) != 1) {
+                     // Model files hold dwell times in whole seconds.
+                     throw std::runtime_error("--markov-fit needs a trace with whole-second timings");
+                 }
+                 std::unique_ptr<TraceReader> fit_trace = openTrace(markov_fit_path);
+                 markov_model.reset(new MarkovModel(MarkovModel::fit(*fit_trace)));
+             }
+             if (!markov_save_path.empty()) {
+                 markov_model->save(markov_save_path);
+             }
+             // A synthetic trace has no measured energy; the recorder
+             // still provides its durations and transitions.
+             const std::string name = "markov seed " + std::to_string(markov_seed) + " stream " +
+                                      std::to_string(markov_stream);
+             std::unique_ptr<ReferenceRecorder> recording(new ReferenceRecorder(
+                 std::unique_ptr<TraceReader>(new MarkovTraceReader(*markov_model, markov_seed, markov_stream,
+                                                                    markov_duration)),
+                 name));
+             recorder = recording.get();
+             reader = std::move(recording);
+         } else if (!markov_save_path.empty()) {
+             throw std::runtime_error("--markov-save needs --markov-model or --markov-fit");
+         }
+         if (!reference_path.empty()) {
+             loaded_reference = ValidationReference::load(reference_path);
+         }
+         if (!power_table_path.empty()) {
+             power_table = PowerTable::load(power_table_path);
+         }
+         if (!power_domains_path.empty()) {
+             if (!power_table_path.empty()) {
+                 throw std::runtime_error("use one of --power-table and --power-domains");
+             }
+             if (fleet_size > 0 || jobs != 1 || !thermal_table_path.empty() || recalibrate ||
+                 !checkpoint_path.empty() || !resume_path.empty() || !segment_text.empty()) {
+                 throw std::runtime_error("--power-domains is not supported with --fleet, --jobs, --thermal-table, "
+                                          "--recalibrate or checkpoints");
+             }
+             // Trace states power the sum of their domains.
+             power_domains.reset(new PowerDomains(PowerDomains::load(power_domains_path)));
+             power_table = power_domains->table();
+             domain_energy.reset(new DomainEnergy(*power_domains));
+         }
+         if (!event_log_path.empty()) {
+             event_log.reset(new EventLogSink(event_log_path, parseEventLogFormat(event_log_format)));
+         }
+         if (!transition_costs_path.empty()) {
+             if (fleet_size > 0) {
+                 throw std::runtime_error("--transition-costs is not supported with --fleet");
+             }
+             transition_costs.reset(new TransitionMatrix(TransitionMatrix::load(transition_costs_path, power_table)));
+         }
+         if (thermal_table_path.empty() && (temperature_given || !temperature_trace_path.empty())) {
+             throw std::runtime_error("--temperature and --temperature-trace need --thermal-table");
+         }
+         if (!thermal_table_path.empty()) {
+             if (fleet_size > 0 || tlm_monitor) {
+                 throw std::runtime_error("--thermal-table is not supported with --fleet or --monitor tlm");
+             }
+             thermal_table.reset(new ThermalPowerTable(ThermalPowerTable::load(thermal_table_path, power_table)));
+             std::vector<TemperatureStep> steps;
+             if (!temperature_trace_path.empty()) {
+                 steps = loadTemperatureTrace(temperature_trace_path);
+                 if (!temperature_given) {
+                     temperature = steps.front().celsius;
+                 }
+             }
+             thermal.reset(new ThermalSchedule(*thermal_table, temperature, steps));
+         }
+         if (!checkpoint_path.empty() || !resume_path.empty() || !segment_text.empty()) {
+             if (fleet_size > 0 || tlm_monitor || thermal || !timeseries_path.empty()) {
+                 throw std::runtime_error("--checkpoint, --resume and --segment are not supported with "
+                                          "--fleet, --monitor tlm, --thermal-table or --timeseries");
+             }
+             if (!segment_text.empty() && (!fast_mode || checkpoint_path.empty() || !resume_path.empty())) {
+                 throw std::runtime_error("--segment needs --fast and --checkpoint, and cannot be resumed");
+             }
+             // Positions are counted in runs of a reader.
+             if (!reader) {
+                 reader.reset(new VectorTraceReader(TEST_SEQUENCE));
+             }
+         }
+         if (jobs != 1) {
+             if (!fast_mode || fleet_size > 0 || !reader) {
+                 throw std::runtime_error("--jobs needs --fast and --trace or a Markov model");
+             }
+             if (event_log || thermal || !timeseries_path.empty() || !checkpoint_path.empty() ||
+                 !resume_path.empty() || !segment_text.empty()) {
+                 throw std::runtime_error("--jobs is not supported with --event-log, --thermal-table, "
+                                          "--timeseries or checkpoints");
+             }
+         }
+         if (recalibrate) {
+             if (trace_path.empty()) {
+                 throw std::runtime_error("--recalibrate needs a --trace with a power column");
+             }
+             if (fleet_size > 0 || jobs != 1 || tlm_monitor || thermal || !checkpoint_path.empty() ||
+                 !resume_path.empty() || !segment_text.empty()) {
+                 // TLM reads ahead by a quantum, so its table would see
+                 // measurements from the future.
+                 throw std::runtime_error("--recalibrate is not supported with --fleet, --jobs, --monitor tlm, "
+                                          "--thermal-table or checkpoints");
+             }
+             // The replay runs on the live table, which follows the
+             // measurements seen so far.
+             calibrator.reset(new OnlineCalibrator(power_table));
+             const OnlineCalibrator& live = *calibrator;
+             reader.reset(new CalibratingTraceReader(std::move(reader), *calibrator,
+                                                     [&live](int state, std::uint64_t time) {
+                 if (logEnabled(Verbosity::Summary)) {
+                     std::cout << "⚠ State " << state << " (" << live.model().name(state) << ") drifted at "
+                               << time << " s: model " << live.model().power(state) << " W, measured "
+                               << live.estimate(state).mean << " W (" << live.errorPercent(state) << "%)"
+                               << std::endl;
+                 }
+             }));
+         }
+         if (!energy_queries.empty()) {
+             if (fleet_size > 0 || jobs != 1 || !resume_path.empty() || !segment_text.empty()) {
+                 // The index starts at tick 0 of a single replay.
+                 throw std::runtime_error("--energy-query is not supported with --fleet, --jobs, --resume "
+                                          "or --segment");
+             }
+             for (const std::string& query : energy_queries) {
+                 energy_ranges.emplace_back();
+                 parseTimeRange("--energy-query", query, energy_ranges.back().first, energy_ranges.back().second);
+             }
+             energy_index.reset(new EnergyIndex());
+         }
+         if (!timeseries_path.empty() && fleet_size == 0) {
+             timeseries.reset(new TimeSeriesWriter(timeseries_path, power_table.stateCount(),
+                                                   parseWindowList(timeseries_windows)));
+         }
+     } catch (const std::exception& e) {
+         std::cerr << "Error: " << e.what() << std::endl;
+         return 1;
+     }
+     TransitionLog transition_log(event_log.get());
+
+     if (fleet_size > 0) {
+         if (event_log || !timeseries_path.empty()) {
+             std::cerr << "Error: --event-log and --timeseries are not supported with --fleet" << std::endl;
+             return 1;
+         }
+         std::vector<TraceRun> runs = TEST_SEQUENCE;
+         if (reader) {
+             runs.clear();
+             try {
+                 TraceRun run;
+                 while (reader->next(run)) {
+                     runs.push_back(run);
+                 }
+             } catch (const std::exception& e) {
+                 std::cerr << "Error: " << e.what() << std::endl;
+                 return 1;
+             }
+         }
+         const ValidationReference trace_reference = traceReference(trace_store.get(), recorder);
+         try {
+             return runFleet(runs, fleet_size, fleet_stagger * ticksPerSecond(), fast_mode, power_table,
+                             fleet_report_path, output_path, output_format,
+                             selectReference(reference_path, loaded_reference, !trace_path.empty() || recorder,
+                                             trace_reference));
+         } catch (const std::exception& e) {
+             // E.g. a power table with more states than a fleet can hold.
+             std::cerr << "Error: " << e.what() << std::endl;
+             return 1;
+         }
+     }
+
+     EnergyAccumulator result(calibrator ? calibrator->table() : power_table);
+     result.timeseries = timeseries.get();
+     result.transition_costs = transition_costs.get();
+     result.energy_index = energy_index.get();
+     result.domain_energy = domain_energy.get();
+     double final_energy = 0.0;
+
+     // Resume or segment start, positioning `reader` at the first run.
+     ReplayControl control;
+     try {
+         if (!resume_path.empty()) {
+             control.position = readCheckpoint(resume_path, result);
+             if (skipRuns(*reader, control.position.runs) != control.position.tick) {
+                 throw std::runtime_error("trace does not match checkpoint " + resume_path);
+             }
+             if (logEnabled(Verbosity::Summary)) {
+                 std::cout << "Resuming from " << resume_path << " at run " << control.position.runs
+                           << " (" << ticksToSeconds(control.position.tick) << " s)" << std::endl;
+             }
+         } else if (!segment_text.empty()) {
+             std::uint64_t first = 0;
+             std::uint64_t count = 0;
+             parseSegment(segment_text, first, count);
+             const std::uint64_t start_tick = skipRuns(*reader, first);
+             control.position.first_run = first;
+             control.position.runs = first;
+             control.position.start_tick = start_tick;
+             control.position.tick = start_tick;
+             control.position.last_charge = start_tick;
+             control.run_limit = first + count;
+         }
+         if (!checkpoint_path.empty() && segment_text.empty()) {
+             control.checkpoint_every = checkpoint_every;
+             control.checkpoint = [&checkpoint_path](const EnergyAccumulator& accumulator,
+                                                     const ReplayPosition& position) {
+                 writeCheckpoint(checkpoint_path, accumulator, position);
+             };
+         }
+     } catch (const std::exception& e) {
+         std::cerr << "Error: " << e.what() << std::endl;
+         return 1;
+     }
+     const bool controlled = !checkpoint_path.empty() || !resume_path.empty() || !segment_text.empty();
+
+     if (fast_mode) {
+         // Analytic fast path: same integration, no kernel scheduling.
+         if (logEnabled(Verbosity::Summary)) {
+             std::cout << "Fast analytic integration started..." << std::endl;
+         }
+         VectorTraceReader test_sequence(TEST_SEQUENCE);
+         try {
+             if (jobs != 1) {
+                 // One long trace sharded over all cores and merged in order.
+                 if (trace_store) {
+                     final_energy = integrateTraceParallel(*trace_store, result, jobs);
+                 } else if (const BinaryTraceReader* binary = dynamic_cast<const BinaryTraceReader*>(&recorder->source())) {
+                     final_energy = integrateTraceParallel(binary->trace(), result, jobs);
+                     if (reference_path.empty()) {
+                         // The shards bypass the recorder; collect the trace metrics separately.
+                         TraceRun run;
+                         while (recorder->next(run)) {
+                         }
+                     }
+                 } else {
+                     std::vector<TraceRun> runs;
+                     TraceRun run;
+                     while (reader->next(run)) {
+                         runs.push_back(run);
+                     }
+                     final_energy = integrateTraceParallel(runs, result, jobs);
+                 }
+             } else {
+                 final_energy = integrateTrace(reader ? *reader : test_sequence, result, &transition_log,
+                                               thermal.get(), controlled ? &control : nullptr);
+             }
+         } catch (const std::exception& e) {
+             std::cerr << "Error: " << e.what() << std::endl;
+             return 1;
+         }
+     } else if (tlm_monitor) {
+         // Loosely-timed replay: the initiator runs ahead by up to one
+         // quantum and the observer integrates lazily.
+         setKernelResolution();
+         tlm_utils::tlm_quantumkeeper::set_global_quantum(sc_core::sc_time(tlm_quantum, sc_core::SC_SEC));
+
+         VectorTraceReader test_sequence(TEST_SEQUENCE);
+         TlmPowerObserver observer(power_table, &transition_log);
+         observer.accumulator().timeseries = timeseries.get();
+         observer.accumulator().transition_costs = transition_costs.get();
+         observer.accumulator().energy_index = energy_index.get();
+         observer.accumulator().domain_energy = domain_energy.get();
+         TlmTraceInitiator initiator("initiator", reader ? *reader : test_sequence, observer);
+
+         if (logEnabled(Verbosity::Summary)) {
+             std::cout << "Decoupled simulation started (quantum " << tlm_quantum << " s)..." << std::endl;
+         }
+         try {
+             {
+                 PROFILE_SCOPE(Kernel);
+                 sc_core::sc_start();
+             }
+             final_energy = observer.finish();
+         } catch (const std::exception& e) {
+             std::cerr << "Error: " << e.what() << std::endl;
+             return 1;
+         }
+         result = observer.accumulator();
+     } else {
+         setKernelResolution();
+
+         // Start from an invalid status so that a trace beginning in state 0
+         // still produces a value change for the first transition.
+         // A resumed replay continues from the state it was in.
+         sc_core::sc_signal<int> signal("status", result.previous_status);
+
+         std::unique_ptr<TraceSource> trace_source;
+         std::unique_ptr<QUEUE> queue;
+         std::unique_ptr<TemperatureSource> temperature_source;
+         TestbenchModule testbench("testbench", monitor_kind);
+         testbench.accumulator = result;
+         testbench.time_offset = control.position.tick;
+         testbench.last_charge_tick = control.position.last_charge;
+
+         if (reader) {
+             trace_source.reset(new TraceSource("trace_source", *reader, control.position.runs));
+             trace_source->status_out(signal);
+             if (control.checkpoint) {
+                 trace_source->checkpoint_every = control.checkpoint_every;
+                 trace_source->checkpoint = [&testbench, &control](std::uint64_t runs) {
+                     ReplayPosition position = control.position;
+                     position.runs = runs;
+                     position.tick = testbench.nowTick();
+                     position.last_charge = testbench.last_charge_tick;
+                     control.checkpoint(testbench.accumulator, position);
+                 };
+             }
+         } else {
+             queue.reset(new QUEUE("queue"));
+             queue->status_out(signal);
+         }
+         testbench.status_input(signal);
+         if (thermal) {
+             testbench.accumulator.setPowerRow(thermal->initialRow());
+             temperature_source.reset(new TemperatureSource(
+                 "temperature_source", *thermal,
+                 [&testbench](const double* row) { testbench.temperatureChanged(row); },
+                 trace_source.get()));
+         }
+         if (transition_log.active()) {
+             testbench.transition_log = &transition_log;
+         }
+
+         if (logEnabled(Verbosity::Summary)) {
+             std::cout << "Simulation started..." << std::endl;
+         }
+         try {
+             PROFILE_SCOPE(Kernel);
+             if (trace_source) {
+                 // Run until the trace is exhausted.
+                 sc_core::sc_start();
+             } else {
+                 // Run until the end of the built-in sequence.
+                 const TraceRun& last = TEST_SEQUENCE.back();
+                 sc_core::sc_start(sc_core::sc_time::from_value(last.start + last.duration));
+             }
+         } catch (const std::exception& e) {
+             std::cerr << "Error: " << e.what() << std::endl;
+             return 1;
+         }
+
+         final_energy = testbench.finalizeEnergy();
+         result = testbench.accumulator;
+         if (trace_source) {
+             control.position.runs = trace_source->runs;
+             control.position.tick = testbench.last_charge_tick;
+             control.position.last_charge = testbench.last_charge_tick;
+         }
+     }
+
+     try {
+         if (!checkpoint_path.empty()) {
+             writeCheckpoint(checkpoint_path, result, control.position);
+             if (logEnabled(Verbosity::Summary)) {
+                 std::cout << "✓ Checkpoint written: " << checkpoint_path << " (runs "
+                           << control.position.first_run << "-" << control.position.runs << ")"
+                           << std::endl;
+             }
+         }
+         transition_log.flush();
+         if (timeseries) {
+             timeseries->close();
+             if (logEnabled(Verbosity::Summary)) {
+                 std::cout << "✓ Time series written: " << timeseries->path() << " ("
+                           << timeseries->bucketCount() << " buckets)" << std::endl;
+             }
+         }
+     } catch (const std::exception& e) {
+         std::cerr << "Error: " << e.what() << std::endl;
+         return 1;
+     }
+
+     reportFinalEnergy(result, final_energy);
+     const ValidationReference trace_reference = traceReference(trace_store.get(), recorder);
+     const ValidationReference& reference =
+         selectReference(reference_path, loaded_reference, !trace_path.empty() || recorder, trace_reference);
+     validateResults(result, reference);
+     writeValidationReport(result, output_path, reference, output_format);  // Generate report after validation
+     for (const auto& range : query_ranges) {
+         printTraceQuery(trace_store->query(range.first, range.second), power_table);
+     }
+     for (const auto& range : energy_ranges) {
+         printEnergyQuery(*energy_index, range.first, range.second, power_table);
+     }
+     if (domain_energy) {
+         printDomainReport(*domain_energy, result.state_duration);
+     }
+     if (calibrator) {
+         printCalibrationReport(*calibrator);
+         if (!recalibrated_table_path.empty()) {
+             try {
+                 calibrator->table().save(recalibrated_table_path);
+             } catch (const std::exception& e) {
+                 std::cerr << "Error: " << e.what() << std::endl;
+                 return 1;
+             }
+             if (logEnabled(Verbosity::Summary)) {
+                 std::cout << "✓ Recalibrated power table written: " << recalibrated_table_path << std::endl;
+             }
+         }
+     }
+     PROFILE_REPORT();
+
+     if (logEnabled(Verbosity::Summary)) {
+         std::cout << "Simulation finished." << std::endl;
+         std::cout << "-----------------------------" << std::endl << std::endl;
+
+         std::cout << "Calculated Average Power: " << result.powerEstimation << " W" << std::endl;
+         std::cout << "Calculated Average Energy: " << result.energyEstimation << " J" << std::endl;
+     }
+
      return 0;
- }
\ No newline at end of file
+ }
@@ -0,0 +1,253 @@
+/**
+ * markov_generator.cpp
+ */
+
+#include "markov_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// Binary traces store states as 16-bit ids.
+const int MAX_MODEL_STATES = 65536;
+
+std::string trim(const std::string& text) {
+    const std::size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    const std::size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+bool parseInteger(const std::string& text, long long& value) {
+    char* end = nullptr;
+    value = std::strtoll(text.c_str(), &end, 10);
+    return !text.empty() && *end == '\0';
+}
+
+bool parseWeight(const std::string& text, double& value) {
+    return parseDecimal(text.data(), text.data() + text.size(), value) && value >= 0.0 &&
+           std::isfinite(value);
+}
+
+} // namespace
+
+template <typename T>
+void MarkovModel::Choice<T>::add(T value, double weight) {
+    if (weight <= 0.0) {
+        return;
+    }
+    values.push_back(value);
+    cumulative.push_back((cumulative.empty() ? 0.0 : cumulative.back()) + weight);
+}
+
+template <typename T>
+T MarkovModel::pick(const Choice<T>& choice, double u) {
+    const double target = u * choice.cumulative.back();
+    const std::size_t index = static_cast<std::size_t>(
+        std::upper_bound(choice.cumulative.begin(), choice.cumulative.end(), target) -
+        choice.cumulative.begin());
+    return choice.values[std::min(index, choice.values.size() - 1)];
+}
+
+MarkovModel::State& MarkovModel::state(int id) {
+    if (id >= static_cast<int>(states.size())) {
+        states.resize(static_cast<std::size_t>(id) + 1);
+    }
+    return states[id];
+}
+
+int MarkovModel::nextState(int state, double u) const {
+    const Choice<int>& next = states[state].next;
+    return next.empty() ? pick(initial, u) : pick(next, u);
+}
+
+std::uint64_t MarkovModel::dwellTicks(int state, double u) const {
+    return pick(states[state].dwell, u);
+}
+
+void MarkovModel::check(const std::string& where) const {
+    if (initial.empty()) {
+        throw std::runtime_error(where + ": model has no initial state");
+    }
+    // Every state that can be entered needs a dwell time.
+    std::vector<bool> reachable(states.size(), false);
+    for (int s : initial.values) {
+        reachable[s] = true;
+    }
+    for (const State& s : states) {
+        for (int to : s.next.values) {
+            reachable[to] = true;
+        }
+    }
+    for (std::size_t s = 0; s < states.size(); s++) {
+        if (reachable[s] && states[s].dwell.empty()) {
+            throw std::runtime_error(where + ": state " + std::to_string(s) + " has no dwell times");
+        }
+    }
+}
+
+MarkovModel MarkovModel::fit(TraceReader& reader) {
+    std::vector<std::map<int, std::uint64_t>> transitions;
+    std::vector<std::map<std::uint64_t, std::uint64_t>> dwells;
+    MarkovModel model;
+
+    TraceRun run;
+    int previous = -1;
+    while (reader.next(run)) {
+        if (run.state < 0 || run.duration == 0) {
+            continue;
+        }
+        if (static_cast<std::size_t>(run.state) >= dwells.size()) {
+            transitions.resize(static_cast<std::size_t>(run.state) + 1);
+            dwells.resize(static_cast<std::size_t>(run.state) + 1);
+        }
+        dwells[run.state][run.duration]++;
+        if (previous < 0) {
+            model.initial.add(run.state, 1.0);
+        } else if (run.state != previous) {
+            transitions[previous][run.state]++;
+        }
+        previous = run.state;
+    }
+    if (previous < 0) {
+        throw std::runtime_error("cannot fit a Markov model to a trace without runs");
+    }
+
+    for (std::size_t s = 0; s < dwells.size(); s++) {
+        State& state = model.state(static_cast<int>(s));
+        for (const auto& entry : transitions[s]) {
+            state.next.add(entry.first, static_cast<double>(entry.second));
+        }
+        for (const auto& entry : dwells[s]) {
+            state.dwell.add(entry.first, static_cast<double>(entry.second));
+        }
+    }
+    return model;
+}
+
+MarkovModel MarkovModel::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open Markov model " + path);
+    }
+
+    MarkovModel model;
+    std::string line;
+    int line_number = 0;
+    bool seen_row = false;
+    while (std::getline(file, line)) {
+        line_number++;
+        const std::string where = path + ":" + std::to_string(line_number);
+
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> fields;
+        std::stringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, ',')) {
+            fields.push_back(trim(field));
+        }
+
+        const std::string& kind = fields[0];
+        const std::size_t expected = kind == "initial" ? 3 : (kind == "transition" || kind == "dwell") ? 4 : 0;
+        if (expected == 0 && !seen_row) {
+            seen_row = true;  // header line
+            continue;
+        }
+        seen_row = true;
+        if (expected == 0 || fields.size() != expected) {
+            throw std::runtime_error(where + ": expected initial,STATE,WEIGHT, transition,FROM,TO,WEIGHT "
+                                             "or dwell,STATE,SECONDS,WEIGHT");
+        }
+
+        long long state = 0;
+        long long second = 0;
+        double weight = 0.0;
+        if (!parseInteger(fields[1], state) || state < 0 || state >= MAX_MODEL_STATES) {
+            throw std::runtime_error(where + ": invalid state '" + fields[1] + "'");
+        }
+        if (!parseWeight(fields.back(), weight)) {
+            throw std::runtime_error(where + ": invalid weight '" + fields.back() + "'");
+        }
+        if (kind == "initial") {
+            model.state(static_cast<int>(state));
+            model.initial.add(static_cast<int>(state), weight);
+            continue;
+        }
+        if (!parseInteger(fields[2], second) || second < (kind == "dwell" ? 1 : 0) ||
+            (kind == "transition" && second >= MAX_MODEL_STATES)) {
+            throw std::runtime_error(where + ": invalid " + (kind == "dwell" ? "dwell time" : "state") +
+                                     " '" + fields[2] + "'");
+        }
+        if (kind == "transition") {
+            model.state(static_cast<int>(second));
+            model.state(static_cast<int>(state)).next.add(static_cast<int>(second), weight);
+        } else {
+            model.state(static_cast<int>(state)).dwell.add(static_cast<std::uint64_t>(second), weight);
+        }
+    }
+
+    model.check(path);
+    return model;
+}
+
+void MarkovModel::save(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not create Markov model " + path);
+    }
+    file << std::setprecision(17);
+    file << "Kind,State,To_or_Seconds,Weight\n";
+
+    const auto weight = [](const std::vector<double>& cumulative, std::size_t i) {
+        return i == 0 ? cumulative[0] : cumulative[i] - cumulative[i - 1];
+    };
+    for (std::size_t i = 0; i < initial.values.size(); i++) {
+        file << "initial," << initial.values[i] << "," << weight(initial.cumulative, i) << "\n";
+    }
+    for (std::size_t s = 0; s < states.size(); s++) {
+        const State& state = states[s];
+        for (std::size_t i = 0; i < state.next.values.size(); i++) {
+            file << "transition," << s << "," << state.next.values[i] << ","
+                 << weight(state.next.cumulative, i) << "\n";
+        }
+        for (std::size_t i = 0; i < state.dwell.values.size(); i++) {
+            file << "dwell," << s << "," << state.dwell.values[i] << ","
+                 << weight(state.dwell.cumulative, i) << "\n";
+        }
+    }
+    if (!file) {
+        throw std::runtime_error("Could not write Markov model " + path);
+    }
+}
+
+MarkovTraceReader::MarkovTraceReader(const MarkovModel& model, std::uint64_t seed, std::uint64_t stream,
+                                     std::uint64_t duration)
+    : model(model), rng(seed, stream), duration(duration) {}
+
+bool MarkovTraceReader::next(TraceRun& run) {
+    if (now >= duration) {
+        return false;
+    }
+    state = state < 0 ? model.initialState(rng.uniform()) : model.nextState(state, rng.uniform());
+    const std::uint64_t dwell = model.dwellTicks(state, rng.uniform());
+
+    run.state = state;
+    run.start = now;
+    run.duration = std::min(dwell, duration - now);
+    run.measured_energy = std::numeric_limits<double>::quiet_NaN();
+    now += run.duration;
+    return true;
+}
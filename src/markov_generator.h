@@ -0,0 +1,93 @@
+/**
+ * markov_generator.h
+ *
+ * Synthetic workloads from a semi-Markov model of the device: the next
+ * state is drawn from the transition probabilities of the current one, and
+ * the time spent in it from that state's dwell-time distribution. Models
+ * are fitted from a measurement trace or loaded from a file, and the
+ * generator is a TraceReader, so synthetic traces of any length feed the
+ * kernel or the fast path directly without intermediate files.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "counter_rng.h"
+#include "trace_reader.h"
+
+class MarkovModel {
+public:
+    // Fits transition probabilities, dwell-time distributions (the
+    // observed run lengths) and the initial state (the first run) from the
+    // runs of `reader`. Throws std::runtime_error for traces with no runs.
+    static MarkovModel fit(TraceReader& reader);
+
+    // Loads a model file with one weighted entry per line:
+    //
+    //   initial,STATE,WEIGHT
+    //   transition,FROM,TO,WEIGHT
+    //   dwell,STATE,SECONDS,WEIGHT
+    //
+    // Weights need not be normalized. Throws std::runtime_error on
+    // malformed files or models that can reach a state without dwell times.
+    static MarkovModel load(const std::string& path);
+
+    // Writes the model in the format read by load().
+    void save(const std::string& path) const;
+
+    int stateCount() const { return static_cast<int>(states.size()); }
+
+    // Draws from the model with uniforms in [0, 1). A state without
+    // outgoing transitions continues from the initial distribution.
+    int initialState(double u) const { return pick(initial, u); }
+    int nextState(int state, double u) const;
+    std::uint64_t dwellTicks(int state, double u) const;
+
+private:
+    // Values with cumulative weights, drawn by binary search.
+    template <typename T>
+    struct Choice {
+        std::vector<T> values;
+        std::vector<double> cumulative;
+
+        void add(T value, double weight);
+        bool empty() const { return values.empty(); }
+    };
+
+    struct State {
+        Choice<int> next;
+        Choice<std::uint64_t> dwell;
+    };
+
+    template <typename T>
+    static T pick(const Choice<T>& choice, double u);
+
+    State& state(int id);
+
+    // Throws if the model can enter a state that has no dwell times.
+    void check(const std::string& where) const;
+
+    Choice<int> initial;
+    std::vector<State> states;
+};
+
+// Endless-looking trace of `duration` ticks drawn from `model`: stream
+// `stream` of seed `seed`, reproducible regardless of which thread reads
+// it or how many other streams exist. The last run is cut at `duration`.
+class MarkovTraceReader : public TraceReader {
+public:
+    MarkovTraceReader(const MarkovModel& model, std::uint64_t seed, std::uint64_t stream,
+                      std::uint64_t duration);
+
+    bool next(TraceRun& run) override;
+
+private:
+    const MarkovModel& model;
+    CounterRng rng;
+    std::uint64_t duration;
+    std::uint64_t now = 0;
+    int state = -1;
+};
@@ -0,0 +1,122 @@
+/**
+ * online_calibration.cpp
+ */
+
+#include "online_calibration.h"
+
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "event_log.h"
+#include "power_model.h"
+#include "validation.h"
+
+OnlineCalibrator::OnlineCalibrator(const PowerTable& model, double threshold_percent,
+                                   double min_seconds)
+    : base(model),
+      live(model),
+      threshold(threshold_percent >= 0.0 ? threshold_percent : VALIDATION_TOLERANCE_PERCENT),
+      min_seconds(min_seconds),
+      estimates(model.stateCount()) {}
+
+bool OnlineCalibrator::addSample(int state, double power, double seconds) {
+    if (!base.contains(state)) {
+        throw std::runtime_error("state " + std::to_string(state) + " is not in the power table (" +
+                                 std::to_string(base.stateCount()) + " states)");
+    }
+    if (!(seconds > 0.0) || std::isnan(power)) {
+        return false;
+    }
+    const bool was_drifted = drifted(state);
+
+    StateEstimate& estimate = estimates[state];
+    estimate.samples++;
+    estimate.seconds += seconds;
+    const double delta = power - estimate.mean;
+    estimate.mean += delta * seconds / estimate.seconds;
+    estimate.m2 += seconds * delta * (power - estimate.mean);
+
+    if (estimate.seconds >= min_seconds) {
+        live.setPower(state, estimate.mean);
+    }
+    return !was_drifted && drifted(state);
+}
+
+bool OnlineCalibrator::addRun(const TraceRun& run) {
+    if (run.duration == 0 || std::isnan(run.measured_energy)) {
+        return false;
+    }
+    const double seconds = ticksToSeconds(run.duration);
+    return addSample(run.state, run.measured_energy / seconds, seconds);
+}
+
+double OnlineCalibrator::errorPercent(int state) const {
+    const StateEstimate& estimate = estimates[state];
+    if (estimate.samples == 0 || estimate.seconds < min_seconds || estimate.mean == 0.0) {
+        return 0.0;
+    }
+    return (base.power(state) - estimate.mean) / estimate.mean * 100.0;
+}
+
+std::vector<int> OnlineCalibrator::driftedStates() const {
+    std::vector<int> states;
+    for (int s = 0; s < base.stateCount(); s++) {
+        if (drifted(s)) {
+            states.push_back(s);
+        }
+    }
+    return states;
+}
+
+void printCalibrationReport(const OnlineCalibrator& calibrator) {
+    if (!logEnabled(Verbosity::Summary)) {
+        return;
+    }
+    const PowerTable& model = calibrator.model();
+    const std::streamsize precision = std::cout.precision();
+    std::cout << "\n=== RECALIBRATION ===" << std::endl;
+    std::cout << std::left << std::setw(24) << "State" << std::right << std::setw(10) << "Samples"
+              << std::setw(12) << "Model_W" << std::setw(12) << "Measured_W" << std::setw(12) << "Stddev_W"
+              << std::setw(10) << "Error_%" << std::endl;
+    for (int s = 0; s < model.stateCount(); s++) {
+        const StateEstimate& estimate = calibrator.estimate(s);
+        std::cout << std::left << std::setw(24) << (std::to_string(s) + " " + model.name(s)) << std::right
+                  << std::setw(10) << estimate.samples << std::fixed << std::setprecision(4)
+                  << std::setw(12) << model.power(s) << std::setw(12) << estimate.mean << std::setw(12)
+                  << estimate.stddev() << std::setw(10) << std::setprecision(2) << calibrator.errorPercent(s)
+                  << (calibrator.drifted(s) ? "  DRIFT" : "") << std::defaultfloat
+                  << std::setprecision(precision) << std::endl;
+    }
+    const std::vector<int> drifted = calibrator.driftedStates();
+    if (drifted.empty()) {
+        std::cout << "✓ All states within " << calibrator.thresholdPercent() << "% of the model" << std::endl;
+    } else {
+        std::cout << "✗ " << drifted.size() << " state(s) drifted past " << calibrator.thresholdPercent()
+                  << "% of the model" << std::endl;
+    }
+}
+
+CalibratingTraceReader::CalibratingTraceReader(std::unique_ptr<TraceReader> source,
+                                               OnlineCalibrator& calibrator,
+                                               std::function<void(int, std::uint64_t)> on_drift)
+    : inner(std::move(source)), calibrator(calibrator), on_drift(std::move(on_drift)) {}
+
+void CalibratingTraceReader::flush() {
+    if (have_pending && calibrator.addRun(pending) && on_drift) {
+        on_drift(pending.state, pending.start + pending.duration);
+    }
+    have_pending = false;
+}
+
+bool CalibratingTraceReader::next(TraceRun& run) {
+    flush();
+    if (!inner->next(run)) {
+        return false;
+    }
+    pending = run;
+    have_pending = true;
+    return true;
+}
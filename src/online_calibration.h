@@ -0,0 +1,104 @@
+/**
+ * online_calibration.h
+ *
+ * Online re-fit of the per-state power constants while measurements stream
+ * in. Every sample updates a running time-weighted mean and variance of its
+ * state in O(1) (Welford's update, in West's weighted form), so the table
+ * never needs a second pass over the measurement file. The live table can
+ * drive a running simulation, and states whose model constant is more than
+ * the validation tolerance away from the measured mean are flagged.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "power_table.h"
+#include "trace_reader.h"
+
+// Running estimate of one state's power.
+struct StateEstimate {
+    std::uint64_t samples = 0;  // a run added with addRun() counts once
+    double seconds = 0.0;  // total weight
+    double mean = 0.0;     // W, time-weighted
+    double m2 = 0.0;       // weighted sum of squared deviations, W^2 s
+
+    double variance() const { return seconds > 0.0 ? m2 / seconds : 0.0; }
+    double stddev() const { return std::sqrt(variance()); }
+};
+
+class OnlineCalibrator {
+public:
+    // Measured time a state needs before its mean replaces the model
+    // constant in the live table and is checked for drift.
+    static constexpr double DEFAULT_MIN_SECONDS = 60.0;
+
+    // Threshold defaults to VALIDATION_TOLERANCE_PERCENT.
+    explicit OnlineCalibrator(const PowerTable& model, double threshold_percent = -1.0,
+                              double min_seconds = DEFAULT_MIN_SECONDS);
+
+    // Adds one measurement of `state` held for `seconds`. Returns true if
+    // this sample made the state drift past the threshold (it was within
+    // it before). Throws std::runtime_error for states missing from the
+    // table.
+    bool addSample(int state, double power, double seconds = 1.0);
+
+    // Adds a run as one sample of its average measured power. Runs without
+    // measured energy or duration are ignored. The mean is the same as
+    // from its individual samples; the variance only sees run averages.
+    bool addRun(const TraceRun& run);
+
+    // Model constants, with the running mean for every state measured for
+    // at least min_seconds. The object stays in place, so an
+    // EnergyAccumulator pointing at it sees every update.
+    const PowerTable& table() const { return live; }
+    const PowerTable& model() const { return base; }
+
+    const StateEstimate& estimate(int state) const { return estimates[state]; }
+
+    // (model - measured mean) / measured mean in percent; 0 for states
+    // measured for less than min_seconds.
+    double errorPercent(int state) const;
+    bool drifted(int state) const { return std::abs(errorPercent(state)) > threshold; }
+    std::vector<int> driftedStates() const;
+
+    double thresholdPercent() const { return threshold; }
+
+private:
+    PowerTable base;
+    PowerTable live;
+    double threshold;
+    double min_seconds;
+    std::vector<StateEstimate> estimates;
+};
+
+// Prints the "=== RECALIBRATION ===" section at Verbosity::Summary: model
+// and measured power, spread and error of every state, drifted states
+// marked.
+void printCalibrationReport(const OnlineCalibrator& calibrator);
+
+// Passes runs through from another reader and feeds their measurements
+// to `calibrator`. Run k is added when run k+1 is requested, so the live
+// table used for a run only reflects the measurements before it.
+class CalibratingTraceReader : public TraceReader {
+public:
+    // `on_drift(state, time)` is called when a state first drifts past the
+    // threshold, with the trace time in seconds; it may be empty.
+    CalibratingTraceReader(std::unique_ptr<TraceReader> source, OnlineCalibrator& calibrator,
+                           std::function<void(int, std::uint64_t)> on_drift = {});
+
+    bool next(TraceRun& run) override;
+
+private:
+    void flush();
+
+    std::unique_ptr<TraceReader> inner;
+    OnlineCalibrator& calibrator;
+    std::function<void(int, std::uint64_t)> on_drift;
+    bool have_pending = false;
+    TraceRun pending;
+};
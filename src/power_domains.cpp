@@ -0,0 +1,211 @@
+/**
+ * power_domains.cpp
+ */
+
+#include "power_domains.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "event_log.h"
+
+namespace {
+
+std::string trim(const std::string& text) {
+    const std::size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    const std::size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+std::vector<std::string> splitFields(const std::string& line) {
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    std::string field;
+    while (std::getline(stream, field, ',')) {
+        fields.push_back(trim(field));
+    }
+    return fields;
+}
+
+int findName(const std::vector<std::string>& names, const std::string& name) {
+    for (std::size_t i = 0; i < names.size(); i++) {
+        if (names[i] == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+// A "Domain=State" pair of a state row, resolved once all domains are
+// known.
+struct Assignment {
+    std::string where;
+    long state;
+    std::string domain;
+    std::string domain_state;
+};
+
+} // namespace
+
+PowerDomains PowerDomains::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open power domains " + path);
+    }
+
+    PowerDomains domains;
+    std::vector<Assignment> assignments;
+    std::vector<bool> defined;
+    std::string line;
+    int line_number = 0;
+    bool seen_row = false;
+    while (std::getline(file, line)) {
+        line_number++;
+        const std::string where = path + ":" + std::to_string(line_number);
+
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        const std::vector<std::string> fields = splitFields(line);
+        const std::string& kind = fields[0];
+        if (kind != "domain" && kind != "state" && !seen_row) {
+            seen_row = true;  // header line
+            continue;
+        }
+        seen_row = true;
+
+        if (kind == "domain") {
+            char* end = nullptr;
+            const double power = fields.size() == 4 ? std::strtod(fields[3].c_str(), &end) : 0.0;
+            if (fields.size() != 4 || fields[1].empty() || fields[2].empty() || fields[3].empty() ||
+                *end != '\0' || !(power >= 0.0)) {
+                throw std::runtime_error(where + ": expected domain,Name,State,Power_W");
+            }
+            int domain = findName(domains.domain_names, fields[1]);
+            if (domain < 0) {
+                domain = domains.domainCount();
+                domains.domain_names.push_back(fields[1]);
+                domains.domain_state_names.emplace_back();
+                domains.domain_power.emplace_back();
+            }
+            if (findName(domains.domain_state_names[domain], fields[2]) >= 0) {
+                throw std::runtime_error(where + ": state " + fields[2] + " of domain " + fields[1] +
+                                         " defined twice");
+            }
+            domains.domain_state_names[domain].push_back(fields[2]);
+            domains.domain_power[domain].push_back(power);
+        } else if (kind == "state") {
+            char* end = nullptr;
+            const long state = fields.size() >= 2 ? std::strtol(fields[1].c_str(), &end, 10) : -1;
+            if (fields.size() < 2 || fields[1].empty() || *end != '\0' || state < 0) {
+                throw std::runtime_error(where + ": expected state,Id,Domain=State,...");
+            }
+            const std::size_t index = static_cast<std::size_t>(state);
+            if (index >= defined.size()) {
+                defined.resize(index + 1, false);
+            }
+            if (defined[index]) {
+                throw std::runtime_error(where + ": state " + std::to_string(state) + " defined twice");
+            }
+            defined[index] = true;
+            for (std::size_t f = 2; f < fields.size(); f++) {
+                const std::size_t equals = fields[f].find('=');
+                if (equals == std::string::npos) {
+                    throw std::runtime_error(where + ": expected Domain=State, got '" + fields[f] + "'");
+                }
+                assignments.push_back({where, state, trim(fields[f].substr(0, equals)),
+                                       trim(fields[f].substr(equals + 1))});
+            }
+        } else {
+            throw std::runtime_error(where + ": unknown row kind '" + kind + "' (expected domain or state)");
+        }
+    }
+
+    if (domains.domain_names.empty() || defined.empty()) {
+        throw std::runtime_error("Power domains " + path + " define no domains or no states");
+    }
+    for (std::size_t i = 0; i < defined.size(); i++) {
+        if (!defined[i]) {
+            throw std::runtime_error("Power domains " + path + " are missing state " + std::to_string(i));
+        }
+    }
+
+    domains.state_count = static_cast<int>(defined.size());
+    const int count = domains.domainCount();
+    domains.assignment.assign(static_cast<std::size_t>(domains.state_count) * count, 0);
+    for (const Assignment& pair : assignments) {
+        const int domain = findName(domains.domain_names, pair.domain);
+        if (domain < 0) {
+            throw std::runtime_error(pair.where + ": unknown domain " + pair.domain);
+        }
+        const int domain_state = findName(domains.domain_state_names[domain], pair.domain_state);
+        if (domain_state < 0) {
+            throw std::runtime_error(pair.where + ": domain " + pair.domain + " has no state " +
+                                     pair.domain_state);
+        }
+        domains.assignment[static_cast<std::size_t>(pair.state) * count + domain] = domain_state;
+    }
+    domains.power_matrix.resize(domains.assignment.size());
+    for (int s = 0; s < domains.state_count; s++) {
+        for (int d = 0; d < count; d++) {
+            const std::size_t cell = static_cast<std::size_t>(s) * count + d;
+            domains.power_matrix[cell] = domains.domain_power[d][domains.assignment[cell]];
+        }
+    }
+    return domains;
+}
+
+PowerTable PowerDomains::table() const {
+    PowerTable summed;
+    for (int s = 0; s < state_count; s++) {
+        std::string name;
+        double power = 0.0;
+        for (int d = 0; d < domainCount(); d++) {
+            name += (d ? " + " : "") + domain_state_names[d][domainState(s, d)];
+            power += row(s)[d];
+        }
+        summed.addState(name, power);
+    }
+    return summed;
+}
+
+void printDomainReport(const DomainEnergy& energy, const std::vector<double>& state_duration) {
+    if (!logEnabled(Verbosity::Summary)) {
+        return;
+    }
+    const PowerDomains& domains = energy.model();
+    double total = 0.0;
+    for (int d = 0; d < domains.domainCount(); d++) {
+        total += energy.energy(d);
+    }
+
+    std::cout << "\n=== POWER DOMAINS ===" << std::endl;
+    std::cout << "Domain,Energy_J,Share_Percent" << std::endl;
+    for (int d = 0; d < domains.domainCount(); d++) {
+        std::cout << domains.domainName(d) << "," << energy.energy(d) << ","
+                  << (total > 0.0 ? energy.energy(d) / total * 100.0 : 0.0) << std::endl;
+    }
+
+    // Time in each domain state, from the trace states that include it.
+    std::cout << "Domain,State,Duration_s,Energy_J" << std::endl;
+    for (int d = 0; d < domains.domainCount(); d++) {
+        std::vector<double> duration(domains.domainStateCount(d), 0.0);
+        for (int s = 0; s < domains.stateCount() && static_cast<std::size_t>(s) < state_duration.size(); s++) {
+            duration[domains.domainState(s, d)] += state_duration[s];
+        }
+        for (int i = 0; i < domains.domainStateCount(d); i++) {
+            if (duration[i] == 0.0) {
+                continue;
+            }
+            std::cout << domains.domainName(d) << "," << domains.domainStateName(d, i) << "," << duration[i]
+                      << "," << duration[i] * domains.domainStatePower(d, i) << std::endl;
+        }
+    }
+}
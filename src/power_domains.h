@@ -0,0 +1,98 @@
+/**
+ * power_domains.h
+ *
+ * Hierarchical power model: the device is a set of domains (CPU, radio,
+ * display, ...), each with its own states and powers, and every trace
+ * state is one combination of domain states. A trace state's power is the
+ * sum of its domains, so adding a radio adds its states once instead of
+ * multiplying the state table (the built-in *_BT states). The combination
+ * table is a dense state-major matrix of domain powers; charging an
+ * interval updates one energy per domain in a loop without branches.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "power_table.h"
+
+class PowerDomains {
+public:
+    // Loads a domain model CSV:
+    //
+    //   Kind,Name,State_or_Assignment,...
+    //   domain,Radio,Bluetooth,0.06           a domain state and its power
+    //   state,3,Base=Office,Radio=Bluetooth   trace state 3
+    //
+    // Domains and their states are numbered in order of appearance. A
+    // domain not assigned in a state row is in its first state. Trace
+    // states must cover 0..N-1 exactly once. Blank lines, lines starting
+    // with '#' and a header line are skipped. Throws std::runtime_error on
+    // malformed files.
+    static PowerDomains load(const std::string& path);
+
+    int domainCount() const { return static_cast<int>(domain_names.size()); }
+    int stateCount() const { return state_count; }
+
+    const std::string& domainName(int domain) const { return domain_names[domain]; }
+    int domainStateCount(int domain) const { return static_cast<int>(domain_power[domain].size()); }
+    const std::string& domainStateName(int domain, int index) const { return domain_state_names[domain][index]; }
+    double domainStatePower(int domain, int index) const { return domain_power[domain][index]; }
+
+    // State of `domain` in trace state `state`.
+    int domainState(int state, int domain) const {
+        return assignment[static_cast<std::size_t>(state) * domainCount() + domain];
+    }
+
+    // Power of every domain in trace state `state`, domainCount() values.
+    const double* row(int state) const {
+        return &power_matrix[static_cast<std::size_t>(state) * domainCount()];
+    }
+
+    // One state per trace state with the summed domain power, named after
+    // its domain states ("Office + Bluetooth").
+    PowerTable table() const;
+
+private:
+    std::vector<std::string> domain_names;
+    std::vector<std::vector<std::string>> domain_state_names;
+    std::vector<std::vector<double>> domain_power;
+    int state_count = 0;
+    std::vector<int> assignment;       // [state * domainCount() + domain]
+    std::vector<double> power_matrix;  // same layout, W
+};
+
+// Energy per domain of a replay, fed by EnergyAccumulator::charge().
+class DomainEnergy {
+public:
+    explicit DomainEnergy(const PowerDomains& domains)
+        : domains(&domains), sum(domains.domainCount(), 0.0), compensation(domains.domainCount(), 0.0) {}
+
+    // Charges every domain for `seconds` in trace state `state`. Kahan
+    // summation keeps long sums exact enough without a branch per term
+    // (domain powers are never negative).
+    void add(int state, double seconds) {
+        const double* power = domains->row(state);
+        const int count = domains->domainCount();
+        for (int d = 0; d < count; d++) {
+            const double term = power[d] * seconds - compensation[d];
+            const double total = sum[d] + term;
+            compensation[d] = (total - sum[d]) - term;
+            sum[d] = total;
+        }
+    }
+
+    const PowerDomains& model() const { return *domains; }
+    double energy(int domain) const { return sum[domain] - compensation[domain]; }
+
+private:
+    const PowerDomains* domains;
+    std::vector<double> sum;
+    std::vector<double> compensation;
+};
+
+// Prints per-domain energy and share, and the time and energy of every
+// domain state given the per-trace-state durations, at Verbosity::Summary.
+void printDomainReport(const DomainEnergy& energy, const std::vector<double>& state_duration);
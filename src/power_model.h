@@ -0,0 +1,244 @@
+/**
+ * power_model.h
+ *
+ * State power characterization and the energy accumulator shared by the
+ * SystemC monitor and the analytic fast path.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "compensated_sum.h"
+#include "energy_index.h"
+#include "power_domains.h"
+#include "power_table.h"
+#include "timeseries.h"
+#include "trace_reader.h"
+#include "transition_matrix.h"
+
+// Simulation time resolution. A tick is one unit of trace time and one
+// unit of SystemC time (sc_time::value()): 1 s for traces with whole-second
+// timings, 1 ms for millisecond traces. Durations stay integer ticks; only
+// energies and reports convert to seconds.
+namespace detail {
+inline std::uint64_t ticks_per_second = 1;
+inline double ticks_per_second_value = 1.0;
+} // namespace detail
+
+inline std::uint64_t ticksPerSecond() {
+    return detail::ticks_per_second;
+}
+
+// Sets the resolution, usually from traceTicksPerSecond() before anything
+// is replayed. Throws std::runtime_error unless `ticks_per_second` is a
+// power of ten up to MAX_TICKS_PER_SECOND.
+inline void setTicksPerSecond(std::uint64_t ticks_per_second) {
+    std::uint64_t power = 1;
+    while (power < ticks_per_second && power < MAX_TICKS_PER_SECOND) {
+        power *= 10;
+    }
+    if (power != ticks_per_second) {
+        throw std::runtime_error("time resolution of " + std::to_string(ticks_per_second) +
+                                 " ticks per second is not a power of ten up to 1 ns");
+    }
+    detail::ticks_per_second = ticks_per_second;
+    detail::ticks_per_second_value = static_cast<double>(ticks_per_second);
+}
+
+// Converts simulation ticks to seconds; a division, so that whole seconds
+// and whole milliseconds convert exactly.
+inline double ticksToSeconds(std::uint64_t ticks) {
+    return static_cast<double>(ticks) / detail::ticks_per_second_value;
+}
+
+// Nearest tick to `seconds` (non-negative).
+inline std::uint64_t secondsToTicks(double seconds) {
+    return static_cast<std::uint64_t>(seconds * detail::ticks_per_second_value + 0.5);
+}
+
+// Piecewise-constant energy integration over state transitions. Time is
+// accumulated in integer ticks and energy with compensated summation, so
+// neither drifts on long traces with millions of small increments. The
+// double fields are the current results and are kept up to date on every
+// charge.
+struct EnergyAccumulator {
+    const PowerTable* table;
+
+    double powerEstimation = 0.0;
+    double energyEstimation = 0.0;
+
+    int previous_status = -1;
+    std::uint64_t transition_count = 0;  // states entered, i.e. transitions + 1
+
+    // State entered first; lets a later segment be stitched to this one.
+    int first_status = -1;
+
+    // Per-state tracking, one entry per table state
+    std::vector<double> state_energy;
+    std::vector<double> state_duration;  // seconds
+
+    // Exact running totals behind the fields above.
+    std::uint64_t total_ticks = 0;
+    CompensatedSum energy_sum;
+    std::vector<CompensatedSum> state_energy_sum;
+    std::vector<std::uint64_t> state_ticks;
+
+    // Optional row of per-state powers used instead of the table's, e.g.
+    // the current temperature row of a ThermalPowerTable. Not owned; must
+    // have an entry for every table state.
+    const double* power_row = nullptr;
+
+    // Optional switching energy per (from, to) state pair, charged when a
+    // transition enters `to`. Not owned; must match the table's states.
+    const TransitionMatrix* transition_costs = nullptr;
+
+    // Transitions per state pair, indexed from * stateCount() + to, and
+    // the switching energy charged for them (included in energyEstimation).
+    std::vector<std::uint64_t> pair_transitions;
+    double transition_energy = 0.0;
+    CompensatedSum transition_energy_sum;
+
+    // Optional windowed output; receives every charged interval.
+    TimeSeriesWriter* timeseries = nullptr;
+
+    // Optional prefix-sum index of the charged energy, for range queries
+    // during or after the replay. Not owned.
+    EnergyIndex* energy_index = nullptr;
+
+    // Optional per-domain energy of a PowerDomains model whose table() is
+    // this accumulator's table. Not owned.
+    DomainEnergy* domain_energy = nullptr;
+
+    explicit EnergyAccumulator(const PowerTable& power_table = PowerTable::builtin())
+        : table(&power_table),
+          state_energy(power_table.stateCount(), 0.0),
+          state_duration(power_table.stateCount(), 0.0),
+          state_energy_sum(power_table.stateCount()),
+          state_ticks(power_table.stateCount(), 0),
+          pair_transitions(static_cast<std::size_t>(power_table.stateCount()) * power_table.stateCount(), 0) {}
+
+    // Charges the current state for `ticks` simulation ticks and returns
+    // the energy.
+    double charge(std::uint64_t ticks) {
+        if (previous_status < 0) {
+            return 0.0;
+        }
+
+        // powerEstimation already holds the power of previous_status.
+        double energy_increment = powerEstimation * ticksToSeconds(ticks);
+
+        // Accumulate total energy
+        total_ticks += ticks;
+        energy_sum.add(energy_increment);
+        energyEstimation = energy_sum.value();
+
+        // Track per-state statistics
+        state_ticks[previous_status] += ticks;
+        state_energy_sum[previous_status].add(energy_increment);
+        state_energy[previous_status] = state_energy_sum[previous_status].value();
+        state_duration[previous_status] = ticksToSeconds(state_ticks[previous_status]);
+        if (timeseries) {
+            timeseries->add(previous_status, ticks, energy_increment);
+        }
+        if (energy_index) {
+            energy_index->add(previous_status, ticks, energy_increment);
+        }
+        if (domain_energy) {
+            domain_energy->add(previous_status, ticksToSeconds(ticks));
+        }
+        return energy_increment;
+    }
+
+    // Switches to `status`, charging the switching energy of the pair if
+    // costs are set; call after charging the previous state. Throws
+    // std::runtime_error for states missing from the table.
+    void enter(int status) {
+        if (!table->contains(status)) {
+            throw std::runtime_error("state " + std::to_string(status) +
+                                     " is not in the power table (" +
+                                     std::to_string(table->stateCount()) + " states)");
+        }
+        if (previous_status >= 0) {
+            const std::size_t pair =
+                static_cast<std::size_t>(previous_status) * table->stateCount() + status;
+            pair_transitions[pair]++;
+            if (transition_costs) {
+                const double cost = transition_costs->cost(pair);
+                energy_sum.add(cost);
+                energyEstimation = energy_sum.value();
+                transition_energy_sum.add(cost);
+                transition_energy = transition_energy_sum.value();
+                if (timeseries) {
+                    timeseries->addSwitch(cost);
+                }
+                if (energy_index) {
+                    energy_index->addSwitch(cost);
+                }
+            }
+        }
+        powerEstimation = power_row ? power_row[status] : table->power(status);
+        transition_count++;
+        if (first_status < 0) {
+            first_status = status;
+        }
+        previous_status = status;
+    }
+
+    // Appends the results of `next`, a replay of the trace segment that
+    // directly follows this one, as if both had run in one pass. This
+    // accumulator's final state must have been charged up to the end of its
+    // segment. The transition into `next`'s first state is counted (and
+    // charged) here, since `next` had no previous state.
+    void merge(const EnergyAccumulator& next) {
+        if (next.first_status < 0) {
+            return;
+        }
+        if (previous_status >= 0) {
+            if (previous_status == next.first_status) {
+                transition_count--;  // a cut inside a run is not a transition
+            } else {
+                const std::size_t pair =
+                    static_cast<std::size_t>(previous_status) * table->stateCount() + next.first_status;
+                pair_transitions[pair]++;
+                if (transition_costs) {
+                    const double cost = transition_costs->cost(pair);
+                    energy_sum.add(cost);
+                    transition_energy_sum.add(cost);
+                }
+            }
+        } else {
+            first_status = next.first_status;
+        }
+
+        transition_count += next.transition_count;
+        total_ticks += next.total_ticks;
+        energy_sum.merge(next.energy_sum);
+        energyEstimation = energy_sum.value();
+        transition_energy_sum.merge(next.transition_energy_sum);
+        transition_energy = transition_energy_sum.value();
+        for (int s = 0; s < table->stateCount(); s++) {
+            state_ticks[s] += next.state_ticks[s];
+            state_energy_sum[s].merge(next.state_energy_sum[s]);
+            state_energy[s] = state_energy_sum[s].value();
+            state_duration[s] = ticksToSeconds(state_ticks[s]);
+        }
+        for (std::size_t pair = 0; pair < pair_transitions.size(); pair++) {
+            pair_transitions[pair] += next.pair_transitions[pair];
+        }
+        previous_status = next.previous_status;
+        powerEstimation = next.powerEstimation;
+    }
+
+    // Switches to another power row (null for the table's powers), e.g.
+    // on a temperature change; call after charging the current state.
+    void setPowerRow(const double* row) {
+        power_row = row;
+        if (previous_status >= 0) {
+            powerEstimation = row ? row[previous_status] : table->power(previous_status);
+        }
+    }
+};
@@ -0,0 +1,120 @@
+/**
+ * power_residuals.cpp
+ *
+ * Compares the state power model with the measured power column of a trace,
+ * sample by sample:
+ *
+ *   power_residuals --trace <trace> [--power-table <table.csv>]
+ *                   [--window SECONDS] [--output <residuals.csv>]
+ *
+ * Replaces the pandas cumulative-energy step of the analysis scripts with a
+ * single streaming pass.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "power_table.h"
+#include "residuals.h"
+
+namespace {
+
+void writeReport(const std::string& path, const ResidualAnalyzer& analyzer, const PowerTable& table) {
+    std::ofstream csv_file(path);
+    if (!csv_file.is_open()) {
+        throw std::runtime_error("Could not create " + path);
+    }
+    csv_file << std::fixed << std::setprecision(6);
+
+    const ResidualTotals& total = analyzer.total();
+    csv_file << "=== OVERALL RESIDUALS ===\n";
+    csv_file << "Samples,Missing_Samples,Duration_s,Measured_J,Model_J,Residual_J,Residual_Percent\n";
+    csv_file << total.samples << "," << analyzer.missingSamples() << "," << total.duration << ","
+             << total.measured_energy << "," << total.model_energy << ","
+             << total.residual() << "," << total.residualPercent() << "\n";
+    csv_file << "\n";
+
+    csv_file << "=== PER-STATE RESIDUALS ===\n";
+    csv_file << "State,State_Name,Samples,Duration_s,Measured_J,Model_J,Residual_J,Residual_Percent,"
+                "Measured_Avg_W,Model_W\n";
+    for (int i = 0; i < table.stateCount(); i++) {
+        const ResidualTotals& state = analyzer.states()[i];
+        const double measured_avg = state.duration > 0.0 ? state.measured_energy / state.duration : 0.0;
+        csv_file << i << "," << table.name(i) << "," << state.samples << "," << state.duration << ","
+                 << state.measured_energy << "," << state.model_energy << ","
+                 << state.residual() << "," << state.residualPercent() << ","
+                 << measured_avg << "," << table.power(i) << "\n";
+    }
+    csv_file << "\n";
+
+    csv_file << "=== PER-WINDOW RESIDUALS (" << analyzer.windowSeconds() << " s) ===\n";
+    csv_file << "Window_Start_s,Samples,Measured_J,Model_J,Residual_J,Residual_Percent,"
+                "Cumulative_Residual_J\n";
+    double cumulative = 0.0;
+    for (const ResidualWindow& window : analyzer.windows()) {
+        cumulative += window.residual();
+        csv_file << window.start << "," << window.samples << ","
+                 << window.measured_energy << "," << window.model_energy << ","
+                 << window.residual() << "," << window.residualPercent() << ","
+                 << cumulative << "\n";
+    }
+
+    if (!csv_file) {
+        throw std::runtime_error("Could not write " + path);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string trace_path;
+    std::string power_table_path;
+    std::string output_path = "residuals.csv";
+    std::uint64_t window = ResidualAnalyzer::DEFAULT_WINDOW;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--trace" && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (arg == "--power-table" && i + 1 < argc) {
+            power_table_path = argv[++i];
+        } else if (arg == "--window" && i + 1 < argc) {
+            window = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--output" && i + 1 < argc) {
+            output_path = argv[++i];
+        } else {
+            trace_path.clear();
+            break;
+        }
+    }
+    if (trace_path.empty() || window == 0) {
+        std::cerr << "Usage: " << argv[0] << " --trace <trace> [--power-table <table.csv>]"
+                  << " [--window SECONDS] [--output <residuals.csv>]" << std::endl;
+        return 1;
+    }
+
+    try {
+        const PowerTable table = power_table_path.empty() ? PowerTable::builtin()
+                                                          : PowerTable::load(power_table_path);
+        ResidualAnalyzer analyzer(table, window);
+        analyzeTraceResiduals(trace_path, analyzer);
+        writeReport(output_path, analyzer, table);
+
+        const ResidualTotals& total = analyzer.total();
+        std::cout << "Samples: " << total.samples << " (" << analyzer.missingSamples()
+                  << " without power)" << std::endl;
+        std::cout << "Measured energy: " << total.measured_energy << " J" << std::endl;
+        std::cout << "Model energy: " << total.model_energy << " J" << std::endl;
+        std::cout << "Residual: " << total.residual() << " J (" << total.residualPercent() << "%)"
+                  << std::endl;
+        std::cout << "Residual report: " << output_path << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
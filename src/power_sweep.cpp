@@ -0,0 +1,365 @@
+/**
+ * power_sweep.cpp
+ *
+ * Evaluates power-table candidates against measurement traces in parallel
+ * and ranks them by per-state energy error:
+ *
+ *   power_sweep --trace <trace> [--trace ...] [--base-table <table.csv>]
+ *               [--table <candidate.csv> ...] [--grid STATE=MIN:MAX:STEP ...]
+ *               [--grid STATE=V1,V2,...] [--jobs N] [--top N]
+ *               [--output <ranked.csv>]
+ *
+ * Candidates are ranked against each trace's own measured energy when the
+ * trace has a power column, and against the built-in measurement
+ * otherwise.
+ *
+ * Every (candidate, trace) pair is one job for the analytic fast path, so no
+ * SystemC kernel is involved and jobs run independently on all cores. Grid
+ * candidates are the cartesian product of the --grid axes applied to the
+ * base table (the built-in model by default).
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "fast_engine.h"
+#include "power_model.h"
+#include "power_table.h"
+#include "thread_pool.h"
+#include "trace_reader.h"
+#include "validation.h"
+
+namespace {
+
+// Grids beyond this are almost certainly a typo in a step size.
+const std::uint64_t MAX_CANDIDATES = 1ull << 26;
+
+struct GridAxis {
+    int state = 0;
+    std::vector<double> values;
+};
+
+struct Candidate {
+    std::string label;
+    std::vector<double> power;
+    double state_error = 0.0;       // mean per-state energy error sum, J
+    double energy_error_pct = 0.0;  // mean absolute total energy error, %
+    double total_energy = 0.0;      // mean total energy, J
+};
+
+double parseValue(const std::string& text, const std::string& spec) {
+    char* end = nullptr;
+    const double value = std::strtod(text.c_str(), &end);
+    if (text.empty() || *end != '\0') {
+        throw std::runtime_error("invalid number '" + text + "' in --grid " + spec);
+    }
+    return value;
+}
+
+// Parses "STATE=MIN:MAX:STEP" or "STATE=V1,V2,...".
+GridAxis parseGridAxis(const std::string& spec) {
+    const std::size_t equals = spec.find('=');
+    if (equals == std::string::npos || equals == 0) {
+        throw std::runtime_error("expected STATE=MIN:MAX:STEP or STATE=V1,V2,... in --grid " + spec);
+    }
+
+    GridAxis axis;
+    char* end = nullptr;
+    const std::string state_text = spec.substr(0, equals);
+    axis.state = static_cast<int>(std::strtol(state_text.c_str(), &end, 10));
+    if (*end != '\0' || axis.state < 0) {
+        throw std::runtime_error("invalid state in --grid " + spec);
+    }
+
+    const std::string range = spec.substr(equals + 1);
+    const std::size_t colon = range.find(':');
+    if (colon != std::string::npos) {
+        const std::size_t colon2 = range.find(':', colon + 1);
+        if (colon2 == std::string::npos) {
+            throw std::runtime_error("expected MIN:MAX:STEP in --grid " + spec);
+        }
+        const double min = parseValue(range.substr(0, colon), spec);
+        const double max = parseValue(range.substr(colon + 1, colon2 - colon - 1), spec);
+        const double step = parseValue(range.substr(colon2 + 1), spec);
+        if (step <= 0.0 || max < min) {
+            throw std::runtime_error("empty range in --grid " + spec);
+        }
+        // Index-based steps avoid accumulating rounding; the small slack
+        // keeps MAX when it is a whole number of steps away.
+        const std::uint64_t steps = static_cast<std::uint64_t>(std::floor((max - min) / step + 1e-9));
+        if (steps >= MAX_CANDIDATES) {
+            throw std::runtime_error("too many values in --grid " + spec);
+        }
+        for (std::uint64_t i = 0; i <= steps; i++) {
+            axis.values.push_back(min + static_cast<double>(i) * step);
+        }
+    } else {
+        std::size_t begin = 0;
+        while (begin <= range.size()) {
+            std::size_t comma = range.find(',', begin);
+            if (comma == std::string::npos) {
+                comma = range.size();
+            }
+            axis.values.push_back(parseValue(range.substr(begin, comma - begin), spec));
+            begin = comma + 1;
+        }
+    }
+    return axis;
+}
+
+// Reads the runs of `path` and the reference metrics to rank against: the
+// trace's own measurement, or the built-in one for traces without power.
+std::vector<TraceRun> readRuns(const std::string& path, ValidationReference& reference) {
+    ReferenceRecorder reader(openTrace(path), path);
+    std::vector<TraceRun> runs;
+    TraceRun run;
+    while (reader.next(run)) {
+        runs.push_back(run);
+    }
+    reference = reader.reference();
+    if (!reference.has_energy) {
+        reference = builtinReference();
+    }
+    return runs;
+}
+
+// Writes grid candidate `index` (mixed radix over the axes, last axis
+// fastest) into `table`.
+void applyGridCandidate(std::uint64_t index, const std::vector<GridAxis>& axes, PowerTable& table) {
+    for (std::size_t a = axes.size(); a-- > 0;) {
+        const std::vector<double>& values = axes[a].values;
+        table.setPower(axes[a].state, values[index % values.size()]);
+        index /= values.size();
+    }
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " --trace <trace> [--trace ...] [--base-table <table.csv>]"
+              << " [--table <candidate.csv> ...] [--grid STATE=MIN:MAX:STEP|STATE=V1,V2,...]"
+              << " [--jobs N] [--top N] [--output <ranked.csv>]" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> trace_paths;
+    std::vector<std::string> table_paths;
+    std::vector<std::string> grid_specs;
+    std::string base_table_path;
+    std::string output_path;
+    unsigned workers = 0;
+    std::size_t top = 10;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--trace" && i + 1 < argc) {
+            trace_paths.push_back(argv[++i]);
+        } else if (arg == "--table" && i + 1 < argc) {
+            table_paths.push_back(argv[++i]);
+        } else if (arg == "--grid" && i + 1 < argc) {
+            grid_specs.push_back(argv[++i]);
+        } else if (arg == "--base-table" && i + 1 < argc) {
+            base_table_path = argv[++i];
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            workers = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--top" && i + 1 < argc) {
+            top = static_cast<std::size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--output" && i + 1 < argc) {
+            output_path = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (trace_paths.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (workers == 0) {
+        workers = defaultWorkerCount();
+    }
+
+    try {
+        PowerTable base = base_table_path.empty() ? PowerTable::builtin()
+                                                  : PowerTable::load(base_table_path);
+
+        std::vector<PowerTable> tables;
+        for (const std::string& path : table_paths) {
+            tables.push_back(PowerTable::load(path));
+            // Every candidate is reported in the base table's Power_<s>_W columns.
+            if (tables.back().stateCount() != base.stateCount()) {
+                throw std::runtime_error(path + " has " + std::to_string(tables.back().stateCount()) +
+                                         " states, the base table has " +
+                                         std::to_string(base.stateCount()));
+            }
+        }
+
+        std::vector<GridAxis> axes;
+        std::uint64_t grid_size = grid_specs.empty() ? 0 : 1;
+        for (const std::string& spec : grid_specs) {
+            axes.push_back(parseGridAxis(spec));
+            if (!base.contains(axes.back().state)) {
+                throw std::runtime_error("--grid " + spec + ": state is not in the base table");
+            }
+            grid_size *= axes.back().values.size();
+            if (grid_size > MAX_CANDIDATES) {
+                throw std::runtime_error("grid has more than " + std::to_string(MAX_CANDIDATES) + " candidates");
+            }
+        }
+        if (tables.empty() && grid_size == 0) {
+            tables.push_back(base);  // evaluate the base table alone
+        }
+
+        const std::size_t candidate_count = tables.size() + grid_size;
+        const std::size_t trace_count = trace_paths.size();
+
+        auto start = std::chrono::steady_clock::now();
+
+        // Energies are integrated at one time resolution for all traces.
+        setTicksPerSecond(traceTicksPerSecond(trace_paths.front()));
+        for (const std::string& path : trace_paths) {
+            if (traceTicksPerSecond(path) != ticksPerSecond()) {
+                throw std::runtime_error(path + " has a different time resolution than " + trace_paths.front());
+            }
+        }
+
+        std::vector<std::vector<TraceRun>> traces(trace_count);
+        std::vector<ValidationReference> references(trace_count);
+        parallelFor(trace_count, workers, [&](std::size_t t, unsigned) {
+            traces[t] = readRuns(trace_paths[t], references[t]);
+        });
+
+        // One slot per (candidate, trace) job; workers write disjoint slots.
+        const std::size_t job_count = candidate_count * trace_count;
+        std::vector<double> job_state_error(job_count);
+        std::vector<double> job_energy(job_count);
+
+        // Grid candidates are built in per-worker scratch tables, so the
+        // grid itself is never materialized.
+        std::vector<PowerTable> scratch(workers, base);
+
+        parallelFor(job_count, workers, [&](std::size_t job, unsigned worker) {
+            const std::size_t c = job / trace_count;
+            const std::vector<TraceRun>& runs = traces[job % trace_count];
+
+            const PowerTable* table = nullptr;
+            if (c < tables.size()) {
+                table = &tables[c];
+            } else {
+                applyGridCandidate(c - tables.size(), axes, scratch[worker]);
+                table = &scratch[worker];
+            }
+
+            EnergyAccumulator accumulator(*table);
+            SpanTraceReader reader(runs.data(), runs.data() + runs.size());
+            integrateTrace(reader, accumulator);
+            job_state_error[job] = stateEnergyErrorSum(accumulator, references[job % trace_count]);
+            job_energy[job] = accumulator.energyEstimation;
+        });
+
+        const double elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+
+        // Reduce over traces and rank.
+        std::vector<std::size_t> order(candidate_count);
+        std::vector<double> state_error(candidate_count, 0.0);
+        std::vector<double> energy_error_pct(candidate_count, 0.0);
+        std::vector<double> total_energy(candidate_count, 0.0);
+        for (std::size_t c = 0; c < candidate_count; c++) {
+            order[c] = c;
+            for (std::size_t t = 0; t < trace_count; t++) {
+                const std::size_t job = c * trace_count + t;
+                state_error[c] += job_state_error[job];
+                total_energy[c] += job_energy[job];
+                const double measured = references[t].total_energy;
+                energy_error_pct[c] += std::abs(job_energy[job] - measured) / measured * 100.0;
+            }
+            state_error[c] /= trace_count;
+            total_energy[c] /= trace_count;
+            energy_error_pct[c] /= trace_count;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+            if (state_error[a] != state_error[b]) {
+                return state_error[a] < state_error[b];
+            }
+            return energy_error_pct[a] < energy_error_pct[b];
+        });
+
+        auto describe = [&](std::size_t c) {
+            Candidate candidate;
+            PowerTable table = base;
+            if (c < tables.size()) {
+                table = tables[c];
+                candidate.label = table_paths.empty() ? "base" : table_paths[c];
+            } else {
+                applyGridCandidate(c - tables.size(), axes, table);
+                candidate.label = "grid:" + std::to_string(c - tables.size());
+            }
+            for (int s = 0; s < table.stateCount(); s++) {
+                candidate.power.push_back(table.power(s));
+            }
+            candidate.state_error = state_error[c];
+            candidate.energy_error_pct = energy_error_pct[c];
+            candidate.total_energy = total_energy[c];
+            return candidate;
+        };
+
+        std::cout << "Evaluated " << candidate_count << " candidates x " << trace_count
+                  << " traces on " << workers << " workers in " << elapsed << " s" << std::endl;
+        std::cout << std::endl;
+        std::cout << std::left << std::setw(6) << "Rank" << std::setw(28) << "Candidate"
+                  << std::right << std::setw(16) << "State_Err_J" << std::setw(14) << "Energy_Err_%"
+                  << "  Power_W" << std::endl;
+        const std::size_t shown = std::min(top, candidate_count);
+        for (std::size_t r = 0; r < shown; r++) {
+            const Candidate candidate = describe(order[r]);
+            std::cout << std::left << std::setw(6) << (r + 1) << std::setw(28) << candidate.label
+                      << std::right << std::fixed << std::setprecision(6)
+                      << std::setw(16) << candidate.state_error
+                      << std::setw(14) << candidate.energy_error_pct << " ";
+            for (double power : candidate.power) {
+                std::cout << " " << std::setprecision(4) << power;
+            }
+            std::cout << std::defaultfloat << std::endl;
+        }
+
+        if (!output_path.empty()) {
+            std::ofstream csv_file(output_path);
+            if (!csv_file.is_open()) {
+                throw std::runtime_error("Could not create " + output_path);
+            }
+            csv_file << "Rank,Candidate,State_Energy_Error_J,Energy_Error_Percent,Total_Energy_J";
+            for (int s = 0; s < base.stateCount(); s++) {
+                csv_file << ",Power_" << s << "_W";
+            }
+            csv_file << "\n" << std::setprecision(10);
+            for (std::size_t r = 0; r < candidate_count; r++) {
+                const Candidate candidate = describe(order[r]);
+                csv_file << (r + 1) << "," << candidate.label << "," << candidate.state_error << ","
+                         << candidate.energy_error_pct << "," << candidate.total_energy;
+                for (double power : candidate.power) {
+                    csv_file << "," << power;
+                }
+                csv_file << "\n";
+            }
+            if (!csv_file) {
+                throw std::runtime_error("Could not write " + output_path);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,150 @@
+/**
+ * power_table.cpp
+ */
+
+#include "power_table.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+std::string trim(const std::string& text) {
+    const std::size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    const std::size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+bool parseInteger(const std::string& text, long& value) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    value = std::strtol(text.c_str(), &end, 10);
+    return *end == '\0';
+}
+
+bool parseNumber(const std::string& text, double& value) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return *end == '\0';
+}
+
+} // namespace
+
+const PowerTable& PowerTable::builtin() {
+    static const PowerTable table = [] {
+        PowerTable builtin_table;
+        builtin_table.addState("At Work (Office)", POWER_OFFICE);
+        builtin_table.addState("Not at Work", POWER_NOT_AT_WORK);
+        builtin_table.addState("At Work (Remote)", POWER_REMOTE);
+        builtin_table.addState("Office Bluetooth", POWER_OFFICE_BT);
+        builtin_table.addState("Remote Bluetooth", POWER_REMOTE_BT);
+        builtin_table.addState("Not at Work Bluetooth", POWER_NOT_AT_WORK_BT);
+        return builtin_table;
+    }();
+    return table;
+}
+
+int PowerTable::addState(const std::string& name, double power) {
+    power_w.push_back(power);
+    names.push_back(name);
+    return stateCount() - 1;
+}
+
+PowerTable PowerTable::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open power table " + path);
+    }
+
+    std::vector<double> power_w;
+    std::vector<std::string> names;
+    std::vector<bool> defined;
+
+    std::string line;
+    int line_number = 0;
+    bool seen_row = false;
+    while (std::getline(file, line)) {
+        line_number++;
+        const std::string where = path + ":" + std::to_string(line_number);
+
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        // The name sits between the first and the last comma, so it may
+        // contain commas itself.
+        const std::size_t first = line.find(',');
+        const std::size_t last = line.rfind(',');
+        if (first == std::string::npos || first == last) {
+            throw std::runtime_error(where + ": expected State,Name,Power_W");
+        }
+
+        long state = 0;
+        double power = 0.0;
+        const bool numeric_state = parseInteger(trim(line.substr(0, first)), state);
+        if (!numeric_state && !seen_row) {
+            seen_row = true;  // header line
+            continue;
+        }
+        seen_row = true;
+        if (!numeric_state || state < 0) {
+            throw std::runtime_error(where + ": invalid state id");
+        }
+        if (!parseNumber(trim(line.substr(last + 1)), power) || power < 0.0) {
+            throw std::runtime_error(where + ": invalid power value");
+        }
+
+        const std::size_t index = static_cast<std::size_t>(state);
+        if (index >= power_w.size()) {
+            power_w.resize(index + 1, 0.0);
+            names.resize(index + 1);
+            defined.resize(index + 1, false);
+        }
+        if (defined[index]) {
+            throw std::runtime_error(where + ": state " + std::to_string(state) + " defined twice");
+        }
+        power_w[index] = power;
+        names[index] = trim(line.substr(first + 1, last - first - 1));
+        defined[index] = true;
+    }
+
+    if (power_w.empty()) {
+        throw std::runtime_error("Power table " + path + " defines no states");
+    }
+    for (std::size_t i = 0; i < defined.size(); i++) {
+        if (!defined[i]) {
+            throw std::runtime_error("Power table " + path + " is missing state " + std::to_string(i));
+        }
+    }
+
+    PowerTable table;
+    table.power_w = std::move(power_w);
+    table.names = std::move(names);
+    return table;
+}
+
+void PowerTable::save(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not create power table " + path);
+    }
+    file << "State,Name,Power_W\n" << std::setprecision(10);
+    for (int i = 0; i < stateCount(); i++) {
+        file << i << "," << names[i] << "," << power_w[i] << "\n";
+    }
+    if (!file) {
+        throw std::runtime_error("Could not write power table " + path);
+    }
+}
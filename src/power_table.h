@@ -0,0 +1,61 @@
+/**
+ * power_table.h
+ *
+ * Per-state power characterization. The built-in 6-state model and the
+ * tables device variants load at runtime are both plain contiguous arrays
+ * indexed by state id.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+constexpr int NUM_STATES = 6;  // states of the built-in model
+
+// Power constants for each state (in Watts)
+constexpr double POWER_OFFICE = 1.0357;
+constexpr double POWER_NOT_AT_WORK = 1.0215;
+constexpr double POWER_REMOTE = 1.0284;
+constexpr double POWER_OFFICE_BT = 1.0960;
+constexpr double POWER_REMOTE_BT = 1.1500;
+constexpr double POWER_NOT_AT_WORK_BT = 1.0925;
+
+// Runtime-sized power table: one contiguous array of power values indexed
+// by state id, plus display names.
+class PowerTable {
+public:
+    PowerTable() = default;
+
+    // The built-in 6-state model, shared by accumulators that are not given
+    // a table explicitly.
+    static const PowerTable& builtin();
+
+    // Loads a "State,Name,Power_W" CSV file. Blank lines and lines starting
+    // with '#' are skipped, as is a header line. State ids must cover
+    // 0..N-1 exactly once, in any order. Throws std::runtime_error on
+    // malformed files.
+    static PowerTable load(const std::string& path);
+
+    // Writes the table in the format read by load().
+    void save(const std::string& path) const;
+
+    // Appends a state with the next free id and returns that id.
+    int addState(const std::string& name, double power);
+
+    int stateCount() const { return static_cast<int>(power_w.size()); }
+
+    bool contains(int state) const {
+        return static_cast<unsigned>(state) < power_w.size();
+    }
+
+    // Unchecked; callers validate the state with contains() first.
+    double power(int state) const { return power_w[state]; }
+    const std::string& name(int state) const { return names[state]; }
+
+    void setPower(int state, double power) { power_w[state] = power; }
+
+private:
+    std::vector<double> power_w;
+    std::vector<std::string> names;
+};
@@ -0,0 +1,143 @@
+/**
+ * profiling.cpp
+ */
+
+#include "profiling.h"
+
+#if defined(POWER_MODEL_PROFILING)
+
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+#include "event_log.h"
+#include "power_model.h"
+
+namespace {
+
+const char* const PHASE_NAMES[] = {
+    "kernel", "trace_read", "signal_write", "monitor", "integration", "logging", "csv_write"};
+
+static_assert(sizeof(PHASE_NAMES) / sizeof(PHASE_NAMES[0]) == static_cast<int>(ProfilePhase::Count),
+              "every phase needs a name");
+
+// Counters of threads that have exited, plus the calibration of
+// profileCycles() against the steady clock since startup.
+struct ProfileTotals {
+    std::mutex mutex;
+    ProfileCounters finished;
+    std::uint64_t start_cycles = profileCycles();
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+};
+
+ProfileTotals& totals() {
+    static ProfileTotals instance;
+    return instance;
+}
+
+void addCounters(ProfileCounters& into, const ProfileCounters& from) {
+    for (int p = 0; p < static_cast<int>(ProfilePhase::Count); p++) {
+        into.cycles[p] += from.cycles[p];
+        into.calls[p] += from.calls[p];
+    }
+    for (int b = 0; b < PROFILE_DURATION_BUCKETS; b++) {
+        into.durations[b] += from.durations[b];
+    }
+}
+
+// Adds a thread's counters to the totals when the thread exits.
+struct ThreadProfile {
+    ProfileCounters counters;
+
+    ~ThreadProfile() {
+        ProfileTotals& all = totals();
+        std::lock_guard<std::mutex> lock(all.mutex);
+        addCounters(all.finished, counters);
+    }
+};
+
+} // namespace
+
+ProfileCounters& profileCounters() {
+    // Construct the totals first so that they outlive every thread's counters.
+    totals();
+    thread_local ThreadProfile profile;
+    return profile.counters;
+}
+
+void printProfileReport() {
+    if (!logEnabled(Verbosity::Summary)) {
+        return;
+    }
+
+    ProfileTotals& all = totals();
+    ProfileCounters sum;
+    {
+        std::lock_guard<std::mutex> lock(all.mutex);
+        addCounters(sum, all.finished);
+    }
+    addCounters(sum, profileCounters());
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                         all.start_time).count();
+    const double cycles_per_ms = elapsed > 0.0
+        ? static_cast<double>(profileCycles() - all.start_cycles) / (elapsed * 1000.0)
+        : 0.0;
+
+    const std::streamsize precision = std::cout.precision();
+    std::cout << "\n=== PROFILE ===" << std::endl;
+    std::cout << std::left << std::setw(14) << "Phase" << std::right << std::setw(12) << "Calls"
+              << std::setw(16) << "Cycles" << std::setw(12) << "ms" << std::setw(14) << "Cycles/call"
+              << std::endl;
+    const auto printRow = [&](const char* name, std::uint64_t calls, std::uint64_t cycles) {
+        std::cout << std::left << std::setw(14) << name << std::right << std::setw(12) << calls
+                  << std::setw(16) << cycles << std::setw(12) << std::fixed << std::setprecision(3)
+                  << (cycles_per_ms > 0.0 ? static_cast<double>(cycles) / cycles_per_ms : 0.0)
+                  << std::setw(14) << std::setprecision(1)
+                  << (calls > 0 ? static_cast<double>(cycles) / static_cast<double>(calls) : 0.0)
+                  << std::defaultfloat << std::setprecision(precision) << std::endl;
+    };
+    for (int p = 0; p < static_cast<int>(ProfilePhase::Count); p++) {
+        if (sum.calls[p] > 0) {
+            printRow(PHASE_NAMES[p], sum.calls[p], sum.cycles[p]);
+        }
+    }
+
+    // Kernel time not spent in the instrumented processes is scheduling,
+    // update and delta-cycle overhead.
+    const int kernel = static_cast<int>(ProfilePhase::Kernel);
+    if (sum.calls[kernel] > 0) {
+        std::uint64_t inside = 0;
+        for (ProfilePhase phase : {ProfilePhase::TraceRead, ProfilePhase::SignalWrite, ProfilePhase::Monitor}) {
+            inside += sum.cycles[static_cast<int>(phase)];
+        }
+        printRow("scheduling", sum.calls[kernel], sum.cycles[kernel] > inside ? sum.cycles[kernel] - inside : 0);
+    }
+
+    std::uint64_t transitions = 0;
+    for (int b = 0; b < PROFILE_DURATION_BUCKETS; b++) {
+        transitions += sum.durations[b];
+    }
+    if (transitions == 0) {
+        return;
+    }
+    std::cout << "Inter-transition durations (" << transitions << " transitions):" << std::endl;
+    std::cout.precision(15);
+    for (int b = 0; b < PROFILE_DURATION_BUCKETS; b++) {
+        if (sum.durations[b] == 0) {
+            continue;
+        }
+        // Buckets count ticks; label them in seconds at the active resolution.
+        std::cout << "  ";
+        if (b <= 1) {
+            std::cout << ticksToSeconds(b) << " s";
+        } else {
+            const std::uint64_t low = 1ull << (b - 1);
+            std::cout << ticksToSeconds(low) << "-" << ticksToSeconds(low * 2 - 1) << " s";
+        }
+        std::cout << ": " << sum.durations[b] << std::endl;
+    }
+    std::cout.precision(precision);
+}
+
+#endif
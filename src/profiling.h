@@ -0,0 +1,105 @@
+/**
+ * profiling.h
+ *
+ * Hot-path instrumentation, compiled in only when POWER_MODEL_PROFILING is
+ * defined (cmake -DPOWER_MODEL_PROFILING=ON). Instrumented code uses the
+ * macros below, which expand to nothing otherwise:
+ *
+ *   PROFILE_SCOPE(phase)      cycles and calls of the enclosing block
+ *   PROFILE_DURATION(ticks)   one inter-transition duration for the histogram
+ *   PROFILE_REPORT()          prints the "=== PROFILE ===" section
+ *
+ * Cycles come from the time-stamp counter on x86 and from the steady clock
+ * elsewhere. Counters are per thread and summed into the report when a
+ * thread exits, so parallel replays need no atomics on the hot path.
+ * Phases nest, e.g. Logging inside Monitor, and are reported inclusive.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#if defined(POWER_MODEL_PROFILING)
+
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+enum class ProfilePhase {
+    Kernel,       // sc_start(), everything the SystemC kernel runs
+    TraceRead,    // TraceReader::next() in the trace source
+    SignalWrite,  // status signal writes
+    Monitor,      // the monitor's status change handler
+    Integration,  // analytic replay (--fast)
+    Logging,      // transition console lines and event log records
+    CsvWrite,     // validation CSV
+    Count
+};
+
+// Histogram of inter-transition durations in power-of-two tick buckets:
+// bucket 0 holds 0, bucket b durations in [2^(b-1), 2^b).
+const int PROFILE_DURATION_BUCKETS = 65;
+
+struct ProfileCounters {
+    std::uint64_t cycles[static_cast<int>(ProfilePhase::Count)] = {};
+    std::uint64_t calls[static_cast<int>(ProfilePhase::Count)] = {};
+    std::uint64_t durations[PROFILE_DURATION_BUCKETS] = {};
+};
+
+// This thread's counters.
+ProfileCounters& profileCounters();
+
+inline std::uint64_t profileCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfilePhase phase)
+        : counters(profileCounters()), phase(static_cast<int>(phase)), start(profileCycles()) {}
+    ~ProfileScope() {
+        counters.cycles[phase] += profileCycles() - start;
+        counters.calls[phase]++;
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    ProfileCounters& counters;
+    int phase;
+    std::uint64_t start;
+};
+
+inline void profileDuration(std::uint64_t ticks) {
+    int bucket = 0;
+    while (ticks != 0) {
+        ticks >>= 1;
+        bucket++;
+    }
+    profileCounters().durations[bucket]++;
+}
+
+// Prints the totals of all threads so far at Verbosity::Summary.
+void printProfileReport();
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(phase) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(ProfilePhase::phase)
+#define PROFILE_DURATION(ticks) profileDuration(ticks)
+#define PROFILE_REPORT() printProfileReport()
+
+#else
+
+#define PROFILE_SCOPE(phase) ((void)0)
+#define PROFILE_DURATION(ticks) ((void)0)
+#define PROFILE_REPORT() ((void)0)
+
+#endif
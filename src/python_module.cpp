@@ -0,0 +1,524 @@
+/**
+ * python_module.cpp
+ *
+ * CPython extension `power_model` over the trace store, the analytic fast
+ * path and validation:
+ *
+ *   import numpy as np
+ *   import power_model
+ *
+ *   store = power_model.TraceStore("states.csv")
+ *   power = np.asarray(store.power)             # zero-copy view
+ *   cumulative = np.asarray(store.energy_prefix)
+ *   result = power_model.integrate(store, power_table="table.csv")
+ *   report = power_model.validate(store)
+ *
+ * Columns are exported through the buffer protocol as read-only 1-D
+ * buffers that keep their owner alive, so numpy.asarray(), memoryview()
+ * and array.array() see the C++ arrays without copying; NumPy is not
+ * needed to build or import the module. Loading and integration release
+ * the GIL. C++ errors are raised as RuntimeError.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "fast_engine.h"
+#include "power_table.h"
+#include "trace_store.h"
+#include "validation.h"
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// Column: a read-only, contiguous 1-D buffer. It either views memory of
+// `owner` (a TraceStore) or owns a copy of a computed result.
+
+struct ColumnObject {
+    PyObject_HEAD
+    PyObject* owner;
+    std::vector<unsigned char>* storage;
+    const void* data;
+    Py_ssize_t shape[1];
+    Py_ssize_t strides[1];
+    const char* format;
+};
+
+void columnDealloc(PyObject* self) {
+    ColumnObject* column = reinterpret_cast<ColumnObject*>(self);
+    Py_XDECREF(column->owner);
+    delete column->storage;
+    Py_TYPE(self)->tp_free(self);
+}
+
+int columnGetBuffer(PyObject* self, Py_buffer* view, int flags) {
+    ColumnObject* column = reinterpret_cast<ColumnObject*>(self);
+    if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "power_model columns are read-only");
+        view->obj = nullptr;
+        return -1;
+    }
+    view->buf = const_cast<void*>(column->data);
+    view->obj = self;
+    Py_INCREF(self);
+    view->itemsize = column->strides[0];
+    view->len = column->shape[0] * column->strides[0];
+    view->readonly = 1;
+    view->ndim = 1;
+    view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>(column->format) : nullptr;
+    view->shape = (flags & PyBUF_ND) ? column->shape : nullptr;
+    view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? column->strides : nullptr;
+    view->suboffsets = nullptr;
+    view->internal = nullptr;
+    return 0;
+}
+
+Py_ssize_t columnLength(PyObject* self) {
+    return reinterpret_cast<ColumnObject*>(self)->shape[0];
+}
+
+PyBufferProcs column_buffer = {columnGetBuffer, nullptr};
+PySequenceMethods column_sequence = [] {
+    PySequenceMethods methods{};
+    methods.sq_length = columnLength;
+    return methods;
+}();
+
+PyTypeObject ColumnType = [] {
+    PyTypeObject type{};
+    Py_SET_REFCNT(&type, 1);  // as PyVarObject_HEAD_INIT(nullptr, 0)
+    type.tp_name = "power_model.Column";
+    type.tp_doc = "Read-only 1-D buffer over a power_model array; use numpy.asarray() or memoryview().";
+    type.tp_basicsize = sizeof(ColumnObject);
+    type.tp_flags = Py_TPFLAGS_DEFAULT;
+    type.tp_dealloc = columnDealloc;
+    type.tp_as_buffer = &column_buffer;
+    type.tp_as_sequence = &column_sequence;
+    return type;
+}();
+
+template <typename T> const char* formatOf();
+template <> const char* formatOf<double>() { return "d"; }
+template <> const char* formatOf<std::uint64_t>() { return "Q"; }
+template <> const char* formatOf<std::uint16_t>() { return "H"; }
+
+// A column viewing `length` values at `data`, which `owner` keeps alive.
+template <typename T>
+PyObject* viewColumn(PyObject* owner, const T* data, std::uint64_t length) {
+    ColumnObject* column = PyObject_New(ColumnObject, &ColumnType);
+    if (!column) {
+        return nullptr;
+    }
+    Py_INCREF(owner);
+    column->owner = owner;
+    column->storage = nullptr;
+    column->data = data;
+    column->shape[0] = static_cast<Py_ssize_t>(length);
+    column->strides[0] = sizeof(T);
+    column->format = formatOf<T>();
+    return reinterpret_cast<PyObject*>(column);
+}
+
+// A column owning a copy of `values`.
+template <typename T>
+PyObject* copyColumn(const std::vector<T>& values) {
+    ColumnObject* column = PyObject_New(ColumnObject, &ColumnType);
+    if (!column) {
+        return nullptr;
+    }
+    const std::size_t bytes = values.size() * sizeof(T);
+    column->owner = nullptr;
+    column->storage = new std::vector<unsigned char>(bytes);
+    if (bytes > 0) {
+        std::memcpy(column->storage->data(), values.data(), bytes);
+    }
+    column->data = column->storage->data();
+    column->shape[0] = static_cast<Py_ssize_t>(values.size());
+    column->strides[0] = sizeof(T);
+    column->format = formatOf<T>();
+    return reinterpret_cast<PyObject*>(column);
+}
+
+// ---------------------------------------------------------------------------
+// Result dictionaries.
+
+// Sets d[key] = value and drops the reference; false when value is null.
+bool setItem(PyObject* dict, const char* key, PyObject* value) {
+    if (!value) {
+        return false;
+    }
+    const int status = PyDict_SetItemString(dict, key, value);
+    Py_DECREF(value);
+    return status == 0;
+}
+
+PyObject* referenceDict(const ValidationReference& reference) {
+    PyObject* dict = PyDict_New();
+    if (!dict || !setItem(dict, "source", PyUnicode_FromString(reference.source.c_str())) ||
+        !setItem(dict, "has_energy", PyBool_FromLong(reference.has_energy)) ||
+        !setItem(dict, "energy", PyFloat_FromDouble(reference.total_energy)) ||
+        !setItem(dict, "average_power", PyFloat_FromDouble(reference.average_power)) ||
+        !setItem(dict, "duration", PyFloat_FromDouble(reference.duration)) ||
+        !setItem(dict, "transitions", PyLong_FromUnsignedLongLong(reference.transitions)) ||
+        !setItem(dict, "state_energy", copyColumn(reference.state_energy)) ||
+        !setItem(dict, "state_duration", copyColumn(reference.state_duration))) {
+        Py_XDECREF(dict);
+        return nullptr;
+    }
+    return dict;
+}
+
+PyObject* accumulatorDict(const EnergyAccumulator& accumulator) {
+    const double duration = ticksToSeconds(accumulator.total_ticks);
+    const std::uint64_t transitions = accumulator.transition_count > 0 ? accumulator.transition_count - 1 : 0;
+    PyObject* dict = PyDict_New();
+    if (!dict || !setItem(dict, "energy", PyFloat_FromDouble(accumulator.energyEstimation)) ||
+        !setItem(dict, "average_power",
+                 PyFloat_FromDouble(duration > 0.0 ? accumulator.energyEstimation / duration : 0.0)) ||
+        !setItem(dict, "duration", PyFloat_FromDouble(duration)) ||
+        !setItem(dict, "transitions", PyLong_FromUnsignedLongLong(transitions)) ||
+        !setItem(dict, "transition_energy", PyFloat_FromDouble(accumulator.transition_energy)) ||
+        !setItem(dict, "state_energy", copyColumn(accumulator.state_energy)) ||
+        !setItem(dict, "state_duration", copyColumn(accumulator.state_duration))) {
+        Py_XDECREF(dict);
+        return nullptr;
+    }
+    return dict;
+}
+
+// ---------------------------------------------------------------------------
+// TraceStore.
+
+struct StoreObject {
+    PyObject_HEAD
+    TraceStore* store;
+};
+
+PyObject* storeNew(PyTypeObject* type, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"path", nullptr};
+    const char* path = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s", const_cast<char**>(keywords), &path)) {
+        return nullptr;
+    }
+    std::unique_ptr<TraceStore> store;
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        store.reset(new TraceStore(TraceStore::load(path)));
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+    Py_END_ALLOW_THREADS
+    if (!store) {
+        PyErr_SetString(PyExc_RuntimeError, error.c_str());
+        return nullptr;
+    }
+    StoreObject* self = reinterpret_cast<StoreObject*>(type->tp_alloc(type, 0));
+    if (!self) {
+        return nullptr;
+    }
+    self->store = store.release();
+    return reinterpret_cast<PyObject*>(self);
+}
+
+void storeDealloc(PyObject* self) {
+    delete reinterpret_cast<StoreObject*>(self)->store;
+    Py_TYPE(self)->tp_free(self);
+}
+
+const TraceStore& storeOf(PyObject* self) {
+    return *reinterpret_cast<StoreObject*>(self)->store;
+}
+
+Py_ssize_t storeLength(PyObject* self) {
+    return static_cast<Py_ssize_t>(storeOf(self).size());
+}
+
+PyObject* storeTimestamps(PyObject* self, void*) {
+    const TraceStore& store = storeOf(self);
+    return viewColumn(self, store.timestamps(), store.size());
+}
+
+PyObject* storeStates(PyObject* self, void*) {
+    const TraceStore& store = storeOf(self);
+    return viewColumn(self, store.states(), store.size());
+}
+
+PyObject* storePower(PyObject* self, void*) {
+    const TraceStore& store = storeOf(self);
+    if (!store.hasPower()) {
+        Py_RETURN_NONE;
+    }
+    return viewColumn(self, store.power(), store.size());
+}
+
+PyObject* storeEnergyPrefix(PyObject* self, void*) {
+    const TraceStore& store = storeOf(self);
+    if (!store.hasPower()) {
+        Py_RETURN_NONE;
+    }
+    return viewColumn(self, store.energyPrefix(), store.size() + 1);
+}
+
+PyObject* storeRunStates(PyObject* self, void*) {
+    const TraceStore& store = storeOf(self);
+    return viewColumn(self, store.runStates(), store.runCount());
+}
+
+PyObject* storeRunStarts(PyObject* self, void*) {
+    const TraceStore& store = storeOf(self);
+    return viewColumn(self, store.runStarts(), store.runCount());
+}
+
+PyObject* storeRunDurations(PyObject* self, void*) {
+    const TraceStore& store = storeOf(self);
+    return viewColumn(self, store.runDurations(), store.runCount());
+}
+
+PyObject* storeRunEnergies(PyObject* self, void*) {
+    const TraceStore& store = storeOf(self);
+    return viewColumn(self, store.runEnergies(), store.runCount());
+}
+
+PyObject* storePath(PyObject* self, void*) {
+    return PyUnicode_FromString(storeOf(self).path().c_str());
+}
+
+PyObject* storeDuration(PyObject* self, void*) {
+    return PyLong_FromUnsignedLongLong(storeOf(self).duration());
+}
+
+PyObject* storeSamplePeriod(PyObject* self, void*) {
+    return PyLong_FromUnsignedLongLong(storeOf(self).samplePeriod());
+}
+
+PyObject* storeTicksPerSecond(PyObject* self, void*) {
+    return PyLong_FromUnsignedLongLong(storeOf(self).ticksPerSecond());
+}
+
+PyObject* storeStateCount(PyObject* self, void*) {
+    return PyLong_FromLong(storeOf(self).stateCount());
+}
+
+PyObject* storeHasPower(PyObject* self, void*) {
+    return PyBool_FromLong(storeOf(self).hasPower());
+}
+
+PyObject* storeQuery(PyObject* self, PyObject* args) {
+    unsigned long long from = 0;
+    unsigned long long to = 0;
+    if (!PyArg_ParseTuple(args, "KK", &from, &to)) {
+        return nullptr;
+    }
+    const RangeStats stats = storeOf(self).query(from, to);
+    PyObject* dict = PyDict_New();
+    if (!dict || !setItem(dict, "from", PyLong_FromUnsignedLongLong(stats.from)) ||
+        !setItem(dict, "to", PyLong_FromUnsignedLongLong(stats.to)) ||
+        !setItem(dict, "transitions", PyLong_FromUnsignedLongLong(stats.transitions)) ||
+        !setItem(dict, "energy", PyFloat_FromDouble(stats.energy)) ||
+        !setItem(dict, "state_duration", copyColumn(stats.state_duration)) ||
+        !setItem(dict, "state_energy", copyColumn(stats.state_energy)) ||
+        !setItem(dict, "state_runs", copyColumn(stats.state_runs))) {
+        Py_XDECREF(dict);
+        return nullptr;
+    }
+    return dict;
+}
+
+PyObject* storeMeasuredEnergy(PyObject* self, PyObject* args) {
+    unsigned long long from = 0;
+    unsigned long long to = 0;
+    if (!PyArg_ParseTuple(args, "KK", &from, &to)) {
+        return nullptr;
+    }
+    return PyFloat_FromDouble(storeOf(self).measuredEnergy(from, to));
+}
+
+PyObject* storeReference(PyObject* self, PyObject*) {
+    return referenceDict(storeOf(self).reference());
+}
+
+PyGetSetDef store_getset[] = {
+    {"timestamps", storeTimestamps, nullptr, "Sample timestamps in ticks (uint64).", nullptr},
+    {"states", storeStates, nullptr, "Sample state ids (uint16).", nullptr},
+    {"power", storePower, nullptr, "Measured power in W (float64), None without power.", nullptr},
+    {"energy_prefix", storeEnergyPrefix, nullptr,
+     "Measured energy in J before each sample and in total (float64, len + 1), None without power.", nullptr},
+    {"run_states", storeRunStates, nullptr, "State of each run (uint16).", nullptr},
+    {"run_starts", storeRunStarts, nullptr, "Start of each run in ticks (uint64).", nullptr},
+    {"run_durations", storeRunDurations, nullptr, "Duration of each run in ticks (uint64).", nullptr},
+    {"run_energies", storeRunEnergies, nullptr, "Measured energy of each run in J (float64, NaN without power).",
+     nullptr},
+    {"path", storePath, nullptr, "Path the trace was loaded from.", nullptr},
+    {"duration", storeDuration, nullptr, "End of the last sample in ticks.", nullptr},
+    {"sample_period", storeSamplePeriod, nullptr, "Sample period in ticks.", nullptr},
+    {"ticks_per_second", storeTicksPerSecond, nullptr, "Time resolution: 1 for whole-second timings, 1000 for ms.",
+     nullptr},
+    {"state_count", storeStateCount, nullptr, "Highest state id plus one.", nullptr},
+    {"has_power", storeHasPower, nullptr, "Whether the trace has a power column.", nullptr},
+    {nullptr, nullptr, nullptr, nullptr, nullptr}
+};
+
+PyMethodDef store_methods[] = {
+    {"query", storeQuery, METH_VARARGS,
+     "query(from, to) -> dict of the per-state duration, measured energy and runs of [from, to) ticks."},
+    {"measured_energy", storeMeasuredEnergy, METH_VARARGS,
+     "measured_energy(from, to) -> measured energy in J of [from, to) ticks."},
+    {"reference", storeReference, METH_NOARGS,
+     "reference() -> the whole trace as a validation reference dict."},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+PySequenceMethods store_sequence = [] {
+    PySequenceMethods methods{};
+    methods.sq_length = storeLength;
+    return methods;
+}();
+
+PyTypeObject StoreType = [] {
+    PyTypeObject type{};
+    Py_SET_REFCNT(&type, 1);  // as PyVarObject_HEAD_INIT(nullptr, 0)
+    type.tp_name = "power_model.TraceStore";
+    type.tp_doc = "TraceStore(path): a CSV or binary trace loaded into memory with a run index.";
+    type.tp_basicsize = sizeof(StoreObject);
+    type.tp_flags = Py_TPFLAGS_DEFAULT;
+    type.tp_new = storeNew;
+    type.tp_dealloc = storeDealloc;
+    type.tp_getset = store_getset;
+    type.tp_methods = store_methods;
+    type.tp_as_sequence = &store_sequence;
+    return type;
+}();
+
+// ---------------------------------------------------------------------------
+// Module functions.
+
+// Replays `store` with the table at `table_path` (built-in when null).
+// Returns false with a Python error set.
+bool integrateStore(const TraceStore& store, const char* table_path, unsigned jobs,
+                    EnergyAccumulator& accumulator, PowerTable& table) {
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        table = table_path ? PowerTable::load(table_path) : PowerTable::builtin();
+        setTicksPerSecond(store.ticksPerSecond());
+        accumulator = EnergyAccumulator(table);
+        integrateTraceParallel(store, accumulator, jobs);
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+    Py_END_ALLOW_THREADS
+    if (!error.empty()) {
+        PyErr_SetString(PyExc_RuntimeError, error.c_str());
+        return false;
+    }
+    return true;
+}
+
+PyObject* integrate(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"store", "power_table", "jobs", nullptr};
+    PyObject* store = nullptr;
+    const char* table_path = nullptr;
+    unsigned int jobs = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!|zI", const_cast<char**>(keywords), &StoreType, &store,
+                                     &table_path, &jobs)) {
+        return nullptr;
+    }
+    PowerTable table = PowerTable::builtin();
+    EnergyAccumulator accumulator(table);
+    if (!integrateStore(storeOf(store), table_path, jobs, accumulator, table)) {
+        return nullptr;
+    }
+    return accumulatorDict(accumulator);
+}
+
+PyObject* validate(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"store", "power_table", "jobs", "reference", nullptr};
+    PyObject* store = nullptr;
+    const char* table_path = nullptr;
+    unsigned int jobs = 0;
+    const char* reference_path = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!|zIz", const_cast<char**>(keywords), &StoreType, &store,
+                                     &table_path, &jobs, &reference_path)) {
+        return nullptr;
+    }
+    PowerTable table = PowerTable::builtin();
+    EnergyAccumulator accumulator(table);
+    if (!integrateStore(storeOf(store), table_path, jobs, accumulator, table)) {
+        return nullptr;
+    }
+    ValidationReference reference;
+    try {
+        reference = reference_path ? ValidationReference::load(reference_path) : storeOf(store).reference();
+    } catch (const std::exception& e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+
+    const double error_percent =
+        reference.has_energy ? std::abs(accumulator.energyEstimation - reference.total_energy) /
+                                   reference.total_energy * 100.0
+                             : std::numeric_limits<double>::quiet_NaN();
+    PyObject* dict = PyDict_New();
+    if (!dict || !setItem(dict, "model", accumulatorDict(accumulator)) ||
+        !setItem(dict, "reference", referenceDict(reference)) ||
+        !setItem(dict, "error_percent", PyFloat_FromDouble(error_percent)) ||
+        !setItem(dict, "state_energy_error_sum", PyFloat_FromDouble(stateEnergyErrorSum(accumulator, reference))) ||
+        !setItem(dict, "passed", PyBool_FromLong(error_percent < VALIDATION_TOLERANCE_PERCENT))) {
+        Py_XDECREF(dict);
+        return nullptr;
+    }
+    return dict;
+}
+
+PyMethodDef module_methods[] = {
+    {"integrate", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(integrate)),
+     METH_VARARGS | METH_KEYWORDS,
+     "integrate(store, power_table=None, jobs=0) -> dict of the model energy, durations and transitions.\n\n"
+     "Runs the analytic fast path over the store on `jobs` threads (0 = all cores), with the built-in "
+     "table or the power table CSV at `power_table`."},
+    {"validate", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(validate)),
+     METH_VARARGS | METH_KEYWORDS,
+     "validate(store, power_table=None, jobs=0, reference=None) -> dict of the model, the reference and "
+     "the errors.\n\nThe reference is the trace itself, or the reference CSV at `reference`."},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+PyModuleDef module_definition = {
+    PyModuleDef_HEAD_INIT,
+    "power_model",
+    "Trace store, analytic fast path and validation of the DVCon power model.",
+    -1,
+    module_methods,
+    nullptr, nullptr, nullptr, nullptr
+};
+
+} // namespace
+
+PyMODINIT_FUNC PyInit_power_model() {
+    if (PyType_Ready(&ColumnType) < 0 || PyType_Ready(&StoreType) < 0) {
+        return nullptr;
+    }
+    PyObject* module = PyModule_Create(&module_definition);
+    if (!module) {
+        return nullptr;
+    }
+    Py_INCREF(&StoreType);
+    if (PyModule_AddObject(module, "TraceStore", reinterpret_cast<PyObject*>(&StoreType)) < 0 ||
+        PyModule_AddObject(module, "VALIDATION_TOLERANCE_PERCENT",
+                           PyFloat_FromDouble(VALIDATION_TOLERANCE_PERCENT)) < 0) {
+        Py_DECREF(&StoreType);
+        Py_DECREF(module);
+        return nullptr;
+    }
+    return module;
+}
@@ -0,0 +1,166 @@
+/**
+ * residuals.cpp
+ */
+
+#include "residuals.h"
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "binary_trace.h"
+#include "trace_reader.h"
+
+namespace {
+
+// Samples per block handed to the analyzer; fits comfortably in L2.
+const std::size_t BLOCK_SIZE = 4096;
+
+// Integrates the valid (non-NaN) powers of a contiguous block over their
+// ticks: sample k lasts until timestamps[k + 1], the last one until `end`.
+// Returns power x ticks and sets `valid` and `valid_ticks` for the samples
+// counted. Four independent partial sums break the dependency chain so the
+// loop pipelines without reassociation flags.
+double integrateValidPower(const std::uint64_t* timestamps, const double* power, std::size_t count,
+                           std::uint64_t end, std::size_t& valid, std::uint64_t& valid_ticks) {
+    double sum[4] = {0.0, 0.0, 0.0, 0.0};
+    std::size_t n[4] = {0, 0, 0, 0};
+    std::uint64_t ticks[4] = {0, 0, 0, 0};
+    const std::size_t body = count > 0 ? count - 1 : 0;  // samples followed by one in the block
+    std::size_t i = 0;
+    for (; i + 4 <= body; i += 4) {
+        for (int k = 0; k < 4; k++) {
+            const double value = power[i + k];
+            const std::uint64_t span = timestamps[i + k + 1] - timestamps[i + k];
+            const bool ok = (value == value);
+            sum[k] += ok ? value * static_cast<double>(span) : 0.0;
+            n[k] += ok;
+            ticks[k] += ok ? span : 0;
+        }
+    }
+    for (; i < count; i++) {
+        const double value = power[i];
+        const std::uint64_t span = (i + 1 < count ? timestamps[i + 1] : end) - timestamps[i];
+        const bool ok = (value == value);
+        sum[0] += ok ? value * static_cast<double>(span) : 0.0;
+        n[0] += ok;
+        ticks[0] += ok ? span : 0;
+    }
+    valid = n[0] + n[1] + n[2] + n[3];
+    valid_ticks = ticks[0] + ticks[1] + ticks[2] + ticks[3];
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+} // namespace
+
+ResidualAnalyzer::ResidualAnalyzer(const PowerTable& table, std::uint64_t window_seconds)
+    : table(&table), window_seconds(window_seconds > 0 ? window_seconds : DEFAULT_WINDOW),
+      state_totals(table.stateCount()) {
+}
+
+void ResidualAnalyzer::addBlock(const std::uint64_t* timestamps, const double* power,
+                                const std::uint16_t* states, std::size_t count,
+                                std::uint64_t end, std::uint64_t ticks_per_second) {
+    const std::uint64_t window_ticks = window_seconds * ticks_per_second;
+    std::size_t i = 0;
+    while (i < count) {
+        // Segment: same state, same window.
+        const int state = states[i];
+        const std::uint64_t window_start = timestamps[i] / window_ticks * window_ticks;
+        const std::uint64_t window_end = window_start + window_ticks;
+        std::size_t j = i + 1;
+        while (j < count && states[j] == state && timestamps[j] < window_end) {
+            j++;
+        }
+        addSegment(state, window_start / ticks_per_second, timestamps + i, power + i, j - i,
+                   j < count ? timestamps[j] : end, ticks_per_second);
+        i = j;
+    }
+}
+
+void ResidualAnalyzer::addSegment(int state, std::uint64_t window_start,
+                                  const std::uint64_t* timestamps, const double* power,
+                                  std::size_t count, std::uint64_t end,
+                                  std::uint64_t ticks_per_second) {
+    if (!table->contains(state)) {
+        throw std::runtime_error("state " + std::to_string(state) + " is not in the power table (" +
+                                 std::to_string(table->stateCount()) + " states)");
+    }
+
+    std::size_t valid = 0;
+    std::uint64_t valid_ticks = 0;
+    const double measured =
+        integrateValidPower(timestamps, power, count, end, valid, valid_ticks) /
+        static_cast<double>(ticks_per_second);
+    const double duration = traceSeconds(valid_ticks, ticks_per_second);
+    const double model = table->power(state) * duration;
+    missing += count - valid;
+
+    if (window_totals.empty() || window_totals.back().start != window_start) {
+        ResidualWindow window;
+        window.start = window_start;
+        window_totals.push_back(window);
+    }
+
+    ResidualTotals* targets[3] = {&totals, &state_totals[state], &window_totals.back()};
+    for (ResidualTotals* target : targets) {
+        target->samples += valid;
+        target->duration += duration;
+        target->measured_energy += measured;
+        target->model_energy += model;
+    }
+}
+
+void analyzeTraceResiduals(const std::string& path, ResidualAnalyzer& analyzer) {
+    if (isBinaryTrace(path)) {
+        // Columns are contiguous in the mapping; feed them in place.
+        MappedTrace trace(path);
+        if (!trace.hasPower() || !trace.hasStates()) {
+            throw std::runtime_error(path + " needs both power and state columns");
+        }
+        for (std::uint64_t i = 0; i < trace.size(); i += BLOCK_SIZE) {
+            const std::size_t count = static_cast<std::size_t>(
+                trace.size() - i < BLOCK_SIZE ? trace.size() - i : BLOCK_SIZE);
+            // The last sample of the trace lasts one sample period.
+            const std::uint64_t end = i + count < trace.size()
+                                          ? trace.timestamps()[i + count]
+                                          : trace.timestamps()[i + count - 1] + trace.samplePeriod();
+            analyzer.addBlock(trace.timestamps() + i, trace.power() + i, trace.states() + i,
+                              count, end, trace.ticksPerSecond());
+        }
+        return;
+    }
+
+    CsvTraceReader reader(path);
+    std::vector<std::uint64_t> timestamps(BLOCK_SIZE);
+    std::vector<double> power(BLOCK_SIZE);
+    std::vector<std::uint16_t> states(BLOCK_SIZE);
+    std::size_t count = 0;
+    TraceSample sample;
+    bool more = true;
+    while (more) {
+        more = reader.nextSample(sample);
+        // A full block waits for the next sample, which ends its last one;
+        // the last sample of the trace lasts one sample period.
+        if (count == BLOCK_SIZE || (!more && count > 0)) {
+            const std::uint64_t end = more ? sample.timestamp
+                                           : timestamps[count - 1] + reader.samplePeriod();
+            analyzer.addBlock(timestamps.data(), power.data(), states.data(), count, end,
+                              reader.ticksPerSecond());
+            count = 0;
+        }
+        if (more) {
+            if (!reader.hasPower() || !reader.hasStatus()) {
+                throw std::runtime_error(path + " needs both Power [W] and Status columns");
+            }
+            if (sample.state < 0 || sample.state > std::numeric_limits<std::uint16_t>::max()) {
+                throw std::runtime_error(path + ": state " + std::to_string(sample.state) +
+                                         " cannot be stored");
+            }
+            timestamps[count] = sample.timestamp;
+            power[count] = sample.power;
+            states[count] = static_cast<std::uint16_t>(sample.state);
+            count++;
+        }
+    }
+}
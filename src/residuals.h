@@ -0,0 +1,75 @@
+/**
+ * residuals.h
+ *
+ * Sample-level comparison of the state power model with the measured power
+ * column. Both energies are integrated in one streaming pass over blocks of
+ * contiguous samples, and the residual (model - measured) is reported in
+ * total, per state and per fixed-length time window.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "power_table.h"
+
+struct ResidualTotals {
+    std::uint64_t samples = 0;
+    double duration = 0.0;         // seconds
+    double measured_energy = 0.0;  // J
+    double model_energy = 0.0;     // J
+
+    double residual() const { return model_energy - measured_energy; }
+    double residualPercent() const {
+        return measured_energy != 0.0 ? residual() / measured_energy * 100.0 : 0.0;
+    }
+};
+
+struct ResidualWindow : ResidualTotals {
+    std::uint64_t start = 0;  // seconds
+};
+
+class ResidualAnalyzer {
+public:
+    static constexpr std::uint64_t DEFAULT_WINDOW = 3600;  // seconds
+
+    ResidualAnalyzer(const PowerTable& table, std::uint64_t window_seconds = DEFAULT_WINDOW);
+
+    // Integrates `count` consecutive samples, timestamped in ticks of
+    // 1 / ticks_per_second s. Each sample lasts until the next one, like the
+    // measured energy of TraceRun; the last lasts until tick `end`, the
+    // timestamp of the sample after the block or the end of the trace.
+    // Timestamps must not decrease across calls. Samples without a
+    // measured power (NaN) are skipped and counted as missing. Throws
+    // std::runtime_error for states missing from the table.
+    void addBlock(const std::uint64_t* timestamps, const double* power,
+                  const std::uint16_t* states, std::size_t count,
+                  std::uint64_t end, std::uint64_t ticks_per_second = 1);
+
+    const ResidualTotals& total() const { return totals; }
+    const std::vector<ResidualTotals>& states() const { return state_totals; }
+    const std::vector<ResidualWindow>& windows() const { return window_totals; }
+
+    std::uint64_t windowSeconds() const { return window_seconds; }
+    std::uint64_t missingSamples() const { return missing; }
+
+private:
+    void addSegment(int state, std::uint64_t window_start, const std::uint64_t* timestamps,
+                    const double* power, std::size_t count, std::uint64_t end,
+                    std::uint64_t ticks_per_second);
+
+    const PowerTable* table;
+    std::uint64_t window_seconds;
+
+    ResidualTotals totals;
+    std::vector<ResidualTotals> state_totals;
+    std::vector<ResidualWindow> window_totals;
+    std::uint64_t missing = 0;
+};
+
+// Streams the power and state columns of a CSV or binary trace through
+// `analyzer`. Throws std::runtime_error if either column is missing.
+void analyzeTraceResiduals(const std::string& path, ResidualAnalyzer& analyzer);
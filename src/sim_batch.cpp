@@ -0,0 +1,363 @@
+/**
+ * sim_batch.cpp
+ *
+ * Runs many full SystemC simulations in parallel, one process each, and
+ * aggregates their results:
+ *
+ *   sim_batch --manifest <jobs.txt> [--simulator <testbench>] [--jobs N]
+ *             [--output-dir <dir>] [--summary <summary.csv>]
+ *
+ * The SystemC kernel is a process-wide singleton, so parallelism comes from
+ * forking one simulator process per job. Every manifest line holds the
+ * simulator arguments of one job (blank lines and '#' comments are
+ * skipped); a leading "name:" token names the job. Each job writes its
+ * validation report (<name>.csv, or <name>.jsonl with --output-format
+ * jsonl) and console log to its own files under the output directory, and
+ * the summary collects energy, errors and wall time per job.
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "thread_pool.h"
+#include "validation.h"
+
+namespace {
+
+struct Job {
+    std::string name;
+    std::vector<std::string> args;
+
+    std::string output_path;
+    std::string log_path;
+
+    pid_t pid = -1;
+    std::chrono::steady_clock::time_point start;
+    double runtime = 0.0;
+    int exit_code = -1;
+    std::string status = "pending";
+    ValidationSummary summary;
+};
+
+// Splits a manifest line on whitespace; double quotes group words.
+std::vector<std::string> tokenize(const std::string& line) {
+    std::vector<std::string> tokens;
+    std::string current;
+    bool in_token = false;
+    bool quoted = false;
+    for (char c : line) {
+        if (c == '"') {
+            quoted = !quoted;
+            in_token = true;
+        } else if (!quoted && (c == ' ' || c == '\t' || c == '\r')) {
+            if (in_token) {
+                tokens.push_back(current);
+                current.clear();
+                in_token = false;
+            }
+        } else {
+            current += c;
+            in_token = true;
+        }
+    }
+    if (quoted) {
+        throw std::runtime_error("unterminated quote");
+    }
+    if (in_token) {
+        tokens.push_back(current);
+    }
+    return tokens;
+}
+
+std::vector<Job> readManifest(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open manifest " + path);
+    }
+
+    std::vector<Job> jobs;
+    std::map<std::string, int> names;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        const std::size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+
+        Job job;
+        try {
+            job.args = tokenize(line);
+        } catch (const std::exception& e) {
+            throw std::runtime_error(path + ":" + std::to_string(line_number) + ": " + e.what());
+        }
+        if (!job.args.empty() && job.args[0].size() > 1 && job.args[0].back() == ':') {
+            job.name = job.args[0].substr(0, job.args[0].size() - 1);
+            job.args.erase(job.args.begin());
+        } else {
+            std::ostringstream name;
+            name << "job_" << std::setw(4) << std::setfill('0') << jobs.size();
+            job.name = name.str();
+        }
+        if (job.name.find('/') != std::string::npos || names.count(job.name)) {
+            throw std::runtime_error(path + ":" + std::to_string(line_number) +
+                                     ": invalid or duplicate job name '" + job.name + "'");
+        }
+        for (const std::string& arg : job.args) {
+            if (arg == "--output") {
+                throw std::runtime_error(path + ":" + std::to_string(line_number) +
+                                         ": --output is assigned by the batch runner");
+            }
+        }
+        names[job.name] = line_number;
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+// Extension of the report a job writes: .jsonl with --output-format jsonl
+// (the last one wins, as in the simulator), else .csv. Throws
+// std::runtime_error for unknown formats.
+std::string reportExtension(const Job& job) {
+    ReportFormat format = ReportFormat::Csv;
+    for (std::size_t i = 0; i + 1 < job.args.size(); i++) {
+        if (job.args[i] == "--output-format") {
+            format = parseReportFormat(job.args[i + 1]);
+        }
+    }
+    return format == ReportFormat::JsonLines ? ".jsonl" : ".csv";
+}
+
+// Resolves the simulator next to this executable when not given.
+std::string defaultSimulator(const char* argv0) {
+    std::string self = argv0;
+    const std::size_t slash = self.rfind('/');
+    const std::string dir = (slash == std::string::npos) ? "." : self.substr(0, slash);
+    return dir + "/testbench_dvconchallenge";
+}
+
+pid_t spawn(const std::string& simulator, Job& job) {
+    std::vector<std::string> args;
+    args.push_back(simulator);
+    args.insert(args.end(), job.args.begin(), job.args.end());
+    args.push_back("--output");
+    args.push_back(job.output_path);
+
+    std::vector<char*> argv;
+    for (std::string& arg : args) {
+        argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+
+    // A stale result from an earlier batch must not pass for this run's.
+    unlink(job.output_path.c_str());
+
+    const pid_t pid = fork();
+    if (pid < 0) {
+        throw std::runtime_error(std::string("fork failed: ") + std::strerror(errno));
+    }
+    if (pid == 0) {
+        // Child: send stdout and stderr to the job log, then become the
+        // simulator. Only async-signal-safe calls from here on.
+        const int log = open(job.log_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (log >= 0) {
+            dup2(log, STDOUT_FILENO);
+            dup2(log, STDERR_FILENO);
+            close(log);
+        }
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    return pid;
+}
+
+void finish(Job& job, int wait_status) {
+    job.runtime = std::chrono::duration<double>(std::chrono::steady_clock::now() - job.start).count();
+    if (WIFEXITED(wait_status)) {
+        job.exit_code = WEXITSTATUS(wait_status);
+        job.status = (job.exit_code == 0) ? "ok" : "failed";
+    } else if (WIFSIGNALED(wait_status)) {
+        job.exit_code = 128 + WTERMSIG(wait_status);
+        job.status = "killed";
+    }
+    if (job.exit_code == 127) {
+        job.status = "exec-failed";
+    }
+
+    if (job.status == "ok") {
+        try {
+            job.summary = readValidationSummary(job.output_path);
+        } catch (const std::exception&) {
+            job.status = "no-results";
+        }
+    }
+}
+
+void writeSummary(const std::string& path, const std::vector<Job>& jobs) {
+    std::size_t state_count = 0;
+    for (const Job& job : jobs) {
+        if (job.summary.state_energy_error.size() > state_count) {
+            state_count = job.summary.state_energy_error.size();
+        }
+    }
+
+    std::ofstream csv_file(path);
+    if (!csv_file.is_open()) {
+        throw std::runtime_error("Could not create summary " + path);
+    }
+    csv_file << std::fixed << std::setprecision(6);
+    csv_file << "Job,Status,Exit_Code,Runtime_s,Total_Energy_J,Energy_Error_Percent,State_Energy_Error_J";
+    for (std::size_t i = 0; i < state_count; i++) {
+        csv_file << ",State_" << i << "_Error_J";
+    }
+    csv_file << ",Output\n";
+
+    for (const Job& job : jobs) {
+        const bool have_results = (job.status == "ok");
+        csv_file << job.name << "," << job.status << "," << job.exit_code << "," << job.runtime << ",";
+        if (have_results) {
+            csv_file << job.summary.total_energy << "," << job.summary.energy_error_percent << ","
+                     << job.summary.state_energy_error_sum;
+        } else {
+            csv_file << ",,";
+        }
+        for (std::size_t i = 0; i < state_count; i++) {
+            csv_file << ",";
+            if (have_results && i < job.summary.state_energy_error.size()) {
+                csv_file << job.summary.state_energy_error[i];
+            }
+        }
+        csv_file << "," << job.output_path << "\n";
+    }
+    if (!csv_file) {
+        throw std::runtime_error("Could not write summary " + path);
+    }
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " --manifest <jobs.txt> [--simulator <testbench>] [--jobs N]"
+              << " [--output-dir <dir>] [--summary <summary.csv>]" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string manifest_path;
+    std::string simulator = defaultSimulator(argv[0]);
+    std::string output_dir = "batch_results";
+    std::string summary_path;
+    unsigned workers = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--manifest" && i + 1 < argc) {
+            manifest_path = argv[++i];
+        } else if (arg == "--simulator" && i + 1 < argc) {
+            simulator = argv[++i];
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            workers = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--output-dir" && i + 1 < argc) {
+            output_dir = argv[++i];
+        } else if (arg == "--summary" && i + 1 < argc) {
+            summary_path = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (manifest_path.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (workers == 0) {
+        workers = defaultWorkerCount();
+    }
+    if (summary_path.empty()) {
+        summary_path = output_dir + "/summary.csv";
+    }
+
+    std::vector<Job> jobs;
+    try {
+        jobs = readManifest(manifest_path);
+        if (access(simulator.c_str(), X_OK) != 0) {
+            throw std::runtime_error("simulator " + simulator + " is not executable");
+        }
+        if (mkdir(output_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+            throw std::runtime_error("Could not create " + output_dir + ": " + std::strerror(errno));
+        }
+        for (Job& job : jobs) {
+            job.output_path = output_dir + "/" + job.name + reportExtension(job);
+            job.log_path = output_dir + "/" + job.name + ".log";
+        }
+
+        const auto batch_start = std::chrono::steady_clock::now();
+        std::map<pid_t, std::size_t> running;
+        std::size_t next_job = 0;
+        std::size_t done = 0;
+        while (done < jobs.size()) {
+            while (running.size() < workers && next_job < jobs.size()) {
+                Job& job = jobs[next_job];
+                job.start = std::chrono::steady_clock::now();
+                job.pid = spawn(simulator, job);
+                job.status = "running";
+                running[job.pid] = next_job++;
+            }
+
+            int wait_status = 0;
+            const pid_t pid = waitpid(-1, &wait_status, 0);
+            if (pid < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error(std::string("waitpid failed: ") + std::strerror(errno));
+            }
+            auto it = running.find(pid);
+            if (it == running.end()) {
+                continue;
+            }
+            Job& job = jobs[it->second];
+            running.erase(it);
+            finish(job, wait_status);
+            done++;
+            std::cout << "[" << done << "/" << jobs.size() << "] " << job.name << ": " << job.status
+                      << " (" << std::fixed << std::setprecision(3) << job.runtime << " s)"
+                      << std::defaultfloat << std::endl;
+        }
+        const double elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - batch_start).count();
+
+        writeSummary(summary_path, jobs);
+
+        std::size_t failed = 0;
+        for (const Job& job : jobs) {
+            if (job.status != "ok") {
+                failed++;
+            }
+        }
+        std::cout << "Batch finished: " << (jobs.size() - failed) << " ok, " << failed << " failed, "
+                  << elapsed << " s on " << workers << " workers" << std::endl;
+        std::cout << "Summary: " << summary_path << std::endl;
+        return failed == 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,54 @@
+/**
+ * temperature_source.h
+ *
+ * Replays a temperature schedule into the simulation: at every step the
+ * power monitor switches to the step's power row. With a trace source the
+ * replay stops when the trace does, so that trailing temperature samples
+ * do not extend the simulation.
+ */
+
+#pragma once
+
+#include <functional>
+#include <systemc>
+
+#include "power_model.h"
+#include "thermal_table.h"
+#include "trace_source.h"
+
+SC_MODULE(TemperatureSource) {
+    SC_HAS_PROCESS(TemperatureSource);
+
+    TemperatureSource(sc_core::sc_module_name name, const ThermalSchedule& schedule,
+                      std::function<void(const double*)> apply, const TraceSource* trace = nullptr)
+        : sc_core::sc_module(name), schedule(schedule), apply(std::move(apply)), trace(trace) {
+        SC_THREAD(replay);
+    }
+
+    void replay() {
+        for (std::size_t i = 0; i < schedule.stepCount(); i++) {
+            const std::uint64_t now = sc_core::sc_time_stamp().value();
+            const std::uint64_t tick = schedule.stepTick(i);
+            if (tick > now) {
+                const sc_core::sc_time delay = sc_core::sc_time::from_value(tick - now);
+                if (trace) {
+                    if (trace->finished) {
+                        return;
+                    }
+                    wait(delay, trace->done);
+                    if (sc_core::sc_time_stamp().value() < tick) {
+                        return;  // the trace ended first
+                    }
+                } else {
+                    wait(delay);
+                }
+            }
+            apply(schedule.stepRow(i));
+        }
+    }
+
+private:
+    const ThermalSchedule& schedule;
+    std::function<void(const double*)> apply;
+    const TraceSource* trace;
+};
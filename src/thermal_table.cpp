@@ -0,0 +1,252 @@
+/**
+ * thermal_table.cpp
+ */
+
+#include "thermal_table.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+
+#include "power_model.h"
+#include "trace_reader.h"
+
+namespace {
+
+// Upper bound on table rows, e.g. 0.1 C steps over 10000 C.
+const std::size_t MAX_BINS = 100000;
+
+std::string trim(const std::string& text) {
+    const std::size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    const std::size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+bool parseField(const std::string& text, double& value) {
+    return parseDecimal(text.data(), text.data() + text.size(), value);
+}
+
+// Linear interpolation over points sorted by temperature, held constant
+// outside their range.
+double interpolate(const std::vector<std::pair<double, double>>& points, double celsius) {
+    if (celsius <= points.front().first) {
+        return points.front().second;
+    }
+    if (celsius >= points.back().first) {
+        return points.back().second;
+    }
+    std::size_t i = 1;
+    while (points[i].first < celsius) {
+        i++;
+    }
+    const std::pair<double, double>& low = points[i - 1];
+    const std::pair<double, double>& high = points[i];
+    const double fraction = (celsius - low.first) / (high.first - low.first);
+    return low.second + fraction * (high.second - low.second);
+}
+
+} // namespace
+
+ThermalPowerTable::ThermalPowerTable(const PowerTable& base, const StatePoints& points, double step)
+    : state_count(base.stateCount()), step(step), inverse_step(1.0 / step) {
+    if (!(step > 0.0)) {
+        throw std::runtime_error("thermal table step must be positive");
+    }
+    if (static_cast<int>(points.size()) > state_count) {
+        throw std::runtime_error("thermal table has more states than the power table (" +
+                                 std::to_string(state_count) + " states)");
+    }
+
+    std::vector<std::vector<std::pair<double, double>>> sorted(points.begin(), points.end());
+    sorted.resize(state_count);
+    bool have_points = false;
+    double max_temperature = 0.0;
+    for (std::vector<std::pair<double, double>>& state_points : sorted) {
+        if (state_points.empty()) {
+            continue;
+        }
+        std::sort(state_points.begin(), state_points.end());
+        for (std::size_t i = 1; i < state_points.size(); i++) {
+            if (state_points[i].first == state_points[i - 1].first) {
+                throw std::runtime_error("thermal table has two points at " +
+                                         std::to_string(state_points[i].first) + " C for one state");
+            }
+        }
+        if (!have_points || state_points.front().first < min_temperature) {
+            min_temperature = state_points.front().first;
+        }
+        if (!have_points || state_points.back().first > max_temperature) {
+            max_temperature = state_points.back().first;
+        }
+        have_points = true;
+    }
+
+    if (have_points) {
+        const double span = std::ceil((max_temperature - min_temperature) * inverse_step - 1e-9);
+        if (span >= static_cast<double>(MAX_BINS)) {
+            throw std::runtime_error("thermal table range is too large for its step");
+        }
+        bins = static_cast<std::size_t>(span) + 1;
+    }
+
+    powers.resize(bins * state_count);
+    for (std::size_t bin = 0; bin < bins; bin++) {
+        const double celsius = min_temperature + static_cast<double>(bin) * step;
+        for (int s = 0; s < state_count; s++) {
+            powers[bin * state_count + s] =
+                sorted[s].empty() ? base.power(s) : interpolate(sorted[s], celsius);
+        }
+    }
+}
+
+ThermalPowerTable ThermalPowerTable::load(const std::string& path, const PowerTable& base, double step) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open thermal table " + path);
+    }
+
+    StatePoints points(base.stateCount());
+    std::string line;
+    int line_number = 0;
+    bool seen_row = false;
+    bool any_point = false;
+    while (std::getline(file, line)) {
+        line_number++;
+        const std::string where = path + ":" + std::to_string(line_number);
+
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        const std::size_t first = line.find(',');
+        const std::size_t second = first == std::string::npos ? first : line.find(',', first + 1);
+        if (second == std::string::npos || line.find(',', second + 1) != std::string::npos) {
+            throw std::runtime_error(where + ": expected State,Temperature_C,Power_W");
+        }
+
+        const std::string state_text = trim(line.substr(0, first));
+        char* end = nullptr;
+        const long state = std::strtol(state_text.c_str(), &end, 10);
+        const bool numeric_state = !state_text.empty() && *end == '\0';
+        if (!numeric_state && !seen_row) {
+            seen_row = true;  // header line
+            continue;
+        }
+        seen_row = true;
+        if (!numeric_state || !base.contains(static_cast<int>(state))) {
+            throw std::runtime_error(where + ": state " + state_text + " is not in the power table (" +
+                                     std::to_string(base.stateCount()) + " states)");
+        }
+
+        double celsius = 0.0;
+        double power = 0.0;
+        if (!parseField(trim(line.substr(first + 1, second - first - 1)), celsius)) {
+            throw std::runtime_error(where + ": invalid temperature");
+        }
+        if (!parseField(trim(line.substr(second + 1)), power) || power < 0.0) {
+            throw std::runtime_error(where + ": invalid power value");
+        }
+        points[state].emplace_back(celsius, power);
+        any_point = true;
+    }
+
+    if (!any_point) {
+        throw std::runtime_error("Thermal table " + path + " defines no points");
+    }
+    return ThermalPowerTable(base, points, step);
+}
+
+std::vector<TemperatureStep> loadTemperatureTrace(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open temperature trace " + path);
+    }
+
+    std::vector<TemperatureStep> steps;
+    std::uint64_t first_time = 0;
+    std::string line;
+    int line_number = 0;
+    bool seen_row = false;
+    while (std::getline(file, line)) {
+        line_number++;
+        const std::string where = path + ":" + std::to_string(line_number);
+
+        // Strip a UTF-8 byte order mark, as written by spreadsheet exports.
+        if (line_number == 1 && line.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+            line.erase(0, 3);
+        }
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        const char separator = line.find(';') != std::string::npos ? ';' : ',';
+        const std::size_t split = line.find(separator);
+        if (split == std::string::npos) {
+            throw std::runtime_error(where + ": expected time" + separator + "temperature");
+        }
+        const std::string time_text = trim(line.substr(0, split));
+        std::string temperature_text = trim(line.substr(split + 1));
+        temperature_text = temperature_text.substr(0, temperature_text.find(separator));
+
+        std::uint64_t time = 0;
+        double seconds = 0.0;
+        std::uint64_t resolution = 0;
+        bool have_time = parseTimingTicks(time_text.data(), time_text.data() + time_text.size(),
+                                          ticksPerSecond(), time, resolution);
+        if (!have_time && resolution == 0 && parseField(time_text, seconds) && seconds >= 0.0) {
+            time = secondsToTicks(seconds);
+            have_time = true;
+        }
+        double celsius = 0.0;
+        const bool have_temperature = parseField(trim(temperature_text), celsius);
+        if (!have_time || !have_temperature) {
+            if (!seen_row) {
+                seen_row = true;  // header line
+                continue;
+            }
+            throw std::runtime_error(where + ": invalid " + (have_time ? "temperature" : "time"));
+        }
+        seen_row = true;
+
+        if (steps.empty()) {
+            first_time = time;
+        }
+        if (time < first_time || (!steps.empty() && time - first_time < steps.back().tick)) {
+            throw std::runtime_error(where + ": time goes backwards");
+        }
+        TemperatureStep step;
+        step.tick = time - first_time;
+        step.celsius = celsius;
+        steps.push_back(step);
+    }
+
+    if (steps.empty()) {
+        throw std::runtime_error("Temperature trace " + path + " has no samples");
+    }
+    return steps;
+}
+
+ThermalSchedule::ThermalSchedule(const ThermalPowerTable& table, double initial_celsius,
+                                 const std::vector<TemperatureStep>& steps)
+    : initial_row(table.row(initial_celsius)) {
+    step_ticks.reserve(steps.size());
+    step_rows.reserve(steps.size());
+    const double* current = initial_row;
+    for (const TemperatureStep& step : steps) {
+        // Samples that round to the current row change nothing.
+        const double* next_row = table.row(step.celsius);
+        if (next_row == current) {
+            continue;
+        }
+        step_ticks.push_back(step.tick);
+        step_rows.push_back(next_row);
+        current = next_row;
+    }
+}
@@ -0,0 +1,93 @@
+/**
+ * thermal_table.h
+ *
+ * Temperature-dependent state power. Per-state characterization points are
+ * interpolated once, at load time, into a dense table with one row of
+ * state powers per temperature step. A lookup is then a bin index and an
+ * array read, and monitors only switch rows when the temperature changes,
+ * so the per-transition cost is the same as with a plain PowerTable.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "power_table.h"
+
+class ThermalPowerTable {
+public:
+    static constexpr double DEFAULT_STEP = 0.1;  // degrees C per row
+
+    // Characterization points per state as (temperature C, power W).
+    // States without points keep the base table's power at every
+    // temperature. Between points power is interpolated linearly; outside
+    // the characterized range it is held at the nearest point.
+    typedef std::vector<std::vector<std::pair<double, double>>> StatePoints;
+
+    ThermalPowerTable(const PowerTable& base, const StatePoints& points,
+                      double step = DEFAULT_STEP);
+
+    // Loads a "State,Temperature_C,Power_W" CSV file with any number of
+    // rows per state. Blank lines, '#' comments and a header line are
+    // skipped. Throws std::runtime_error on malformed files or states that
+    // are not in `base`.
+    static ThermalPowerTable load(const std::string& path, const PowerTable& base,
+                                  double step = DEFAULT_STEP);
+
+    int stateCount() const { return state_count; }
+    double minTemperature() const { return min_temperature; }
+    double maxTemperature() const { return min_temperature + (bins - 1) * step; }
+
+    // Powers of all states at `celsius`, rounded to the nearest row.
+    const double* row(double celsius) const {
+        double offset = (celsius - min_temperature) * inverse_step + 0.5;
+        offset = offset < 0.0 ? 0.0 : offset;
+        std::size_t bin = static_cast<std::size_t>(offset);
+        bin = bin < bins ? bin : bins - 1;
+        return &powers[bin * state_count];
+    }
+
+    double power(int state, double celsius) const { return row(celsius)[state]; }
+
+private:
+    int state_count;
+    double min_temperature = 0.0;
+    double step;
+    double inverse_step;
+    std::size_t bins = 1;
+    std::vector<double> powers;  // bin * state_count + state
+};
+
+// A temperature change `tick` ticks into the trace.
+struct TemperatureStep {
+    std::uint64_t tick = 0;
+    double celsius = 0.0;
+};
+
+// Reads a temperature trace of "time,temperature" rows. Times are HH:MM:SS
+// timings or seconds and, as with state traces, relative to the first row.
+// Fields are separated by ';' (with ',' decimals) or ','. A header line is
+// skipped. Times must not decrease. Throws std::runtime_error on
+// malformed files.
+std::vector<TemperatureStep> loadTemperatureTrace(const std::string& path);
+
+// Temperature over a run as power rows: the row for `initial_celsius` and
+// one row per step, resolved once up front.
+class ThermalSchedule {
+public:
+    ThermalSchedule(const ThermalPowerTable& table, double initial_celsius,
+                    const std::vector<TemperatureStep>& steps = std::vector<TemperatureStep>());
+
+    const double* initialRow() const { return initial_row; }
+    std::size_t stepCount() const { return step_ticks.size(); }
+    std::uint64_t stepTick(std::size_t i) const { return step_ticks[i]; }
+    const double* stepRow(std::size_t i) const { return step_rows[i]; }
+
+private:
+    const double* initial_row;
+    std::vector<std::uint64_t> step_ticks;
+    std::vector<const double*> step_rows;
+};
@@ -0,0 +1,117 @@
+/**
+ * thread_pool.cpp
+ */
+
+#include "thread_pool.h"
+
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct WorkQueue {
+    std::mutex mutex;
+    std::deque<std::size_t> jobs;
+
+    bool popFront(std::size_t& index) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.empty()) {
+            return false;
+        }
+        index = jobs.front();
+        jobs.pop_front();
+        return true;
+    }
+
+    bool stealBack(std::size_t& index) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.empty()) {
+            return false;
+        }
+        index = jobs.back();
+        jobs.pop_back();
+        return true;
+    }
+};
+
+} // namespace
+
+unsigned defaultWorkerCount() {
+    const unsigned cores = std::thread::hardware_concurrency();
+    return cores > 0 ? cores : 1;
+}
+
+void parallelFor(std::size_t count, unsigned workers,
+                 const std::function<void(std::size_t index, unsigned worker)>& job) {
+    if (count == 0) {
+        return;
+    }
+    if (workers == 0) {
+        workers = defaultWorkerCount();
+    }
+    if (workers > count) {
+        workers = static_cast<unsigned>(count);
+    }
+
+    if (workers == 1) {
+        for (std::size_t i = 0; i < count; i++) {
+            job(i, 0);
+        }
+        return;
+    }
+
+    // Contiguous blocks per worker keep neighbouring jobs (usually the same
+    // trace) on one core; stealing evens out the rest.
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    for (unsigned w = 0; w < workers; w++) {
+        queues.emplace_back(new WorkQueue());
+    }
+    for (std::size_t i = 0; i < count; i++) {
+        queues[i * workers / count]->jobs.push_back(i);
+    }
+
+    std::atomic<bool> failed(false);
+    std::exception_ptr first_error;
+    std::mutex error_mutex;
+
+    auto work = [&](unsigned self) {
+        std::size_t index = 0;
+        while (!failed.load(std::memory_order_relaxed)) {
+            bool found = queues[self]->popFront(index);
+            for (unsigned k = 1; !found && k < workers; k++) {
+                found = queues[(self + k) % workers]->stealBack(index);
+            }
+            if (!found) {
+                // Jobs are never added once started, so empty means done.
+                return;
+            }
+            try {
+                job(index, self);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!first_error) {
+                    first_error = std::current_exception();
+                }
+                failed.store(true, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned w = 1; w < workers; w++) {
+        threads.emplace_back(work, w);
+    }
+    work(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    if (first_error) {
+        std::rethrow_exception(first_error);
+    }
+}
@@ -0,0 +1,25 @@
+/**
+ * thread_pool.h
+ *
+ * Work-stealing parallel loop for independent jobs such as parameter-sweep
+ * candidates. Every worker owns a deque of job indices; it takes work from
+ * the front of its own deque and, once that is empty, steals from the back
+ * of another worker's, so uneven job costs (long and short traces) still
+ * keep all cores busy.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+// Number of workers to use when the caller asks for 0.
+unsigned defaultWorkerCount();
+
+// Runs job(index, worker) for every index in [0, count) on `workers`
+// threads (0 = defaultWorkerCount()) and returns when all jobs are done.
+// `worker` is in [0, workers) and lets jobs use per-worker scratch state.
+// If a job throws, remaining jobs are skipped and the first exception is
+// rethrown on the calling thread.
+void parallelFor(std::size_t count, unsigned workers,
+                 const std::function<void(std::size_t index, unsigned worker)>& job);
@@ -0,0 +1,262 @@
+/**
+ * timeseries.cpp
+ */
+
+#include "timeseries.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include "power_model.h"
+
+namespace {
+
+// Appends `value` with six decimals, like "%.6f". Values in the usual range
+// are formatted from a scaled integer, which is several times faster than
+// snprintf; the writer has to keep up with millions of rows at 1 s windows.
+void appendFixed(std::string& out, double value) {
+    if (!(std::fabs(value) < 9e12)) {
+        char field[64];
+        const int length = std::snprintf(field, sizeof(field), "%.6f", value);
+        out.append(field, static_cast<std::size_t>(length));
+        return;
+    }
+    const bool negative = std::signbit(value);
+    const std::uint64_t scaled = static_cast<std::uint64_t>(std::llround(std::fabs(value) * 1e6));
+    char digits[32];
+    int n = 0;
+    std::uint64_t whole = scaled / 1000000;
+    std::uint64_t fraction = scaled % 1000000;
+    for (int i = 0; i < 6; i++) {
+        digits[n++] = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+    digits[n++] = '.';
+    do {
+        digits[n++] = static_cast<char>('0' + whole % 10);
+        whole /= 10;
+    } while (whole > 0);
+    if (negative) {
+        digits[n++] = '-';
+    }
+    while (n > 0) {
+        out += digits[--n];
+    }
+}
+
+} // namespace
+
+std::vector<std::uint64_t> parseWindowList(const std::string& text) {
+    std::vector<std::uint64_t> windows;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        std::size_t used = 0;
+        double seconds = 0.0;
+        try {
+            seconds = std::stod(item, &used);
+        } catch (const std::exception&) {
+            used = 0;
+        }
+        const std::uint64_t ticks = secondsToTicks(seconds);
+        if (used != item.size() || ticks == 0) {
+            throw std::runtime_error("invalid window length '" + item + "' in '" + text + "'");
+        }
+        windows.push_back(ticks);
+    }
+    if (windows.empty()) {
+        throw std::runtime_error("empty window list");
+    }
+    return windows;
+}
+
+TimeSeriesWriter::TimeSeriesWriter(const std::string& path, int state_count,
+                                   const std::vector<std::uint64_t>& window_ticks,
+                                   std::size_t capacity)
+    : file_path(path), file(path), state_count(state_count),
+      ring(capacity > 0 ? capacity : DEFAULT_CAPACITY), cumulative(window_ticks.size()) {
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not create time series " + path);
+    }
+    if (window_ticks.empty()) {
+        throw std::runtime_error("time series needs at least one window length");
+    }
+
+    for (std::size_t i = 0; i < window_ticks.size(); i++) {
+        Bucket bucket;
+        bucket.series = i;
+        bucket.window = window_ticks[i];
+        bucket.state_ticks.assign(state_count, 0);
+        bucket.state_energy.assign(state_count, 0.0);
+        open_buckets.push_back(bucket);
+    }
+    // Pre-size the ring slots so that handing over a bucket never allocates.
+    for (Bucket& slot : ring) {
+        slot.state_ticks.assign(state_count, 0);
+        slot.state_energy.assign(state_count, 0.0);
+    }
+
+    file << std::fixed << std::setprecision(6);
+    file << "Window_s,Start_s,Duration_s,Energy_J,Average_Power_W,Cumulative_Energy_J";
+    for (int s = 0; s < state_count; s++) {
+        file << ",State_" << s << "_Energy_J";
+    }
+    for (int s = 0; s < state_count; s++) {
+        file << ",State_" << s << "_Duration_s";
+    }
+    for (int s = 0; s < state_count; s++) {
+        file << ",State_" << s << "_Avg_W";
+    }
+    file << ",Transition_Energy_J\n";
+
+    writer = std::thread(&TimeSeriesWriter::writeLoop, this);
+}
+
+TimeSeriesWriter::~TimeSeriesWriter() {
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+void TimeSeriesWriter::add(int state, std::uint64_t ticks, double energy) {
+    for (Bucket& open : open_buckets) {
+        std::uint64_t remaining = ticks;
+        double energy_left = energy;
+        while (remaining > 0) {
+            const std::uint64_t take = std::min(remaining, open.window - open.duration);
+            // The last piece takes the rest, so the pieces sum to `energy`.
+            const double part = take == remaining
+                                    ? energy_left
+                                    : energy * (static_cast<double>(take) / static_cast<double>(ticks));
+            open.state_ticks[state] += take;
+            open.state_energy[state] += part;
+            open.duration += take;
+            remaining -= take;
+            energy_left -= part;
+            if (open.duration == open.window) {
+                emit(open);
+            }
+        }
+    }
+}
+
+void TimeSeriesWriter::addSwitch(double energy) {
+    for (Bucket& open : open_buckets) {
+        open.transition_energy += energy;
+    }
+}
+
+void TimeSeriesWriter::emit(Bucket& open) {
+    const std::size_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == ring.size()) {
+        stalls++;
+        while (h - tail.load(std::memory_order_acquire) == ring.size()) {
+            std::this_thread::yield();
+        }
+    }
+
+    Bucket& slot = ring[h % ring.size()];
+    slot.series = open.series;
+    slot.window = open.window;
+    slot.start = open.start;
+    slot.duration = open.duration;
+    std::copy(open.state_ticks.begin(), open.state_ticks.end(), slot.state_ticks.begin());
+    std::copy(open.state_energy.begin(), open.state_energy.end(), slot.state_energy.begin());
+    slot.transition_energy = open.transition_energy;
+    head.store(h + 1, std::memory_order_release);
+
+    open.start += open.duration;
+    open.duration = 0;
+    std::fill(open.state_ticks.begin(), open.state_ticks.end(), 0);
+    std::fill(open.state_energy.begin(), open.state_energy.end(), 0.0);
+    open.transition_energy = 0.0;
+}
+
+void TimeSeriesWriter::close() {
+    if (closed) {
+        return;
+    }
+    closed = true;
+    for (Bucket& open : open_buckets) {
+        if (open.duration > 0) {
+            emit(open);
+        }
+    }
+    closing.store(true, std::memory_order_release);
+    writer.join();
+
+    file.flush();
+    if (failed.load() || !file) {
+        throw std::runtime_error("Could not write time series " + file_path);
+    }
+}
+
+void TimeSeriesWriter::writeLoop() {
+    while (true) {
+        const std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            if (closing.load(std::memory_order_acquire)) {
+                if (t == head.load(std::memory_order_acquire)) {
+                    return;
+                }
+                continue;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        // After a write error keep draining so the producer never blocks.
+        if (!failed.load(std::memory_order_relaxed)) {
+            writeBucket(ring[t % ring.size()]);
+            if (!file) {
+                failed.store(true);
+            }
+        }
+        tail.store(t + 1, std::memory_order_release);
+    }
+}
+
+void TimeSeriesWriter::writeBucket(const Bucket& bucket) {
+    const double duration = ticksToSeconds(bucket.duration);
+    CompensatedSum total;
+    for (int s = 0; s < state_count; s++) {
+        total.add(bucket.state_energy[s]);
+    }
+    total.add(bucket.transition_energy);
+    cumulative[bucket.series].add(total.value());
+
+    line.clear();
+    appendFixed(line, ticksToSeconds(bucket.window));
+    for (double value : {ticksToSeconds(bucket.start), duration, total.value(),
+                         total.value() / duration, cumulative[bucket.series].value()}) {
+        line += ',';
+        appendFixed(line, value);
+    }
+    for (int s = 0; s < state_count; s++) {
+        line += ',';
+        appendFixed(line, bucket.state_energy[s]);
+    }
+    for (int s = 0; s < state_count; s++) {
+        line += ',';
+        appendFixed(line, ticksToSeconds(bucket.state_ticks[s]));
+    }
+    // Average power while in the state; nan if it was not active.
+    for (int s = 0; s < state_count; s++) {
+        line += ',';
+        appendFixed(line, bucket.state_ticks[s] > 0
+                              ? bucket.state_energy[s] / ticksToSeconds(bucket.state_ticks[s])
+                              : std::numeric_limits<double>::quiet_NaN());
+    }
+    line += ',';
+    appendFixed(line, bucket.transition_energy);
+    line += '\n';
+    file.write(line.data(), static_cast<std::streamsize>(line.size()));
+    buckets_written++;
+}
@@ -0,0 +1,103 @@
+/**
+ * timeseries.h
+ *
+ * Windowed energy output for dashboards: fixed-length buckets (e.g. 1 s,
+ * 60 s and 1 h) with the time and energy spent in every state. The
+ * simulation thread adds the ticks and energy it charged to the open
+ * buckets; completed buckets go through a bounded single-producer/
+ * single-consumer ring to a writer thread that does the formatting and
+ * file I/O. The writer only sums what it receives, so the series adds up
+ * to the replay's total whatever powers the accumulator used.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "compensated_sum.h"
+
+// Parses a comma-separated list of window lengths in seconds, e.g.
+// "1,60,3600", into ticks; throws std::runtime_error for empty or invalid
+// lists.
+std::vector<std::uint64_t> parseWindowList(const std::string& text);
+
+class TimeSeriesWriter {
+public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 4096;  // buckets
+
+    // Writes buckets of every length in `window_ticks` to `path` as CSV,
+    // with one column per state id below `state_count`. Throws
+    // std::runtime_error if the file cannot be created.
+    TimeSeriesWriter(const std::string& path, int state_count,
+                     const std::vector<std::uint64_t>& window_ticks,
+                     std::size_t capacity = DEFAULT_CAPACITY);
+    ~TimeSeriesWriter();
+
+    TimeSeriesWriter(const TimeSeriesWriter&) = delete;
+    TimeSeriesWriter& operator=(const TimeSeriesWriter&) = delete;
+
+    // Appends `ticks` ticks spent in `state` and the `energy` charged for
+    // them, directly after the previous interval. An interval crossing a
+    // bucket boundary is split in proportion to its ticks. Called by
+    // EnergyAccumulator::charge().
+    void add(int state, std::uint64_t ticks, double energy);
+
+    // Adds the switching energy of a transition at the current tick to the
+    // buckets that contain it. Called by EnergyAccumulator::enter().
+    void addSwitch(double energy);
+
+    // Emits the partially filled last buckets, waits for the writer thread
+    // and closes the file. Throws std::runtime_error if writing failed.
+    void close();
+
+    const std::string& path() const { return file_path; }
+    std::uint64_t bucketCount() const { return buckets_written; }
+
+    // Times the simulation thread found the ring full and had to wait.
+    std::uint64_t stallCount() const { return stalls; }
+
+private:
+    struct Bucket {
+        std::size_t series = 0;           // index into the window list
+        std::uint64_t window = 0;         // ticks
+        std::uint64_t start = 0;          // tick
+        std::uint64_t duration = 0;       // ticks
+        std::vector<std::uint64_t> state_ticks;  // time in each state
+        std::vector<double> state_energy;  // J
+        double transition_energy = 0.0;    // J, switching energy
+    };
+
+    void emit(Bucket& open);
+    void writeLoop();
+    void writeBucket(const Bucket& bucket);
+
+    std::string file_path;
+    std::ofstream file;
+    int state_count;
+
+    // One open bucket per window length, owned by the simulation thread.
+    std::vector<Bucket> open_buckets;
+
+    // Ring of completed buckets; `head` is written by the producer and
+    // `tail` by the writer thread.
+    std::vector<Bucket> ring;
+    std::atomic<std::size_t> head{0};
+    std::atomic<std::size_t> tail{0};
+    std::atomic<bool> closing{false};
+    std::atomic<bool> failed{false};
+    std::thread writer;
+
+    // Writer thread only: running energy per window length and scratch
+    // text of the bucket being written.
+    std::vector<CompensatedSum> cumulative;
+    std::string line;
+
+    std::uint64_t buckets_written = 0;
+    std::uint64_t stalls = 0;
+    bool closed = false;
+};
@@ -0,0 +1,97 @@
+/**
+ * tlm_power_observer.h
+ *
+ * Power observer for loosely-timed TLM-2.0 platforms. Initiators running
+ * ahead of kernel time report state changes with their local time offset,
+ * as kept by tlm_utils::tlm_quantumkeeper, instead of writing a signal and
+ * forcing a sync per change. Energy is integrated lazily: pending changes
+ * are folded in once kernel time has crossed a global quantum boundary, or
+ * when the energy is queried.
+ */
+
+#pragma once
+
+#include <systemc>
+#include <tlm>
+#include <tlm_utils/tlm_quantumkeeper.h>
+
+#include "decoupled_accumulator.h"
+#include "event_log.h"
+#include "trace_reader.h"
+
+class TlmPowerObserver {
+public:
+    explicit TlmPowerObserver(const PowerTable& table = PowerTable::builtin(),
+                              TransitionLog* log = nullptr)
+        : lazy(table, log) {}
+
+    // Reports a change to `status` at sc_time_stamp() + local_offset.
+    void notifyState(int status, const sc_core::sc_time& local_offset = sc_core::SC_ZERO_TIME) {
+        const std::uint64_t now = sc_core::sc_time_stamp().value();
+        if (now >= next_sync_tick) {
+            // Every process's local time is at or after kernel time, so
+            // nothing before `now` can still change.
+            lazy.syncTo(now);
+            const std::uint64_t quantum = tlm::tlm_global_quantum::instance().get().value();
+            next_sync_tick = quantum > 0 ? (now / quantum + 1) * quantum : now + 1;
+        }
+        lazy.change(now + local_offset.value(), status);
+    }
+
+    // Energy up to sc_time_stamp() + local_offset. This syncs the observer
+    // to that time: later changes must not be reported before it.
+    double energy(const sc_core::sc_time& local_offset = sc_core::SC_ZERO_TIME) {
+        return lazy.energyAt(sc_core::sc_time_stamp().value() + local_offset.value());
+    }
+
+    // Integrates all pending changes and charges the final state up to the
+    // current kernel time; call once the simulation has stopped.
+    double finish() {
+        return lazy.finish(sc_core::sc_time_stamp().value());
+    }
+
+    EnergyAccumulator& accumulator() { return lazy.accumulator(); }
+    const EnergyAccumulator& accumulator() const { return lazy.accumulator(); }
+    std::size_t pendingCount() const { return lazy.pendingCount(); }
+
+private:
+    DecoupledAccumulator lazy;
+    std::uint64_t next_sync_tick = 0;
+};
+
+// Replays a trace as a temporally decoupled initiator: each run advances
+// the quantum keeper's local time, and the initiator only yields to the
+// kernel when the quantum is used up.
+SC_MODULE(TlmTraceInitiator) {
+    SC_HAS_PROCESS(TlmTraceInitiator);
+
+    TlmTraceInitiator(sc_core::sc_module_name name, TraceReader& reader, TlmPowerObserver& observer)
+        : sc_core::sc_module(name), reader(reader), observer(observer) {
+        SC_THREAD(replay);
+    }
+
+    void replay() {
+        tlm_utils::tlm_quantumkeeper quantum_keeper;
+        quantum_keeper.reset();
+
+        TraceRun run;
+        std::uint64_t runs = 0;
+        while (reader.next(run)) {
+            observer.notifyState(run.state, quantum_keeper.get_local_time());
+            quantum_keeper.inc(sc_core::sc_time::from_value(run.duration));
+            if (quantum_keeper.need_sync()) {
+                quantum_keeper.sync();
+            }
+            runs++;
+        }
+        quantum_keeper.sync();
+
+        if (logEnabled(Verbosity::Summary)) {
+            std::cout << "Decoupled trace replay complete (" << runs << " runs)" << std::endl;
+        }
+    }
+
+private:
+    TraceReader& reader;
+    TlmPowerObserver& observer;
+};
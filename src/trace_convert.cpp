@@ -0,0 +1,65 @@
+/**
+ * trace_convert.cpp
+ *
+ * Converts measurement CSV files into the binary trace format:
+ *
+ *   trace_convert <input.csv> <output.dvctrace>
+ */
+
+#include <iostream>
+#include <string>
+
+#include "binary_trace.h"
+#include "trace_reader.h"
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input.csv> <output.dvctrace>" << std::endl;
+        return 1;
+    }
+
+    const std::string input = argv[1];
+    const std::string output = argv[2];
+
+    try {
+        // First pass: count samples and discover the sample period, so the
+        // columns can be laid out before writing.
+        std::uint64_t sample_count = 0;
+        std::uint64_t sample_period = 1;
+        std::uint64_t ticks_per_second = 1;
+        std::uint32_t flags = 0;
+        {
+            CsvTraceReader reader(input);
+            TraceSample sample;
+            while (reader.nextSample(sample)) {
+                sample_count++;
+            }
+            sample_period = reader.samplePeriod();
+            ticks_per_second = reader.ticksPerSecond();
+            if (reader.hasPower()) {
+                flags |= BINARY_TRACE_HAS_POWER;
+            }
+            if (reader.hasStatus()) {
+                flags |= BINARY_TRACE_HAS_STATES;
+            }
+        }
+
+        CsvTraceReader reader(input);
+        BinaryTraceWriter writer(output, sample_count, sample_period, flags, ticks_per_second);
+        TraceSample sample;
+        while (reader.nextSample(sample)) {
+            writer.append(sample);
+        }
+        writer.close();
+
+        std::cout << "Converted " << sample_count << " samples from " << input
+                  << " to " << output << " ("
+                  << ((flags & BINARY_TRACE_HAS_STATES) ? "states" : "no states") << ", "
+                  << ((flags & BINARY_TRACE_HAS_POWER) ? "power" : "no power") << ")" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,410 @@
+/**
+ * trace_reader.cpp
+ */
+
+#include "trace_reader.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "binary_trace.h"
+
+namespace {
+
+const char* trimLeft(const char* begin, const char* end) {
+    while (begin < end && (*begin == ' ' || *begin == '\t')) {
+        ++begin;
+    }
+    return begin;
+}
+
+const char* trimRight(const char* begin, const char* end) {
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) {
+        --end;
+    }
+    return end;
+}
+
+// Splits a ';'-separated line into at most `max_fields` fields.
+int splitFields(const char* begin, const char* end,
+                const char** field_begin, const char** field_end, int max_fields) {
+    int count = 0;
+    while (count < max_fields) {
+        const char* sep = static_cast<const char*>(std::memchr(begin, ';', end - begin));
+        field_begin[count] = begin;
+        field_end[count] = sep ? sep : end;
+        ++count;
+        if (!sep) {
+            break;
+        }
+        begin = sep + 1;
+    }
+    return count;
+}
+
+const int MAX_FIELDS = 16;
+
+} // namespace
+
+int statusFromString(const std::string& status) {
+    static const char* const names[6] = {
+        "At Work (In the Office)",
+        "Not at Work",
+        "At Work (Not in the office)",
+        "At Work (In the Office) Bluetooth",
+        "At Work (Not in the office) Bluetooth",
+        "Not at Work Bluetooth"
+    };
+
+    const char* begin = trimLeft(status.data(), status.data() + status.size());
+    const char* end = trimRight(begin, status.data() + status.size());
+    const std::size_t length = end - begin;
+
+    for (int i = 0; i < 6; i++) {
+        if (std::strlen(names[i]) == length && std::memcmp(names[i], begin, length) == 0) {
+            return i;
+        }
+    }
+
+    // Device variants with more states log numeric state ids.
+    if (length > 0 && length <= 9) {
+        int state = 0;
+        for (const char* p = begin; p < end; ++p) {
+            if (*p < '0' || *p > '9') {
+                return -1;
+            }
+            state = state * 10 + (*p - '0');
+        }
+        return state;
+    }
+    return -1;
+}
+
+bool parseTimings(const char* begin, const char* end, std::uint64_t& seconds) {
+    begin = trimLeft(begin, end);
+    end = trimRight(begin, end);
+
+    std::uint64_t parts[3] = {0, 0, 0};
+    int part = 0;
+    bool have_digit = false;
+    for (const char* p = begin; p < end; ++p) {
+        if (*p >= '0' && *p <= '9') {
+            parts[part] = parts[part] * 10 + static_cast<std::uint64_t>(*p - '0');
+            have_digit = true;
+        } else if (*p == ':' && have_digit && part < 2) {
+            ++part;
+            have_digit = false;
+        } else {
+            return false;
+        }
+    }
+    if (part != 2 || !have_digit) {
+        return false;
+    }
+
+    seconds = parts[0] * 3600 + parts[1] * 60 + parts[2];
+    return true;
+}
+
+bool parseTimingTicks(const char* begin, const char* end, std::uint64_t ticks_per_second,
+                      std::uint64_t& ticks, std::uint64_t& resolution) {
+    begin = trimLeft(begin, end);
+    end = trimRight(begin, end);
+    const char* dot = static_cast<const char*>(std::memchr(begin, '.', end - begin));
+
+    std::uint64_t seconds = 0;
+    if (!parseTimings(begin, dot ? dot : end, seconds)) {
+        return false;
+    }
+    std::uint64_t fraction = 0;
+    std::uint64_t scale = 1;
+    if (dot) {
+        if (dot + 1 == end || end - (dot + 1) > 9) {
+            return false;
+        }
+        for (const char* p = dot + 1; p < end; ++p) {
+            if (*p < '0' || *p > '9') {
+                return false;
+            }
+            fraction = fraction * 10 + static_cast<std::uint64_t>(*p - '0');
+            scale *= 10;
+        }
+    }
+    resolution = scale;
+
+    // fraction < 10^9 and ticks_per_second <= 10^9, so this cannot overflow.
+    const std::uint64_t scaled = fraction * ticks_per_second;
+    if (scaled % scale != 0) {
+        return false;
+    }
+    ticks = seconds * ticks_per_second + scaled / scale;
+    return true;
+}
+
+bool parseDecimal(const char* begin, const char* end, double& value) {
+    begin = trimLeft(begin, end);
+    end = trimRight(begin, end);
+
+    char text[64];
+    const std::size_t length = end - begin;
+    if (length == 0 || length >= sizeof(text)) {
+        return false;
+    }
+    for (std::size_t i = 0; i < length; i++) {
+        text[i] = begin[i] == ',' ? '.' : begin[i];
+    }
+    text[length] = '\0';
+
+    char* parsed_end = nullptr;
+    value = std::strtod(text, &parsed_end);
+    return parsed_end == text + length;
+}
+
+CsvTraceReader::CsvTraceReader(const std::string& path, std::size_t chunk_size)
+    : path(path), file(path, std::ios::binary), buffer(chunk_size > 0 ? chunk_size : DEFAULT_CHUNK_SIZE) {
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open trace file " + path);
+    }
+}
+
+bool CsvTraceReader::nextLine(const char*& begin, const char*& end) {
+    while (true) {
+        const char* data = buffer.data();
+        const char* newline = static_cast<const char*>(
+            std::memchr(data + buffer_begin, '\n', buffer_end - buffer_begin));
+
+        if (newline) {
+            begin = data + buffer_begin;
+            end = newline;
+            buffer_begin = (newline - data) + 1;
+            ++line_number;
+            return true;
+        }
+
+        if (eof) {
+            if (buffer_begin == buffer_end) {
+                return false;
+            }
+            // Last line without terminator.
+            begin = data + buffer_begin;
+            end = data + buffer_end;
+            buffer_begin = buffer_end;
+            ++line_number;
+            return true;
+        }
+
+        // Move the partial line to the front and refill the rest of the chunk.
+        const std::size_t remaining = buffer_end - buffer_begin;
+        if (remaining > 0 && buffer_begin > 0) {
+            std::memmove(buffer.data(), buffer.data() + buffer_begin, remaining);
+        }
+        buffer_begin = 0;
+        buffer_end = remaining;
+        if (buffer_end == buffer.size()) {
+            // A single line longer than the chunk: grow just enough to hold it.
+            buffer.resize(buffer.size() * 2);
+        }
+
+        file.read(buffer.data() + buffer_end, static_cast<std::streamsize>(buffer.size() - buffer_end));
+        buffer_end += static_cast<std::size_t>(file.gcount());
+        if (file.gcount() == 0 || !file) {
+            eof = true;
+        }
+    }
+}
+
+void CsvTraceReader::parseHeader(const char* begin, const char* end) {
+    const char* field_begin[MAX_FIELDS];
+    const char* field_end[MAX_FIELDS];
+    const int count = splitFields(begin, end, field_begin, field_end, MAX_FIELDS);
+
+    timings_column = -1;
+    power_column = -1;
+    status_column = -1;
+    for (int i = 0; i < count; i++) {
+        const char* b = trimLeft(field_begin[i], field_end[i]);
+        const char* e = trimRight(b, field_end[i]);
+        const std::string name(b, e);
+        if (name == "Timings") {
+            timings_column = i;
+        } else if (name == "Power [W]") {
+            power_column = i;
+        } else if (name == "Status") {
+            status_column = i;
+        }
+    }
+    header_seen = true;
+}
+
+bool CsvTraceReader::parseRow(const char* begin, const char* end, TraceSample& sample) {
+    // Skip the UTF-8 byte order mark written by spreadsheet exports.
+    if (line_number == 1 && end - begin >= 3 && std::memcmp(begin, "\xEF\xBB\xBF", 3) == 0) {
+        begin += 3;
+    }
+
+    const char* field_begin[MAX_FIELDS];
+    const char* field_end[MAX_FIELDS];
+    const int count = splitFields(begin, end, field_begin, field_end, MAX_FIELDS);
+
+    // The first non-empty line is the header unless it already holds data.
+    if (!header_seen && row_count == 0) {
+        const char* first = trimLeft(field_begin[0], field_end[0]);
+        double unused = 0.0;
+        std::uint64_t unused_time = 0;
+        std::uint64_t unused_resolution = 0;
+        if (first != trimRight(first, field_end[0]) &&
+            !parseTimingTicks(field_begin[0], field_end[0], MAX_TICKS_PER_SECOND, unused_time,
+                              unused_resolution) &&
+            !parseDecimal(field_begin[0], field_end[0], unused)) {
+            parseHeader(begin, end);
+            return false;
+        }
+        header_seen = true;
+    }
+
+    std::uint64_t timestamp = row_count * ticks_per_second;
+    if (timings_column >= 0) {
+        if (count <= timings_column) {
+            return false;
+        }
+        const char* timing_begin = field_begin[timings_column];
+        const char* timing_end = field_end[timings_column];
+        std::uint64_t resolution = 0;
+        if (row_count == 0 &&
+            parseTimingTicks(timing_begin, timing_end, MAX_TICKS_PER_SECOND, timestamp, resolution)) {
+            ticks_per_second = resolution;
+        }
+        if (!parseTimingTicks(timing_begin, timing_end, ticks_per_second, timestamp, resolution)) {
+            if (resolution > ticks_per_second) {
+                throw std::runtime_error(path + ":" + std::to_string(line_number) + ": timing '" +
+                                         std::string(trimLeft(timing_begin, timing_end),
+                                                     trimRight(timing_begin, timing_end)) +
+                                         "' is finer than the trace resolution of 1/" +
+                                         std::to_string(ticks_per_second) + " s");
+            }
+            return false;
+        }
+    }
+
+    int state = -1;
+    if (status_column >= 0) {
+        if (count <= status_column) {
+            return false;
+        }
+        const char* status_begin = trimLeft(field_begin[status_column], field_end[status_column]);
+        const char* status_end = trimRight(status_begin, field_end[status_column]);
+        if (status_begin == status_end) {
+            return false;
+        }
+
+        state = statusFromString(std::string(status_begin, status_end));
+        if (state < 0) {
+            throw std::runtime_error(path + ":" + std::to_string(line_number) +
+                                     ": unknown status '" + std::string(status_begin, status_end) + "'");
+        }
+    }
+
+    double power = std::numeric_limits<double>::quiet_NaN();
+    if (power_column >= 0) {
+        if (count <= power_column ||
+            !parseDecimal(field_begin[power_column], field_end[power_column], power)) {
+            if (status_column < 0) {
+                // Power-only files have nothing else to offer in this row.
+                return false;
+            }
+            power = std::numeric_limits<double>::quiet_NaN();
+        }
+    }
+
+    if (row_count == 0) {
+        first_timestamp = timestamp;
+    } else if (timestamp < last_timestamp) {
+        throw std::runtime_error(path + ":" + std::to_string(line_number) +
+                                 ": timings are not monotonic");
+    } else if (sample_period == 0 && timestamp > last_timestamp) {
+        sample_period = timestamp - last_timestamp;
+    }
+    ++row_count;
+    last_timestamp = timestamp;
+
+    sample.timestamp = timestamp - first_timestamp;
+    sample.state = state;
+    sample.power = power;
+    return true;
+}
+
+bool CsvTraceReader::nextSample(TraceSample& sample) {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    while (nextLine(begin, end)) {
+        if (parseRow(begin, end, sample)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CsvTraceReader::next(TraceRun& run) {
+    if (finished) {
+        return false;
+    }
+
+    TraceSample sample;
+    while (nextSample(sample)) {
+        if (status_column < 0) {
+            throw std::runtime_error(path + " has no Status column");
+        }
+
+        if (!have_pending) {
+            pending.state = sample.state;
+            pending.start = sample.timestamp;
+            pending.measured_energy = 0.0;
+            have_pending = true;
+            previous = sample;
+            continue;
+        }
+        pending.measured_energy +=
+            previous.power * traceSeconds(sample.timestamp - previous.timestamp, ticks_per_second);
+        previous = sample;
+        if (sample.state != pending.state) {
+            run = pending;
+            run.duration = sample.timestamp - pending.start;
+            pending.state = sample.state;
+            pending.start = sample.timestamp;
+            pending.measured_energy = 0.0;
+            ++run_count;
+            return true;
+        }
+    }
+
+    finished = true;
+    if (!have_pending) {
+        return false;
+    }
+
+    // The last sample covers one sample period.
+    run = pending;
+    run.duration = (last_timestamp - first_timestamp) + samplePeriod() - pending.start;
+    run.measured_energy += previous.power * traceSeconds(samplePeriod(), ticks_per_second);
+    ++run_count;
+    return true;
+}
+
+std::unique_ptr<TraceReader> openTrace(const std::string& path) {
+    if (isBinaryTrace(path)) {
+        return std::unique_ptr<TraceReader>(new BinaryTraceReader(path));
+    }
+    return std::unique_ptr<TraceReader>(new CsvTraceReader(path));
+}
+
+std::uint64_t traceTicksPerSecond(const std::string& path) {
+    if (isBinaryTrace(path)) {
+        return MappedTrace(path).ticksPerSecond();
+    }
+    CsvTraceReader reader(path);
+    TraceSample sample;
+    reader.nextSample(sample);
+    return reader.ticksPerSecond();
+}
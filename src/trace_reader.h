@@ -0,0 +1,193 @@
+/**
+ * trace_reader.h
+ *
+ * Streaming readers that turn measurement traces into runs of identical
+ * states, so the simulation schedules one wait per transition instead of
+ * one per sample.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// One run of consecutive samples sharing the same status.
+// Times are in ticks relative to the first sample of the trace (seconds
+// unless the trace's timings carry fractions, see traceTicksPerSecond()).
+// `measured_energy` is the measured power integrated over the run (each
+// sample held until the next one) and NaN for traces without power.
+struct TraceRun {
+    int state = -1;
+    std::uint64_t start = 0;
+    std::uint64_t duration = 0;
+    double measured_energy = std::numeric_limits<double>::quiet_NaN();
+};
+
+// One measurement row, timestamped relative to the first row. `state` is -1
+// and `power` is NaN when the file has no such column.
+struct TraceSample {
+    std::uint64_t timestamp = 0;
+    int state = -1;
+    double power = std::numeric_limits<double>::quiet_NaN();
+};
+
+class TraceReader {
+public:
+    virtual ~TraceReader() = default;
+
+    // Fills `run` with the next run and returns true, or returns false at
+    // the end of the trace.
+    virtual bool next(TraceRun& run) = 0;
+};
+
+// Replays runs held in memory.
+class VectorTraceReader : public TraceReader {
+public:
+    explicit VectorTraceReader(std::vector<TraceRun> runs) : runs(std::move(runs)) {}
+
+    bool next(TraceRun& run) override {
+        if (position >= runs.size()) {
+            return false;
+        }
+        run = runs[position++];
+        return true;
+    }
+
+    void rewind() { position = 0; }
+
+private:
+    std::vector<TraceRun> runs;
+    std::size_t position = 0;
+};
+
+// Replays runs owned by someone else. Many readers can share one array,
+// e.g. one per worker thread.
+class SpanTraceReader : public TraceReader {
+public:
+    SpanTraceReader(const TraceRun* begin, const TraceRun* end) : current(begin), end(end) {}
+
+    bool next(TraceRun& run) override {
+        if (current == end) {
+            return false;
+        }
+        run = *current++;
+        return true;
+    }
+
+private:
+    const TraceRun* current;
+    const TraceRun* end;
+};
+
+// Maps the status strings used in the measurement files to model state ids.
+// Plain numbers are taken as state ids. Returns -1 for unknown statuses.
+int statusFromString(const std::string& status);
+
+// Finest trace time resolution, 1 ns.
+const std::uint64_t MAX_TICKS_PER_SECOND = 1000000000;
+
+// Parses "HH:MM:SS" into seconds. Returns false if `text` is not a timing.
+bool parseTimings(const char* begin, const char* end, std::uint64_t& seconds);
+
+// Parses "HH:MM:SS" or "HH:MM:SS.fff" (up to 9 fractional digits) into
+// ticks of 1 / ticks_per_second s, and sets `resolution` to the ticks per
+// second the text is written in (10^digits). Returns false if `text` is not
+// a timing or is not a whole number of ticks; `resolution` is still set in
+// the latter case.
+bool parseTimingTicks(const char* begin, const char* end, std::uint64_t ticks_per_second,
+                      std::uint64_t& ticks, std::uint64_t& resolution);
+
+// Seconds of `ticks` at `ticks_per_second`. Every reader converts measured
+// energy through this, so energies agree bit for bit across formats.
+inline double traceSeconds(std::uint64_t ticks, std::uint64_t ticks_per_second) {
+    return static_cast<double>(ticks) / static_cast<double>(ticks_per_second);
+}
+
+// Parses a locale-style decimal such as "2,18E-01". Returns false if the
+// field is empty or not a number.
+bool parseDecimal(const char* begin, const char* end, double& value);
+
+// Reads DVConChallengeLongTimeMeasurement_*.csv-style files
+// (';' separators, ',' decimals, HH:MM:SS timings, status strings).
+// The file is consumed in fixed-size chunks, so memory stays bounded by the
+// chunk size regardless of the trace length.
+//
+// Columns are located through the header line. Files without a Timings
+// column are assumed to be sampled at 1 Hz; files without a Status column
+// can be read sample by sample but not as runs. The time resolution is
+// that of the first timing ("00:00:00.000" gives milliseconds); later
+// timings finer than it are an error.
+class CsvTraceReader : public TraceReader {
+public:
+    static constexpr std::size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    explicit CsvTraceReader(const std::string& path,
+                            std::size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+    bool next(TraceRun& run) override;
+
+    // Returns the next data row. Do not mix with next(TraceRun&).
+    bool nextSample(TraceSample& sample);
+
+    bool hasStatus() const { return status_column >= 0; }
+    bool hasPower() const { return power_column >= 0; }
+
+    // Interval between the first two samples in ticks, 1 s until known.
+    std::uint64_t samplePeriod() const { return sample_period > 0 ? sample_period : ticksPerSecond(); }
+
+    // Time resolution, known after the first sample.
+    std::uint64_t ticksPerSecond() const { return ticks_per_second; }
+
+    std::uint64_t rowCount() const { return row_count; }
+    std::uint64_t runCount() const { return run_count; }
+
+private:
+    // Returns the next complete line of the file (without line terminator),
+    // refilling the chunk buffer as needed.
+    bool nextLine(const char*& begin, const char*& end);
+
+    // Parses one data row; returns false for header and empty rows.
+    bool parseRow(const char* begin, const char* end, TraceSample& sample);
+
+    void parseHeader(const char* begin, const char* end);
+
+    std::string path;
+    std::ifstream file;
+    std::vector<char> buffer;
+    std::size_t buffer_begin = 0;
+    std::size_t buffer_end = 0;
+    bool eof = false;
+    std::uint64_t line_number = 0;
+
+    // Column layout, taken from the header line when present.
+    bool header_seen = false;
+    int timings_column = 0;
+    int power_column = 3;
+    int status_column = 4;
+    std::uint64_t ticks_per_second = 1;
+
+    // Run-length collapsing state. The previous sample's power is charged
+    // to its run once the next sample's time is known.
+    bool have_pending = false;
+    bool finished = false;
+    TraceRun pending;
+    TraceSample previous;
+    std::uint64_t first_timestamp = 0;
+    std::uint64_t last_timestamp = 0;
+    std::uint64_t sample_period = 0;
+
+    std::uint64_t row_count = 0;
+    std::uint64_t run_count = 0;
+};
+
+// Opens `path` with the reader matching its format (binary trace or CSV).
+std::unique_ptr<TraceReader> openTrace(const std::string& path);
+
+// Time resolution of the trace at `path`: the binary header's, or that of
+// the first timing of a CSV file. 1 (seconds) for traces without samples.
+std::uint64_t traceTicksPerSecond(const std::string& path);
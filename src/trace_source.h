@@ -0,0 +1,73 @@
+/**
+ * trace_source.h
+ *
+ * Replays a measurement trace on a status signal, one write and one wait
+ * per state transition. Optionally reports every N runs, at a point where
+ * the monitor has processed everything before the current time, so that a
+ * checkpoint can be taken.
+ */
+
+#pragma once
+
+#include <functional>
+#include <systemc>
+
+#include "event_log.h"
+#include "profiling.h"
+#include "trace_reader.h"
+
+SC_MODULE(TraceSource) {
+    sc_core::sc_port<sc_core::sc_signal_out_if<int>> status_out;
+
+    // Notified, and `finished` set, once the trace has been replayed.
+    sc_core::sc_event done;
+    bool finished = false;
+
+    // Runs replayed so far, counting from `first_run`.
+    std::uint64_t runs = 0;
+
+    SC_HAS_PROCESS(TraceSource);
+
+    // Called with `runs` every `checkpoint_every` runs; 0 disables it.
+    std::uint64_t checkpoint_every = 0;
+    std::function<void(std::uint64_t runs)> checkpoint;
+
+    // `reader` stands at run `first_run`, e.g. after resuming.
+    TraceSource(sc_core::sc_module_name name, TraceReader& reader, std::uint64_t first_run = 0)
+        : sc_core::sc_module(name), status_out("out"), reader(reader), first_run(first_run) {
+        runs = first_run;
+        SC_THREAD(replay);
+    }
+
+    void replay() {
+        TraceRun run;
+        while (nextRun(run)) {
+            {
+                PROFILE_SCOPE(SignalWrite);
+                status_out->write(run.state);
+            }
+            wait(sc_core::sc_time::from_value(run.duration));
+            runs++;
+            // After a zero-length run the monitor has not seen the write yet.
+            if (checkpoint_every > 0 && checkpoint && run.duration > 0 &&
+                (runs - first_run) % checkpoint_every == 0) {
+                checkpoint(runs);
+            }
+        }
+        finished = true;
+        done.notify();
+
+        if (logEnabled(Verbosity::Summary)) {
+            std::cout << "Trace replay complete (" << runs << " runs)" << std::endl;
+        }
+    }
+
+private:
+    bool nextRun(TraceRun& run) {
+        PROFILE_SCOPE(TraceRead);
+        return reader.next(run);
+    }
+
+    TraceReader& reader;
+    std::uint64_t first_run;
+};
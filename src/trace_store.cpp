@@ -0,0 +1,205 @@
+/**
+ * trace_store.cpp
+ */
+
+#include "trace_store.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "binary_trace.h"
+#include "compensated_sum.h"
+
+TraceStore TraceStore::load(const std::string& path) {
+    TraceStore store;
+    store.source = path;
+
+    if (isBinaryTrace(path)) {
+        MappedTrace mapped(path);
+        if (!mapped.hasStates()) {
+            throw std::runtime_error(path + " has no state column");
+        }
+        const std::uint64_t count = mapped.size();
+        store.timestamp_column.assign(mapped.timestamps(), mapped.timestamps() + count);
+        store.state_column.assign(mapped.states(), mapped.states() + count);
+        if (mapped.hasPower()) {
+            store.power_column.assign(mapped.power(), mapped.power() + count);
+        }
+        store.sample_period = mapped.samplePeriod();
+        store.ticks_per_second = mapped.ticksPerSecond();
+    } else {
+        CsvTraceReader reader(path);
+        TraceSample sample;
+        while (reader.nextSample(sample)) {
+            if (!reader.hasStatus()) {
+                throw std::runtime_error(path + " has no Status column");
+            }
+            if (sample.state < 0 || sample.state > std::numeric_limits<std::uint16_t>::max()) {
+                throw std::runtime_error(path + ": state " + std::to_string(sample.state) +
+                                         " cannot be stored");
+            }
+            store.timestamp_column.push_back(sample.timestamp);
+            store.state_column.push_back(static_cast<std::uint16_t>(sample.state));
+            if (reader.hasPower()) {
+                store.power_column.push_back(sample.power);
+            }
+        }
+        store.sample_period = reader.samplePeriod();
+        store.ticks_per_second = reader.ticksPerSecond();
+    }
+
+    if (store.timestamp_column.empty()) {
+        throw std::runtime_error(path + " has no samples");
+    }
+    store.finish();
+    return store;
+}
+
+void TraceStore::finish() {
+    const std::uint64_t count = size();
+    const std::uint64_t* timestamps = timestamp_column.data();
+    const std::uint16_t* states = state_column.data();
+    end_time = timestamps[count - 1] + sample_period;
+
+    if (hasPower()) {
+        CompensatedSum energy;
+        energy_prefix.reserve(count + 1);
+        for (std::uint64_t i = 0; i < count; i++) {
+            energy_prefix.push_back(energy.value());
+            const std::uint64_t next_time = i + 1 < count ? timestamps[i + 1] : end_time;
+            energy.add(power_column[i] * traceSeconds(next_time - timestamps[i], ticks_per_second));
+        }
+        energy_prefix.push_back(energy.value());
+    }
+
+    std::uint64_t position = 0;
+    while (position < count) {
+        const std::uint16_t state = states[position];
+        std::uint64_t run_end = position + 1;
+        while (run_end < count && states[run_end] == state) {
+            ++run_end;
+        }
+        const std::uint64_t run_stop = run_end < count ? timestamps[run_end] : end_time;
+
+        run_first.push_back(position);
+        run_state.push_back(state);
+        run_start.push_back(timestamps[position]);
+        run_duration.push_back(run_stop - timestamps[position]);
+        state_count = std::max(state_count, static_cast<int>(state) + 1);
+
+        // Summed in the same order as the trace readers, so energies match
+        // a streamed replay bit for bit.
+        double energy = std::numeric_limits<double>::quiet_NaN();
+        if (hasPower()) {
+            energy = 0.0;
+            for (std::uint64_t i = position; i < run_end; i++) {
+                const std::uint64_t next_time = i + 1 < count ? timestamps[i + 1] : run_stop;
+                energy += power_column[i] * traceSeconds(next_time - timestamps[i], ticks_per_second);
+            }
+        }
+        run_energy.push_back(energy);
+        position = run_end;
+    }
+}
+
+TraceRun TraceStore::run(std::size_t index) const {
+    TraceRun run;
+    run.state = run_state[index];
+    run.start = run_start[index];
+    run.duration = run_duration[index];
+    run.measured_energy = run_energy[index];
+    return run;
+}
+
+std::uint64_t TraceStore::runSamples(std::size_t index) const {
+    const std::uint64_t end = index + 1 < runCount() ? run_first[index + 1] : size();
+    return end - run_first[index];
+}
+
+std::size_t TraceStore::findRun(std::uint64_t time) const {
+    if (time >= end_time) {
+        return runCount();
+    }
+    const std::size_t after = static_cast<std::size_t>(
+        std::upper_bound(run_start.begin(), run_start.end(), time) - run_start.begin());
+    return after > 0 ? after - 1 : 0;
+}
+
+double TraceStore::measuredEnergyAt(std::uint64_t time) const {
+    if (time >= end_time) {
+        return energy_prefix.back();
+    }
+    // Last sample starting at or before `time`; it is held until the next.
+    const std::uint64_t* timestamps = timestamp_column.data();
+    const std::uint64_t after = static_cast<std::uint64_t>(
+        std::upper_bound(timestamps, timestamps + size(), time) - timestamps);
+    if (after == 0) {
+        return 0.0;
+    }
+    const std::uint64_t i = after - 1;
+    return energy_prefix[i] + power_column[i] * traceSeconds(time - timestamps[i], ticks_per_second);
+}
+
+double TraceStore::measuredEnergy(std::uint64_t from, std::uint64_t to) const {
+    if (!hasPower()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return to > from ? measuredEnergyAt(to) - measuredEnergyAt(from) : 0.0;
+}
+
+RangeStats TraceStore::query(std::uint64_t from, std::uint64_t to) const {
+    RangeStats stats;
+    stats.from = std::min(from, end_time);
+    stats.to = std::max(stats.from, std::min(to, end_time));
+    stats.state_duration.assign(state_count, 0);
+    stats.state_energy.assign(state_count, hasPower() ? 0.0 : std::numeric_limits<double>::quiet_NaN());
+    stats.state_runs.assign(state_count, 0);
+    if (!hasPower()) {
+        stats.energy = std::numeric_limits<double>::quiet_NaN();
+    }
+
+    const std::size_t first = findRun(stats.from);
+    for (std::size_t r = first; r < runCount() && run_start[r] < stats.to; r++) {
+        const std::uint64_t start = run_start[r];
+        const std::uint64_t stop = start + run_duration[r];
+        const std::uint64_t begin = std::max(start, stats.from);
+        const std::uint64_t end = std::min(stop, stats.to);
+        if (end <= begin) {
+            continue;
+        }
+        const int state = run_state[r];
+        stats.state_duration[state] += end - begin;
+        stats.state_runs[state]++;
+        if (r != first) {
+            stats.transitions++;
+        }
+        if (hasPower()) {
+            const double energy = begin == start && end == stop ? run_energy[r] : measuredEnergy(begin, end);
+            stats.state_energy[state] += energy;
+            stats.energy += energy;
+        }
+    }
+    return stats;
+}
+
+ValidationReference TraceStore::reference() const {
+    const RangeStats stats = query(0, end_time);
+    ValidationReference reference;
+    reference.source = source;
+    reference.has_energy = hasPower();
+    reference.total_energy = hasPower() ? stats.energy : 0.0;
+    reference.duration = traceSeconds(stats.duration(), ticks_per_second);
+    reference.average_power = reference.duration > 0.0 ? reference.total_energy / reference.duration : 0.0;
+    reference.transitions = stats.transitions;
+    reference.state_energy.assign(state_count, 0.0);
+    reference.state_duration.assign(state_count, 0.0);
+    for (int s = 0; s < state_count; s++) {
+        if (hasPower()) {
+            reference.state_energy[s] = stats.state_energy[s];
+        }
+        reference.state_duration[s] = traceSeconds(stats.state_duration[s], ticks_per_second);
+    }
+    return reference;
+}
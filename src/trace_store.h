@@ -0,0 +1,138 @@
+/**
+ * trace_store.h
+ *
+ * In-memory columnar copy of one trace with a run index. The timestamp,
+ * state and power columns are loaded once into contiguous arrays, and the
+ * runs of identical states (first sample, length, start, duration,
+ * measured energy) are indexed in the same pass. Replays, validation and
+ * range queries then work on the index: a query walks the runs it covers
+ * instead of the samples. A prefix sum of the measured energy per sample
+ * makes the energy of any range two binary searches and a subtraction.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "trace_reader.h"
+#include "validation.h"
+
+// Per-state figures of a time range of a trace.
+struct RangeStats {
+    std::uint64_t from = 0;  // ticks, clipped to the trace
+    std::uint64_t to = 0;
+
+    // State changes strictly inside the range.
+    std::uint64_t transitions = 0;
+    double energy = 0.0;  // measured J; NaN without power
+
+    // One entry per state id up to the highest in the trace.
+    std::vector<std::uint64_t> state_duration;  // ticks
+    std::vector<double> state_energy;           // measured J; NaN without power
+    std::vector<std::uint64_t> state_runs;      // runs overlapping the range
+
+    std::uint64_t duration() const { return to - from; }
+};
+
+class TraceStore {
+public:
+    // Loads a CSV or binary trace. Throws std::runtime_error if the trace
+    // has no state column or no samples.
+    static TraceStore load(const std::string& path);
+
+    const std::string& path() const { return source; }
+
+    std::uint64_t size() const { return timestamp_column.size(); }
+    std::uint64_t samplePeriod() const { return sample_period; }
+    std::uint64_t ticksPerSecond() const { return ticks_per_second; }
+    bool hasPower() const { return !power_column.empty(); }
+
+    // End of the last sample, which covers one sample period.
+    std::uint64_t duration() const { return end_time; }
+    int stateCount() const { return state_count; }
+
+    const std::uint64_t* timestamps() const { return timestamp_column.data(); }
+    const std::uint16_t* states() const { return state_column.data(); }
+    const double* power() const { return hasPower() ? power_column.data() : nullptr; }
+
+    // Measured energy before each sample, size() + 1 entries with the total
+    // last; nullptr without power.
+    const double* energyPrefix() const { return hasPower() ? energy_prefix.data() : nullptr; }
+
+    // The run index, in trace order. Consecutive runs differ in state.
+    std::size_t runCount() const { return run_state.size(); }
+    TraceRun run(std::size_t index) const;
+    std::uint64_t runFirstSample(std::size_t index) const { return run_first[index]; }
+    std::uint64_t runSamples(std::size_t index) const;
+
+    // The index columns, runCount() entries each.
+    const std::uint16_t* runStates() const { return run_state.data(); }
+    const std::uint64_t* runStarts() const { return run_start.data(); }
+    const std::uint64_t* runDurations() const { return run_duration.data(); }
+    const double* runEnergies() const { return run_energy.data(); }
+
+    // Index of the run covering `time`, or runCount() past the end.
+    std::size_t findRun(std::uint64_t time) const;
+
+    // Per-state duration, measured energy and runs, and the transitions,
+    // of [from, to) in ticks.
+    RangeStats query(std::uint64_t from, std::uint64_t to) const;
+
+    // Measured energy of [from, to) in ticks, NaN without power.
+    double measuredEnergy(std::uint64_t from, std::uint64_t to) const;
+
+    // The whole trace as a validation reference, as ReferenceRecorder
+    // would collect it during a replay.
+    ValidationReference reference() const;
+
+private:
+    TraceStore() = default;
+
+    // Builds the run index over the loaded columns.
+    void finish();
+
+    // Measured energy before `time`.
+    double measuredEnergyAt(std::uint64_t time) const;
+
+    std::string source;
+    std::uint64_t sample_period = 1;
+    std::uint64_t ticks_per_second = 1;
+    std::uint64_t end_time = 0;
+    int state_count = 0;
+
+    std::vector<std::uint64_t> timestamp_column;
+    std::vector<std::uint16_t> state_column;
+    std::vector<double> power_column;
+    std::vector<double> energy_prefix;  // measured energy before each sample, and in total
+
+    std::vector<std::uint64_t> run_first;
+    std::vector<std::uint16_t> run_state;
+    std::vector<std::uint64_t> run_start;
+    std::vector<std::uint64_t> run_duration;
+    std::vector<double> run_energy;
+};
+
+// Replays runs [begin, end) of a store's index. Many readers can share one
+// store, e.g. one per worker thread.
+class StoreRunReader : public TraceReader {
+public:
+    explicit StoreRunReader(const TraceStore& store) : StoreRunReader(store, 0, store.runCount()) {}
+    StoreRunReader(const TraceStore& store, std::size_t begin, std::size_t end)
+        : store(store), position(begin), end(end) {}
+
+    bool next(TraceRun& run) override {
+        if (position >= end) {
+            return false;
+        }
+        run = store.run(position++);
+        return true;
+    }
+
+private:
+    const TraceStore& store;
+    std::size_t position;
+    std::size_t end;
+};
@@ -0,0 +1,155 @@
+/**
+ * transition_matrix.cpp
+ */
+
+#include "transition_matrix.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "trace_reader.h"
+
+namespace {
+
+// Sample period of the measurement files behind transitions.csv.
+const double SAMPLE_PERIOD = 1.0;  // seconds
+
+std::string trim(const std::string& text) {
+    const std::size_t begin = text.find_first_not_of(" \t\r\"");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    const std::size_t end = text.find_last_not_of(" \t\r\"");
+    return text.substr(begin, end - begin + 1);
+}
+
+std::vector<std::string> splitFields(const std::string& line) {
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    std::string field;
+    while (std::getline(stream, field, ',')) {
+        fields.push_back(trim(field));
+    }
+    return fields;
+}
+
+int columnIndex(const std::vector<std::string>& header, const std::string& name) {
+    for (std::size_t i = 0; i < header.size(); i++) {
+        if (header[i] == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool parseNumber(const std::string& text, double& value) {
+    return parseDecimal(text.data(), text.data() + text.size(), value);
+}
+
+} // namespace
+
+TransitionMatrix TransitionMatrix::load(const std::string& path, const PowerTable& table) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open transition matrix " + path);
+    }
+
+    const int n = table.stateCount();
+    TransitionMatrix matrix(n);
+    std::vector<double> excess_sum(static_cast<std::size_t>(n) * n, 0.0);
+    std::vector<std::size_t> excess_count(static_cast<std::size_t>(n) * n, 0);
+    std::vector<bool> defined(static_cast<std::size_t>(n) * n, false);
+
+    // Column layout: From,To,Energy_J unless the header says otherwise.
+    int from_column = 0;
+    int to_column = 1;
+    int energy_column = 2;
+    int power_column = -1;
+    bool header_seen = false;
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        const std::string where = path + ":" + std::to_string(line_number);
+
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        const std::vector<std::string> fields = splitFields(line);
+
+        if (!header_seen) {
+            header_seen = true;
+            if (columnIndex(fields, "PrevStatus") >= 0) {
+                from_column = columnIndex(fields, "PrevStatus");
+                to_column = columnIndex(fields, "Status");
+                power_column = columnIndex(fields, "Power [W]");
+                energy_column = -1;
+                if (to_column < 0 || power_column < 0) {
+                    throw std::runtime_error(where + ": expected Status and Power [W] columns");
+                }
+                continue;
+            }
+            if (columnIndex(fields, "From") >= 0) {
+                from_column = columnIndex(fields, "From");
+                to_column = columnIndex(fields, "To");
+                energy_column = columnIndex(fields, "Energy_J");
+                if (to_column < 0 || energy_column < 0) {
+                    throw std::runtime_error(where + ": expected From,To,Energy_J");
+                }
+                continue;
+            }
+        }
+
+        const int needed = std::max(std::max(from_column, to_column),
+                                    power_column >= 0 ? power_column : energy_column);
+        if (static_cast<int>(fields.size()) <= needed) {
+            throw std::runtime_error(where + ": too few columns");
+        }
+        // The first transition of transitions.csv has no previous state.
+        if (power_column >= 0 && fields[from_column].empty()) {
+            continue;
+        }
+
+        const int from = statusFromString(fields[from_column]);
+        const int to = statusFromString(fields[to_column]);
+        for (int state : {from, to}) {
+            if (!table.contains(state)) {
+                throw std::runtime_error(where + ": state '" +
+                                         fields[state == from ? from_column : to_column] +
+                                         "' is not in the power table (" + std::to_string(n) +
+                                         " states)");
+            }
+        }
+
+        const std::size_t pair = matrix.pairIndex(from, to);
+        double value = 0.0;
+        if (power_column >= 0) {
+            if (!parseNumber(fields[power_column], value)) {
+                throw std::runtime_error(where + ": invalid power value");
+            }
+            excess_sum[pair] += (value - table.power(to)) * SAMPLE_PERIOD;
+            excess_count[pair]++;
+        } else {
+            if (!parseNumber(fields[energy_column], value)) {
+                throw std::runtime_error(where + ": invalid energy value");
+            }
+            if (defined[pair]) {
+                throw std::runtime_error(where + ": transition " + std::to_string(from) + " -> " +
+                                         std::to_string(to) + " defined twice");
+            }
+            matrix.cost_j[pair] = value;
+            defined[pair] = true;
+        }
+    }
+
+    for (std::size_t pair = 0; pair < excess_count.size(); pair++) {
+        if (excess_count[pair] > 0) {
+            matrix.cost_j[pair] = excess_sum[pair] / static_cast<double>(excess_count[pair]);
+        }
+    }
+    return matrix;
+}
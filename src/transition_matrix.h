@@ -0,0 +1,50 @@
+/**
+ * transition_matrix.h
+ *
+ * Switching overhead per state pair, e.g. Bluetooth connect spikes, as a
+ * dense N x N matrix indexed by from * N + to. Charging a transition is a
+ * single array read.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "power_table.h"
+
+class TransitionMatrix {
+public:
+    // All-zero matrix for `state_count` states.
+    explicit TransitionMatrix(int state_count = 0)
+        : state_count(state_count),
+          cost_j(static_cast<std::size_t>(state_count) * state_count, 0.0) {}
+
+    // Loads transition costs for the states of `table`. Two formats are
+    // accepted:
+    //
+    //   From,To,Energy_J                  one row per pair, in Joules
+    //   transitions.csv                   as written by 03_transition_analysis.py
+    //
+    // For transitions.csv the cost of a pair is the mean excess of the
+    // first sample after the transition over the model power of the new
+    // state, times the 1 s sample period. States are ids or the status
+    // strings of the measurement files. Throws std::runtime_error on
+    // malformed files or states that are not in the table.
+    static TransitionMatrix load(const std::string& path, const PowerTable& table);
+
+    int stateCount() const { return state_count; }
+
+    std::size_t pairIndex(int from, int to) const {
+        return static_cast<std::size_t>(from) * state_count + to;
+    }
+
+    double cost(std::size_t pair) const { return cost_j[pair]; }
+    double cost(int from, int to) const { return cost_j[pairIndex(from, to)]; }
+    void setCost(int from, int to, double energy) { cost_j[pairIndex(from, to)] = energy; }
+
+private:
+    int state_count;
+    std::vector<double> cost_j;  // from * state_count + to
+};
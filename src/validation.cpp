@@ -0,0 +1,627 @@
+/**
+ * validation.cpp
+ */
+
+#include "validation.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "event_log.h"
+#include "profiling.h"
+
+namespace {
+
+// Binary traces store states as 16-bit ids.
+const long MAX_REFERENCE_STATES = 65536;
+
+std::string trim(const std::string& text) {
+    const std::size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    const std::size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+double valueAt(const std::vector<double>& values, int state) {
+    return state >= 0 && static_cast<std::size_t>(state) < values.size() ? values[state] : 0.0;
+}
+
+double modelDuration(const EnergyAccumulator& accumulator) {
+    return ticksToSeconds(accumulator.total_ticks);
+}
+
+} // namespace
+
+double ValidationReference::stateEnergy(int state) const {
+    return valueAt(state_energy, state);
+}
+
+double ValidationReference::stateDuration(int state) const {
+    return valueAt(state_duration, state);
+}
+
+ValidationReference ValidationReference::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open reference file " + path);
+    }
+
+    ValidationReference reference;
+    reference.source = path;
+    bool seen_row = false;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        const std::string where = path + ":" + std::to_string(line_number);
+
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> fields;
+        std::stringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, ',')) {
+            fields.push_back(trim(field));
+        }
+
+        char* end = nullptr;
+        const long state = std::strtol(fields[0].c_str(), &end, 10);
+        const bool numeric_state = !fields[0].empty() && *end == '\0';
+        if (fields[0] == "Transitions" && fields.size() == 2) {
+            const unsigned long long count = std::strtoull(fields[1].c_str(), &end, 10);
+            if (fields[1].empty() || *end != '\0') {
+                throw std::runtime_error(where + ": invalid transition count");
+            }
+            reference.transitions = count;
+        } else if (!numeric_state && !seen_row) {
+            // header line
+        } else if (!numeric_state || state < 0 || state >= MAX_REFERENCE_STATES || fields.size() != 3) {
+            throw std::runtime_error(where + ": expected State,Energy_J,Duration_s");
+        } else {
+            double energy = 0.0;
+            double duration = 0.0;
+            if (!parseDecimal(fields[1].data(), fields[1].data() + fields[1].size(), energy) ||
+                !parseDecimal(fields[2].data(), fields[2].data() + fields[2].size(), duration) ||
+                duration < 0.0) {
+                throw std::runtime_error(where + ": invalid energy or duration");
+            }
+            if (static_cast<std::size_t>(state) >= reference.state_energy.size()) {
+                reference.state_energy.resize(state + 1, 0.0);
+                reference.state_duration.resize(state + 1, 0.0);
+            }
+            reference.state_energy[state] += energy;
+            reference.state_duration[state] += duration;
+        }
+        seen_row = true;
+    }
+
+    if (reference.state_energy.empty()) {
+        throw std::runtime_error("Reference file " + path + " defines no states");
+    }
+    for (std::size_t s = 0; s < reference.state_energy.size(); s++) {
+        reference.total_energy += reference.state_energy[s];
+        reference.duration += reference.state_duration[s];
+    }
+    reference.average_power = reference.duration > 0.0 ? reference.total_energy / reference.duration : 0.0;
+    return reference;
+}
+
+const ValidationReference& builtinReference() {
+    static const ValidationReference reference = [] {
+        ValidationReference builtin;
+        builtin.source = "DVCon measurement";
+        builtin.total_energy = MEASURED_TOTAL_ENERGY;
+        builtin.average_power = MEASURED_AVG_POWER;
+        builtin.duration = MEASURED_DURATION;
+        builtin.transitions = 10;
+        builtin.state_energy.assign(MEASURED_ENERGY_STATE, MEASURED_ENERGY_STATE + NUM_STATES);
+        builtin.state_duration.assign(MEASURED_DURATION_STATE, MEASURED_DURATION_STATE + NUM_STATES);
+        return builtin;
+    }();
+    return reference;
+}
+
+const ValidationReference& noReference() {
+    static const ValidationReference reference = [] {
+        ValidationReference none;
+        none.source = "none";
+        none.has_energy = false;
+        none.has_timing = false;
+        return none;
+    }();
+    return reference;
+}
+
+ReferenceRecorder::ReferenceRecorder(std::unique_ptr<TraceReader> source, std::string name)
+    : inner(std::move(source)) {
+    collected.source = std::move(name);
+    collected.transitions = 0;
+}
+
+bool ReferenceRecorder::next(TraceRun& run) {
+    if (!inner->next(run)) {
+        return false;
+    }
+    if (run.state < 0) {
+        return true;
+    }
+    const std::size_t state = static_cast<std::size_t>(run.state);
+    if (state >= state_ticks.size()) {
+        state_ticks.resize(state + 1, 0);
+        collected.state_energy.resize(state + 1, 0.0);
+    }
+    state_ticks[state] += run.duration;
+    ticks += run.duration;
+    if (std::isnan(run.measured_energy)) {
+        collected.has_energy = false;
+    } else {
+        collected.state_energy[state] += run.measured_energy;
+        collected.total_energy += run.measured_energy;
+    }
+    if (previous_state >= 0 && run.state != previous_state) {
+        collected.transitions++;
+    }
+    previous_state = run.state;
+    return true;
+}
+
+ValidationReference ReferenceRecorder::reference() const {
+    ValidationReference reference = collected;
+    reference.duration = ticksToSeconds(ticks);
+    reference.average_power = reference.duration > 0.0 ? reference.total_energy / reference.duration : 0.0;
+    reference.state_duration.resize(state_ticks.size());
+    for (std::size_t s = 0; s < state_ticks.size(); s++) {
+        reference.state_duration[s] = ticksToSeconds(state_ticks[s]);
+    }
+    return reference;
+}
+
+double stateEnergyErrorSum(const EnergyAccumulator& accumulator, const ValidationReference& reference) {
+    double error_sum = 0.0;
+    for (int i = 0; i < accumulator.table->stateCount(); i++) {
+        error_sum += std::abs(accumulator.state_energy[i] - reference.stateEnergy(i));
+    }
+    return error_sum;
+}
+
+void reportFinalEnergy(const EnergyAccumulator& accumulator, double final_energy) {
+    if (accumulator.previous_status >= 0 && logEnabled(Verbosity::Summary)) {
+        std::cout << "Final state " << accumulator.previous_status
+                  << " consumed " << final_energy << " J" << std::endl;
+        if (accumulator.transition_costs) {
+            std::cout << "Transition Energy: " << accumulator.transition_energy << " J" << std::endl;
+        }
+        std::cout << "Total Energy: " << accumulator.energyEstimation << " J" << std::endl;
+    }
+}
+
+void validateResults(const EnergyAccumulator& accumulator, const ValidationReference& reference) {
+    if (!logEnabled(Verbosity::Summary)) {
+        return;
+    }
+
+    std::cout << "\n=== VALIDATION ===" << std::endl;
+    if (&reference != &builtinReference()) {
+        std::cout << "Reference: " << reference.source << std::endl;
+    }
+    if (!reference.has_energy) {
+        std::cout << "Expected energy: n/a (the trace has no power column)" << std::endl;
+        std::cout << "Calculated energy: " << accumulator.energyEstimation << " J" << std::endl;
+        return;
+    }
+
+    double error = std::abs(accumulator.energyEstimation - reference.total_energy);
+    double error_percent = (error / reference.total_energy) * 100.0;
+
+    std::cout << "Expected energy: " << reference.total_energy << " J" << std::endl;
+    std::cout << "Calculated energy: " << accumulator.energyEstimation << " J" << std::endl;
+    std::cout << "Error: " << error << " J (" << error_percent << "%)" << std::endl;
+
+    if (error_percent < VALIDATION_TOLERANCE_PERCENT) {
+        std::cout << "✓ PASS: Within 1% tolerance" << std::endl;
+    } else {
+        std::cout << "✗ FAIL: Exceeds 1% tolerance" << std::endl;
+    }
+}
+
+void generateValidationCSV(const EnergyAccumulator& accumulator, const std::string& path,
+                           const ValidationReference& reference) {
+    PROFILE_SCOPE(CsvWrite);
+    const double energyEstimation = accumulator.energyEstimation;
+    const std::vector<double>& state_energy = accumulator.state_energy;
+    const std::vector<double>& state_duration = accumulator.state_duration;
+    const PowerTable& table = *accumulator.table;
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    // Energies are compared against nan without a measurement.
+    const double measured_total_energy = reference.has_energy ? reference.total_energy : nan;
+    const double measured_avg_power = reference.has_energy ? reference.average_power : nan;
+
+    std::ofstream csv_file(path);
+
+    if (!csv_file.is_open()) {
+        std::cerr << "Error: Could not create validation CSV file " << path << std::endl;
+        return;
+    }
+
+    csv_file << std::fixed << std::setprecision(6);
+
+    // === OVERALL METRICS ===
+    csv_file << "=== OVERALL METRICS ===\n";
+    csv_file << "Metric,Measured,Model,Error,Error_Percent\n";
+
+    // Total energy
+    double energy_error = energyEstimation - measured_total_energy;
+    double energy_error_pct = (energy_error / measured_total_energy) * 100.0;
+    csv_file << "Total Energy (J)," << measured_total_energy << ","
+             << energyEstimation << "," << energy_error << ","
+             << energy_error_pct << "\n";
+
+    // Average power over the replayed trace
+    const double model_duration = modelDuration(accumulator);
+    double model_avg_power = model_duration > 0.0 ? energyEstimation / model_duration : 0.0;
+    double power_error = model_avg_power - measured_avg_power;
+    double power_error_pct = (power_error / measured_avg_power) * 100.0;
+    csv_file << "Average Power (W)," << measured_avg_power << ","
+             << model_avg_power << "," << power_error << ","
+             << power_error_pct << "\n";
+
+    // Duration
+    const double measured_duration = reference.has_timing ? reference.duration : nan;
+    const double duration_error = model_duration - measured_duration;
+    csv_file << "Duration (s)," << measured_duration << ","
+             << model_duration << "," << duration_error << ","
+             << (!reference.has_timing ? nan
+                 : reference.duration > 0.0 ? duration_error / reference.duration * 100.0 : 0.0) << "\n";
+
+    // Transitions; the first state entered is not one (-1 without any).
+    const long long measured_transitions = static_cast<long long>(reference.transitions);
+    const long long model_transitions = static_cast<long long>(accumulator.transition_count) - 1;
+    if (reference.has_timing) {
+        csv_file << "Transitions," << measured_transitions << "," << model_transitions << ","
+                 << (model_transitions - measured_transitions) << ",0.0\n";
+    } else {
+        csv_file << "Transitions," << nan << "," << model_transitions << "," << nan << "," << nan << "\n";
+    }
+
+    csv_file << "\n";
+
+    // === PER-STATE METRICS ===
+    csv_file << "=== PER-STATE ENERGY (Joules) ===\n";
+    csv_file << "State,State_Name,Measured,Model,Error,Error_Percent\n";
+
+    // States beyond the built-in model have no measurement to compare to.
+    for (int i = 0; i < table.stateCount(); i++) {
+        double measured_energy = reference.has_energy ? reference.stateEnergy(i) : nan;
+        double state_error = state_energy[i] - measured_energy;
+        double state_error_pct = (measured_energy > 0 || !reference.has_energy) ?
+            (state_error / measured_energy) * 100.0 : 0.0;
+
+        csv_file << i << "," << table.name(i) << ","
+                 << measured_energy << ","
+                 << state_energy[i] << ","
+                 << state_error << ","
+                 << state_error_pct << "\n";
+    }
+
+    csv_file << "\n";
+
+    // === PER-STATE DURATION ===
+    csv_file << "=== PER-STATE DURATION (seconds) ===\n";
+    csv_file << "State,State_Name,Measured,Model,Error,Error_Percent\n";
+
+    for (int i = 0; i < table.stateCount(); i++) {
+        double measured_duration = reference.has_timing ? reference.stateDuration(i) : nan;
+        double duration_error = state_duration[i] - measured_duration;
+        double duration_error_pct = (measured_duration > 0 || !reference.has_timing) ?
+            (duration_error / measured_duration) * 100.0 : 0.0;
+
+        csv_file << i << "," << table.name(i) << ","
+                 << measured_duration << ","
+                 << state_duration[i] << ","
+                 << duration_error << ","
+                 << duration_error_pct << "\n";
+    }
+
+    csv_file << "\n";
+
+    // === TRANSITIONS === (with a transition-cost matrix only)
+    if (accumulator.transition_costs) {
+        csv_file << "=== TRANSITIONS ===\n";
+        csv_file << "From,To,Count,Cost_J,Energy_J\n";
+        const int n = table.stateCount();
+        for (int from = 0; from < n; from++) {
+            for (int to = 0; to < n; to++) {
+                const std::size_t pair = static_cast<std::size_t>(from) * n + to;
+                const std::uint64_t count = accumulator.pair_transitions[pair];
+                if (count == 0) {
+                    continue;
+                }
+                const double cost = accumulator.transition_costs->cost(pair);
+                csv_file << from << "," << to << "," << count << "," << cost << ","
+                         << cost * static_cast<double>(count) << "\n";
+            }
+        }
+        csv_file << "Total,,,," << accumulator.transition_energy << "\n";
+        csv_file << "\n";
+    }
+
+    // === SUMMARY STATISTICS ===
+    csv_file << "=== SUMMARY STATISTICS ===\n";
+    csv_file << "Metric,Value\n";
+    csv_file << "Total Energy Error (J)," << std::abs(energy_error) << "\n";
+    csv_file << "Total Energy Error (%)," << std::abs(energy_error_pct) << "\n";
+    csv_file << "Per-State Energy Error Sum (J),"
+             << (reference.has_energy ? stateEnergyErrorSum(accumulator, reference) : nan) << "\n";
+    csv_file << "Model Status,"
+             << (!reference.has_energy ? "n/a"
+                 : std::abs(energy_error_pct) < VALIDATION_TOLERANCE_PERCENT ? "PASS" : "FAIL") << "\n";
+
+    csv_file.close();
+
+    if (logEnabled(Verbosity::Summary)) {
+        std::cout << "\n✓ Validation CSV generated: " << path << std::endl;
+    }
+}
+
+ReportFormat parseReportFormat(const std::string& text) {
+    if (text == "csv") {
+        return ReportFormat::Csv;
+    }
+    if (text == "jsonl") {
+        return ReportFormat::JsonLines;
+    }
+    throw std::runtime_error("unknown report format '" + text + "' (expected csv or jsonl)");
+}
+
+namespace {
+
+// Shortest text that reads back as `value`; null when not finite.
+std::string jsonNumber(double value) {
+    if (!std::isfinite(value)) {
+        return "null";
+    }
+    std::ostringstream text;
+    text.precision(std::numeric_limits<double>::max_digits10);
+    text << value;
+    return text.str();
+}
+
+std::string jsonString(const std::string& text) {
+    std::string quoted = "\"";
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+            quoted += escape;
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+// Appends one comparison record: measured and model value, their
+// difference and the difference relative to the measurement.
+void appendComparison(std::ostringstream& out, const std::string& head, double measured, double model,
+                      double error_percent) {
+    out << head << ",\"measured\":" << jsonNumber(measured) << ",\"model\":" << jsonNumber(model)
+        << ",\"error\":" << jsonNumber(model - measured) << ",\"error_percent\":" << jsonNumber(error_percent)
+        << "}\n";
+}
+
+} // namespace
+
+void generateValidationJsonl(const EnergyAccumulator& accumulator, const std::string& path,
+                             const ValidationReference& reference) {
+    PROFILE_SCOPE(CsvWrite);
+    const PowerTable& table = *accumulator.table;
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double energy = accumulator.energyEstimation;
+    const double measured_energy = reference.has_energy ? reference.total_energy : nan;
+    const double measured_power = reference.has_energy ? reference.average_power : nan;
+    const double model_duration = modelDuration(accumulator);
+    const double model_power = model_duration > 0.0 ? energy / model_duration : 0.0;
+    const double energy_error_pct = (energy - measured_energy) / measured_energy * 100.0;
+    const std::string run = "{\"run\":" + jsonString(path);
+
+    std::ostringstream out;
+    const std::string metric = run + ",\"kind\":\"metric\",\"metric\":";
+    appendComparison(out, metric + "\"Total Energy (J)\"", measured_energy, energy, energy_error_pct);
+    appendComparison(out, metric + "\"Average Power (W)\"", measured_power, model_power,
+                     (model_power - measured_power) / measured_power * 100.0);
+    const double measured_duration = reference.has_timing ? reference.duration : nan;
+    appendComparison(out, metric + "\"Duration (s)\"", measured_duration, model_duration,
+                     measured_duration > 0.0 ? (model_duration - measured_duration) / measured_duration * 100.0
+                     : reference.has_timing ? 0.0 : nan);
+    const long long measured_transitions = static_cast<long long>(reference.transitions);
+    const long long model_transitions = static_cast<long long>(accumulator.transition_count) - 1;
+    if (reference.has_timing) {
+        out << metric << "\"Transitions\",\"measured\":" << measured_transitions
+            << ",\"model\":" << model_transitions << ",\"error\":" << model_transitions - measured_transitions
+            << ",\"error_percent\":0}\n";
+    } else {
+        out << metric << "\"Transitions\",\"measured\":null,\"model\":" << model_transitions
+            << ",\"error\":null,\"error_percent\":null}\n";
+    }
+
+    for (int i = 0; i < table.stateCount(); i++) {
+        const std::string state = ",\"state\":" + std::to_string(i) + ",\"name\":" + jsonString(table.name(i));
+        const double state_measured = reference.has_energy ? reference.stateEnergy(i) : nan;
+        const double state_energy = accumulator.state_energy[i];
+        appendComparison(out, run + ",\"kind\":\"state_energy\"" + state, state_measured, state_energy,
+                         (state_measured > 0 || !reference.has_energy)
+                             ? (state_energy - state_measured) / state_measured * 100.0 : 0.0);
+    }
+    for (int i = 0; i < table.stateCount(); i++) {
+        const std::string state = ",\"state\":" + std::to_string(i) + ",\"name\":" + jsonString(table.name(i));
+        const double state_measured = reference.has_timing ? reference.stateDuration(i) : nan;
+        const double state_duration = accumulator.state_duration[i];
+        appendComparison(out, run + ",\"kind\":\"state_duration\"" + state, state_measured, state_duration,
+                         (state_measured > 0 || !reference.has_timing)
+                             ? (state_duration - state_measured) / state_measured * 100.0 : 0.0);
+    }
+
+    if (accumulator.transition_costs) {
+        const int n = table.stateCount();
+        for (int from = 0; from < n; from++) {
+            for (int to = 0; to < n; to++) {
+                const std::size_t pair = static_cast<std::size_t>(from) * n + to;
+                const std::uint64_t count = accumulator.pair_transitions[pair];
+                if (count == 0) {
+                    continue;
+                }
+                const double cost = accumulator.transition_costs->cost(pair);
+                out << run << ",\"kind\":\"transition\",\"from\":" << from << ",\"to\":" << to
+                    << ",\"count\":" << count << ",\"cost_j\":" << jsonNumber(cost)
+                    << ",\"energy_j\":" << jsonNumber(cost * static_cast<double>(count)) << "}\n";
+            }
+        }
+    }
+
+    const std::string summary = run + ",\"kind\":\"summary\",\"metric\":";
+    out << summary << "\"Total Energy Error (J)\",\"value\":" << jsonNumber(std::abs(energy - measured_energy))
+        << "}\n";
+    out << summary << "\"Total Energy Error (%)\",\"value\":" << jsonNumber(std::abs(energy_error_pct)) << "}\n";
+    out << summary << "\"Per-State Energy Error Sum (J)\",\"value\":"
+        << jsonNumber(reference.has_energy ? stateEnergyErrorSum(accumulator, reference) : nan) << "}\n";
+    out << summary << "\"Model Status\",\"value\":\""
+        << (!reference.has_energy ? "n/a"
+            : std::abs(energy_error_pct) < VALIDATION_TOLERANCE_PERCENT ? "PASS" : "FAIL") << "\"}\n";
+
+    const std::string text = out.str();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open() || !file.write(text.data(), static_cast<std::streamsize>(text.size()))) {
+        std::cerr << "Error: Could not write validation report " << path << std::endl;
+        return;
+    }
+
+    if (logEnabled(Verbosity::Summary)) {
+        std::cout << "\n✓ Validation report generated: " << path << std::endl;
+    }
+}
+
+void writeValidationReport(const EnergyAccumulator& accumulator, const std::string& path,
+                           const ValidationReference& reference, ReportFormat format) {
+    if (format == ReportFormat::JsonLines) {
+        generateValidationJsonl(accumulator, path, reference);
+    } else {
+        generateValidationCSV(accumulator, path, reference);
+    }
+}
+
+namespace {
+
+std::vector<std::string> splitCsvLine(const std::string& line) {
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    std::string field;
+    while (std::getline(stream, field, ',')) {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+// Value of `key` in a record written by generateValidationJsonl(): the
+// text of a string without its quotes, or the literal of a number.
+std::string jsonField(const std::string& line, const std::string& key) {
+    const std::string tag = "\"" + key + "\":";
+    std::size_t begin = line.find(tag);
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    begin += tag.size();
+    if (begin < line.size() && line[begin] == '"') {
+        const std::size_t end = line.find('"', begin + 1);
+        return line.substr(begin + 1, end == std::string::npos ? std::string::npos : end - begin - 1);
+    }
+    const std::size_t end = line.find_first_of(",}", begin);
+    return line.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+}
+
+double jsonValue(const std::string& text) {
+    return text == "null" ? std::numeric_limits<double>::quiet_NaN() : std::stod(text);
+}
+
+} // namespace
+
+ValidationSummary readValidationSummary(const std::string& path) {
+    std::ifstream csv_file(path);
+    if (!csv_file.is_open()) {
+        throw std::runtime_error("Could not open validation CSV " + path);
+    }
+
+    ValidationSummary summary;
+    bool have_total = false;
+    bool have_state_sum = false;
+    std::string section;
+    std::string line;
+    while (std::getline(csv_file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty() && line[0] == '{') {
+            // JSON Lines report: one record per figure.
+            try {
+                const std::string kind = jsonField(line, "kind");
+                const std::string metric = jsonField(line, "metric");
+                if (kind == "metric" && metric == "Total Energy (J)") {
+                    summary.total_energy = jsonValue(jsonField(line, "model"));
+                    summary.energy_error_percent = jsonValue(jsonField(line, "error_percent"));
+                    have_total = true;
+                } else if (kind == "summary" && metric == "Per-State Energy Error Sum (J)") {
+                    summary.state_energy_error_sum = jsonValue(jsonField(line, "value"));
+                    have_state_sum = true;
+                } else if (kind == "state_energy") {
+                    summary.state_energy_error.push_back(jsonValue(jsonField(line, "error")));
+                }
+            } catch (const std::exception&) {
+                throw std::runtime_error("Malformed validation report " + path + ": " + line);
+            }
+            continue;
+        }
+        if (line.compare(0, 4, "=== ") == 0) {
+            section = line;
+            continue;
+        }
+        std::vector<std::string> fields = splitCsvLine(line);
+        if (fields.empty()) {
+            continue;
+        }
+        try {
+            if (fields[0] == "Total Energy (J)" && fields.size() >= 5) {
+                summary.total_energy = std::stod(fields[2]);
+                summary.energy_error_percent = std::stod(fields[4]);
+                have_total = true;
+            } else if (fields[0] == "Per-State Energy Error Sum (J)" && fields.size() >= 2) {
+                summary.state_energy_error_sum = std::stod(fields[1]);
+                have_state_sum = true;
+            } else if (section == "=== PER-STATE ENERGY (Joules) ===" && fields.size() >= 6 &&
+                       fields[0] != "State") {
+                // The name column may contain commas; the error is 2nd to last.
+                summary.state_energy_error.push_back(std::stod(fields[fields.size() - 2]));
+            }
+        } catch (const std::exception&) {
+            throw std::runtime_error("Malformed validation CSV " + path + ": " + line);
+        }
+    }
+
+    if (!have_total || !have_state_sum) {
+        throw std::runtime_error("Incomplete validation CSV " + path);
+    }
+    return summary;
+}
@@ -0,0 +1,164 @@
+/**
+ * validation.h
+ *
+ * Comparison of model results against the measured ground truth: the
+ * built-in DVCon measurement, a reference file, or metrics collected from
+ * the replayed trace itself.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "power_model.h"
+#include "trace_reader.h"
+
+// Measured ground truth of the built-in test sequence, from analysis
+const double MEASURED_TOTAL_ENERGY = 4262.89;  // Joules
+const double MEASURED_AVG_POWER = 1.0349;      // Watts
+const double MEASURED_DURATION = 4119.0;       // Seconds
+
+// Per-state measured energy (from energy_analysis.csv)
+const double MEASURED_ENERGY_STATE[NUM_STATES] = {
+    3840.36,  // State 0: Office
+    268.66,   // State 1: Not at Work
+    131.64,   // State 2: Remote
+    10.96,    // State 3: Office BT
+    6.90,     // State 4: Remote BT
+    4.37      // State 5: Not at Work BT
+};
+
+// Per-state measured duration (from state_characterization.csv)
+const int MEASURED_DURATION_STATE[NUM_STATES] = {
+    3708,  // State 0: Office
+    263,   // State 1: Not at Work
+    128,   // State 2: Remote
+    10,    // State 3: Office BT
+    6,     // State 4: Remote BT
+    4      // State 5: Not at Work BT
+};
+
+// Largest total energy error that still passes validation.
+const double VALIDATION_TOLERANCE_PERCENT = 1.0;
+
+// Reference metrics a model run is validated against.
+struct ValidationReference {
+    std::string source;                 // shown in the validation output
+    bool has_energy = true;             // false for traces without power
+    bool has_timing = true;             // false without any measurement
+    double total_energy = 0.0;          // J
+    double average_power = 0.0;         // W
+    double duration = 0.0;              // s
+    std::uint64_t transitions = 0;
+    std::vector<double> state_energy;   // J, per state
+    std::vector<double> state_duration; // s, per state
+
+    // Measured values of state `state`, 0 for states without any.
+    double stateEnergy(int state) const;
+    double stateDuration(int state) const;
+
+    // Loads a reference file:
+    //
+    //   State,Energy_J,Duration_s     one row per state
+    //   Transitions,10                optional
+    //
+    // Totals are the sums of the states. Throws std::runtime_error on
+    // malformed files.
+    static ValidationReference load(const std::string& path);
+};
+
+// The MEASURED_* values above.
+const ValidationReference& builtinReference();
+
+// No measurement at all: every measured column of a report is nan.
+const ValidationReference& noReference();
+
+// Passes runs through from another reader and collects their measured
+// energy, durations and transitions as they are replayed, so validating a
+// trace needs no second pass over it.
+class ReferenceRecorder : public TraceReader {
+public:
+    ReferenceRecorder(std::unique_ptr<TraceReader> source, std::string name);
+
+    bool next(TraceRun& run) override;
+
+    // The reader being recorded.
+    TraceReader& source() const { return *inner; }
+
+    // Metrics of the runs read so far. Energies are only known when every
+    // run carried a measured energy.
+    ValidationReference reference() const;
+
+private:
+    std::unique_ptr<TraceReader> inner;
+    ValidationReference collected;
+    int previous_state = -1;
+    std::uint64_t ticks = 0;
+    std::vector<std::uint64_t> state_ticks;
+};
+
+// Sum of absolute per-state energy errors against `reference`, in Joules.
+// States without a measurement count against 0.
+double stateEnergyErrorSum(const EnergyAccumulator& accumulator,
+                           const ValidationReference& reference = builtinReference());
+
+// Console output below is printed at Verbosity::Summary and above.
+
+// Prints the energy charged for the final state and the total.
+void reportFinalEnergy(const EnergyAccumulator& accumulator, double final_energy);
+
+void validateResults(const EnergyAccumulator& accumulator,
+                     const ValidationReference& reference = builtinReference());
+
+const char* const DEFAULT_VALIDATION_CSV = "model_vs_measurement.csv";
+
+// Without reference energies, the measured and error columns of the energy
+// rows are written as nan.
+void generateValidationCSV(const EnergyAccumulator& accumulator,
+                           const std::string& path = DEFAULT_VALIDATION_CSV,
+                           const ValidationReference& reference = builtinReference());
+
+// File formats of the validation report.
+enum class ReportFormat {
+    Csv,       // generateValidationCSV(): === SECTION === blocks
+    JsonLines  // generateValidationJsonl(): one flat record per line
+};
+
+// Parses "csv" or "jsonl"; throws std::runtime_error otherwise.
+ReportFormat parseReportFormat(const std::string& text);
+
+const char* const DEFAULT_VALIDATION_JSONL = "model_vs_measurement.jsonl";
+
+// The figures of generateValidationCSV() as JSON Lines, one object per
+// metric, state, transition pair and summary value:
+//
+//   {"run":"a.jsonl","kind":"metric","metric":"Total Energy (J)","measured":...,"model":...,
+//    "error":...,"error_percent":...}
+//   {"run":"a.jsonl","kind":"state_energy","state":0,"name":"...","measured":...,...}
+//
+// `kind` is metric, state_energy, state_duration, transition or summary.
+// Every record names its `run` (the report path), so reports of a batch
+// can simply be concatenated. Unknown values are null. The report is
+// formatted in memory and written with a single write.
+void generateValidationJsonl(const EnergyAccumulator& accumulator,
+                             const std::string& path = DEFAULT_VALIDATION_JSONL,
+                             const ValidationReference& reference = builtinReference());
+
+// generateValidationCSV() or generateValidationJsonl().
+void writeValidationReport(const EnergyAccumulator& accumulator, const std::string& path,
+                           const ValidationReference& reference, ReportFormat format);
+
+// Headline figures of a report written by writeValidationReport().
+struct ValidationSummary {
+    double total_energy = 0.0;           // J
+    double energy_error_percent = 0.0;
+    double state_energy_error_sum = 0.0; // J
+    std::vector<double> state_energy_error;  // J, per state
+};
+
+// Reads back a validation report in either format; throws
+// std::runtime_error if it cannot be read or lacks the expected figures.
+ValidationSummary readValidationSummary(const std::string& path);
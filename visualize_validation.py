@@ -7,9 +7,10 @@ import pandas as pd
 import matplotlib.pyplot as plt
 import numpy as np
 from pathlib import Path
+import sys
 
 # Configuration
-CSV_FILE = "model_vs_measurement.csv"
+CSV_FILE = sys.argv[1] if len(sys.argv) > 1 else "model_vs_measurement.csv"
 OUTPUT_DIR = Path("validation_plots")
 OUTPUT_DIR.mkdir(exist_ok=True)
 
@@ -42,10 +43,30 @@ def parse_validation_csv(filename):
 
 def parse_section_to_df(section_lines):
     """Convert section lines to DataFrame"""
+    if isinstance(section_lines, pd.DataFrame):
+        return section_lines
     from io import StringIO
     data = '\n'.join(section_lines)
     return pd.read_csv(StringIO(data))
 
+def parse_validation_jsonl(filename):
+    """Load a --output-format jsonl report into the same sections"""
+    records = pd.read_json(filename, lines=True)
+    comparison = {'measured': 'Measured', 'model': 'Model',
+                  'error': 'Error', 'error_percent': 'Error_Percent'}
+    states = {'state': 'State', 'name': 'State_Name', **comparison}
+    
+    def kind(name, columns):
+        rows = records[records['kind'] == name]
+        return rows[list(columns)].rename(columns=columns).reset_index(drop=True)
+    
+    return {
+        'OVERALL METRICS': kind('metric', {'metric': 'Metric', **comparison}),
+        'PER-STATE ENERGY (Joules)': kind('state_energy', states),
+        'PER-STATE DURATION (seconds)': kind('state_duration', states),
+        'SUMMARY STATISTICS': kind('summary', {'metric': 'Metric', 'value': 'Value'}),
+    }
+
 def plot_overall_metrics(df_overall):
     """Plot overall metrics comparison"""
     fig, (ax1, ax2) = plt.subplots(1, 2, figsize=(14, 6))
@@ -330,8 +351,11 @@ def main():
     
     print(f"\nReading: {CSV_FILE}")
     
-    # Parse CSV
-    sections = parse_validation_csv(CSV_FILE)
+    # Parse CSV (or JSON Lines report)
+    if CSV_FILE.endswith('.jsonl'):
+        sections = parse_validation_jsonl(CSV_FILE)
+    else:
+        sections = parse_validation_csv(CSV_FILE)
     
     # Parse each section
     df_overall = parse_section_to_df(sections['OVERALL METRICS'])